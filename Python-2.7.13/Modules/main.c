@@ -299,6 +299,9 @@ static void FatalAppBundleError(char* filename, int sts) {
 
 extern char* OVM_BUNDLE_FILENAME;
 
+// From ovmimport.c.
+extern int OvmImport_Install(const char* ovm_path);
+
 int
 Ovm_Main(int argc, char **argv)
 {
@@ -379,6 +382,16 @@ Ovm_Main(int argc, char **argv)
         Py_InitializeEx(0 /*install_sigs*/, ovm_path);
 
         PySys_SetArgv(argc, argv);
+
+        // Import from the bytecode bundle in front of the .zip, if there is
+        // one.  _OVM_BUNDLE=0 imports everything from the .zip, for
+        // comparison.
+        char* use_bundle = Py_GETENV("_OVM_BUNDLE");
+        if (use_bundle == NULL || strcmp(use_bundle, "0") != 0) {
+          int b = OvmImport_Install(ovm_path);
+          OVM_VERBOSE_LOG("status of OvmImport_Install: %d\n", b);
+        }
+
         // NOTE: This seems like it could be simplified to RunModule(MAIN_NAME,
         // 0), but it caused a SystemError exception from runpy.
         sts = RunMainFromImporter(ovm_path);
@@ -0,0 +1,411 @@
+/* ovmimport.c: Import modules from the bytecode bundle in the OVM binary.
+ *
+ * The app bundle is the OVM binary, then the bundle, then the zip.  The bundle
+ * is written by build/make_bundle.py, which describes the format.
+ *
+ * Compared with zipimport, there's no directory to read into a dict at
+ * startup, and no read() per module.  We mmap() the bundle once, find a module
+ * with a perfect hash, and unmarshal its code straight from the mapping.
+ * Modules that aren't in the bundle fall through to zipimport on sys.path.
+ */
+
+#include "Python.h"
+#include "marshal.h"
+#include "osdefs.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define BUNDLE_VERSION 1
+#define FLAG_PACKAGE 1
+
+#define HEADER_SIZE 20
+#define SLOT_SIZE 20
+#define TRAILER_SIZE 8
+
+/* zip end of central directory record, without a comment */
+#define EOCD_SIZE 22
+#define EOCD_SIGNATURE 0x06054b50
+
+typedef struct {
+    PyObject_HEAD
+    PyObject *archive;  /* path of the binary, for __file__ */
+    const unsigned char *base;
+    Py_ssize_t size;
+    unsigned int num_slots;
+    unsigned int num_buckets;
+    const unsigned char *buckets;
+    const unsigned char *slots;
+} OvmImporter;
+
+static unsigned int
+get_u32(const unsigned char *p)
+{
+    return (unsigned int)p[0] | ((unsigned int)p[1] << 8) |
+           ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+/* Must match Hash() in build/make_bundle.py */
+static unsigned int
+bundle_hash(unsigned int seed, const char *s, size_t len)
+{
+    unsigned int h = 2166136261u ^ (seed * 16777619u);
+    size_t i;
+    for (i = 0; i < len; ++i) {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+/* Returns 0 if the counts and offsets in the bundle all fit in size, and -1
+   otherwise, e.g. for a truncated or corrupt bundle.  find_slot() and
+   load_module() rely on this. */
+static int
+check_bundle(const unsigned char *base, Py_ssize_t size)
+{
+    unsigned int num_slots = get_u32(base + 12);
+    unsigned int num_buckets = get_u32(base + 16);
+    const unsigned char *slot;
+    unsigned int i;
+
+    if (num_slots == 0 || num_buckets == 0)
+        return -1;  /* find_slot() divides by them */
+
+    /* 64-bit sums, so large counts and offsets can't wrap around */
+    if (HEADER_SIZE + 4 * (unsigned PY_LONG_LONG)num_buckets +
+            SLOT_SIZE * (unsigned PY_LONG_LONG)num_slots >
+        (unsigned PY_LONG_LONG)size)
+        return -1;
+
+    slot = base + HEADER_SIZE + 4 * num_buckets;
+    for (i = 0; i < num_slots; ++i, slot += SLOT_SIZE) {
+        unsigned PY_LONG_LONG name_end =
+            (unsigned PY_LONG_LONG)get_u32(slot) + get_u32(slot + 4);
+        unsigned PY_LONG_LONG code_end =
+            (unsigned PY_LONG_LONG)get_u32(slot + 8) + get_u32(slot + 12);
+        if (name_end > (unsigned PY_LONG_LONG)size ||
+            code_end > (unsigned PY_LONG_LONG)size)
+            return -1;
+    }
+    return 0;
+}
+
+/* Returns the slot for fullname, or NULL if it's not in the bundle. */
+static const unsigned char *
+find_slot(OvmImporter *self, const char *fullname)
+{
+    size_t len = strlen(fullname);
+    unsigned int b = bundle_hash(0, fullname, len) % self->num_buckets;
+    unsigned int d = get_u32(self->buckets + 4 * b);
+    unsigned int s = bundle_hash(d, fullname, len) % self->num_slots;
+    const unsigned char *slot = self->slots + SLOT_SIZE * s;
+
+    unsigned int name_off = get_u32(slot);
+    unsigned int name_len = get_u32(slot + 4);
+    if (name_len != len ||
+        memcmp(self->base + name_off, fullname, len) != 0) {
+        return NULL;
+    }
+    return slot;
+}
+
+/* Same __file__ as zipimport, e.g. _bin/oil.ovm/core/util.pyc */
+static PyObject *
+get_modpath(OvmImporter *self, const char *fullname, int is_package)
+{
+    PyObject *modpath;
+    char *p;
+    size_t i, n = strlen(fullname);
+
+    modpath = PyString_FromFormat("%s%c%s%s",
+                                  PyString_AsString(self->archive), SEP,
+                                  fullname,
+                                  is_package ? "/__init__.pyc" : ".pyc");
+    if (modpath == NULL)
+        return NULL;
+
+    /* core.util -> core/util.  The string isn't shared yet. */
+    p = PyString_AS_STRING(modpath) + PyString_GET_SIZE(self->archive) + 1;
+    for (i = 0; i < n; ++i) {
+        if (p[i] == '.')
+            p[i] = SEP;
+    }
+    return modpath;
+}
+
+static PyObject *
+ovmimporter_find_module(PyObject *obj, PyObject *args)
+{
+    OvmImporter *self = (OvmImporter *)obj;
+    PyObject *path = NULL;
+    char *fullname;
+
+    if (!PyArg_ParseTuple(args, "s|O:ovmimporter.find_module",
+                          &fullname, &path))
+        return NULL;
+
+    if (find_slot(self, fullname) == NULL) {
+        Py_INCREF(Py_None);
+        return Py_None;
+    }
+    Py_INCREF(self);
+    return (PyObject *)self;
+}
+
+static PyObject *
+ovmimporter_load_module(PyObject *obj, PyObject *args)
+{
+    OvmImporter *self = (OvmImporter *)obj;
+    PyObject *code, *mod, *dict, *modpath;
+    const unsigned char *slot;
+    unsigned int code_off, code_len, flags;
+    char *fullname;
+
+    if (!PyArg_ParseTuple(args, "s:ovmimporter.load_module", &fullname))
+        return NULL;
+
+    slot = find_slot(self, fullname);
+    if (slot == NULL) {
+        PyErr_Format(PyExc_ImportError, "can't find module '%.200s'",
+                     fullname);
+        return NULL;
+    }
+    code_off = get_u32(slot + 8);  /* in range, see check_bundle() */
+    code_len = get_u32(slot + 12);
+    flags = get_u32(slot + 16);
+
+    modpath = get_modpath(self, fullname, flags & FLAG_PACKAGE);
+    if (modpath == NULL)
+        return NULL;
+
+    code = PyMarshal_ReadObjectFromString((char *)self->base + code_off,
+                                          code_len);
+    if (code == NULL) {
+        Py_DECREF(modpath);
+        return NULL;
+    }
+    if (!PyCode_Check(code)) {
+        PyErr_Format(PyExc_TypeError,
+                     "compiled module %.200s is not a code object",
+                     PyString_AsString(modpath));
+        goto error;
+    }
+
+    mod = PyImport_AddModule(fullname);  /* borrowed */
+    if (mod == NULL)
+        goto error;
+    dict = PyModule_GetDict(mod);
+
+    if (PyDict_SetItemString(dict, "__loader__", (PyObject *)self) != 0)
+        goto error;
+
+    if (flags & FLAG_PACKAGE) {
+        /* add __path__ before the code runs, like zipimport.  Submodules are
+           found through sys.meta_path, but this also makes them visible to
+           zipimport if they're not in the bundle. */
+        PyObject *pkgpath;
+        int err;
+        Py_ssize_t n = PyString_GET_SIZE(modpath) - 13;  /* /__init__.pyc */
+        PyObject *fullpath = PyString_FromStringAndSize(
+            PyString_AS_STRING(modpath), n);
+        if (fullpath == NULL)
+            goto error;
+        pkgpath = Py_BuildValue("[N]", fullpath);
+        if (pkgpath == NULL)
+            goto error;
+        err = PyDict_SetItemString(dict, "__path__", pkgpath);
+        Py_DECREF(pkgpath);
+        if (err != 0)
+            goto error;
+    }
+
+    mod = PyImport_ExecCodeModuleEx(fullname, code,
+                                    PyString_AsString(modpath));
+    if (Py_VerboseFlag)
+        PySys_WriteStderr("import %s # loaded from OVM bundle %s\n",
+                          fullname, PyString_AsString(modpath));
+    Py_DECREF(code);
+    Py_DECREF(modpath);
+    return mod;
+error:
+    Py_DECREF(code);
+    Py_DECREF(modpath);
+    return NULL;
+}
+
+static PyObject *
+ovmimporter_repr(OvmImporter *self)
+{
+    return PyString_FromFormat("<ovmimporter object \"%.300s\">",
+                               PyString_AsString(self->archive));
+}
+
+static void
+ovmimporter_dealloc(OvmImporter *self)
+{
+    /* The mapping lives as long as the process. */
+    Py_XDECREF(self->archive);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyMethodDef ovmimporter_methods[] = {
+    {"find_module", ovmimporter_find_module, METH_VARARGS, NULL},
+    {"load_module", ovmimporter_load_module, METH_VARARGS, NULL},
+    {NULL, NULL}  /* sentinel */
+};
+
+static PyTypeObject OvmImporter_Type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "ovmimporter",
+    sizeof(OvmImporter),
+    0,                                          /* tp_itemsize */
+    (destructor)ovmimporter_dealloc,            /* tp_dealloc */
+    0,                                          /* tp_print */
+    0,                                          /* tp_getattr */
+    0,                                          /* tp_setattr */
+    0,                                          /* tp_compare */
+    (reprfunc)ovmimporter_repr,                 /* tp_repr */
+    0,                                          /* tp_as_number */
+    0,                                          /* tp_as_sequence */
+    0,                                          /* tp_as_mapping */
+    0,                                          /* tp_hash */
+    0,                                          /* tp_call */
+    0,                                          /* tp_str */
+    PyObject_GenericGetAttr,                    /* tp_getattro */
+    0,                                          /* tp_setattro */
+    0,                                          /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                         /* tp_flags */
+    0,                                          /* tp_doc */
+    0,                                          /* tp_traverse */
+    0,                                          /* tp_clear */
+    0,                                          /* tp_richcompare */
+    0,                                          /* tp_weaklistoffset */
+    0,                                          /* tp_iter */
+    0,                                          /* tp_iternext */
+    ovmimporter_methods,                        /* tp_methods */
+};
+
+/* Map the bundle in front of the zip at the end of the file.  Returns the
+   start of the bundle and sets *size, or returns NULL. */
+static const unsigned char *
+map_bundle(int fd, Py_ssize_t *size)
+{
+    struct stat st;
+    unsigned char eocd[EOCD_SIZE];
+    unsigned char trailer[TRAILER_SIZE];
+    off_t zip_start, bundle_start, page_start;
+    unsigned int dir_size, dir_offset, bundle_size;
+    long page_size;
+    void *m;
+
+    if (fstat(fd, &st) < 0 || st.st_size < EOCD_SIZE + TRAILER_SIZE)
+        return NULL;
+    if (pread(fd, eocd, EOCD_SIZE, st.st_size - EOCD_SIZE) != EOCD_SIZE ||
+        get_u32(eocd) != EOCD_SIGNATURE)
+        return NULL;
+    dir_size = get_u32(eocd + 12);
+    dir_offset = get_u32(eocd + 16);
+    zip_start = st.st_size - EOCD_SIZE - dir_size - dir_offset;
+    if (zip_start < TRAILER_SIZE)
+        return NULL;
+
+    if (pread(fd, trailer, TRAILER_SIZE, zip_start - TRAILER_SIZE) !=
+            TRAILER_SIZE ||
+        memcmp(trailer + 4, "OVMB", 4) != 0)
+        return NULL;
+    bundle_size = get_u32(trailer);
+    if (bundle_size < HEADER_SIZE + TRAILER_SIZE || (off_t)bundle_size > zip_start)
+        return NULL;
+    bundle_start = zip_start - bundle_size;
+
+    /* mmap() offsets must be page-aligned */
+    page_size = sysconf(_SC_PAGESIZE);
+    page_start = bundle_start - bundle_start % page_size;
+    m = mmap(NULL, zip_start - page_start, PROT_READ, MAP_PRIVATE, fd,
+             page_start);
+    if (m == MAP_FAILED)
+        return NULL;
+
+    *size = bundle_size;
+    return (const unsigned char *)m + (bundle_start - page_start);
+}
+
+/* Put an importer for the bundle in ovm_path at the front of sys.meta_path.
+ *
+ * Returns 0 on success, and -1 if there's no usable bundle, in which case
+ * everything is imported from the zip as before.  Doesn't set a Python
+ * exception.
+ */
+int
+OvmImport_Install(const char *ovm_path)
+{
+    const unsigned char *base;
+    Py_ssize_t size;
+    OvmImporter *self;
+    PyObject *meta_path;
+    int fd;
+
+    fd = open(ovm_path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    base = map_bundle(fd, &size);
+    close(fd);  /* the mapping stays valid */
+    if (base == NULL)
+        return -1;
+
+    /* Bytecode for another interpreter version, e.g. a stale bundle */
+    if (memcmp(base, "OVMB", 4) != 0 ||
+        get_u32(base + 4) != BUNDLE_VERSION ||
+        get_u32(base + 8) != (unsigned int)PyImport_GetMagicNumber()) {
+        if (Py_VerboseFlag)
+            PySys_WriteStderr("# ignoring OVM bundle in %s\n", ovm_path);
+        return -1;
+    }
+    if (check_bundle(base, size) < 0) {
+        if (Py_VerboseFlag)
+            PySys_WriteStderr("# ignoring corrupt OVM bundle in %s\n",
+                              ovm_path);
+        return -1;
+    }
+
+    if (PyType_Ready(&OvmImporter_Type) < 0)
+        goto error;
+    self = PyObject_New(OvmImporter, &OvmImporter_Type);
+    if (self == NULL)
+        goto error;
+    self->archive = PyString_FromString(ovm_path);
+    if (self->archive == NULL) {
+        Py_DECREF(self);
+        goto error;
+    }
+    self->base = base;
+    self->size = size;
+    self->num_slots = get_u32(base + 12);
+    self->num_buckets = get_u32(base + 16);
+    self->buckets = base + HEADER_SIZE;
+    self->slots = self->buckets + 4 * self->num_buckets;
+
+    meta_path = PySys_GetObject("meta_path");  /* borrowed */
+    if (meta_path == NULL || !PyList_Check(meta_path) ||
+        PyList_Insert(meta_path, 0, (PyObject *)self) < 0) {
+        Py_DECREF(self);
+        goto error;
+    }
+    if (Py_VerboseFlag)
+        PySys_WriteStderr("# OVM bundle in %s has %u slots\n", ovm_path,
+                          self->num_slots);
+    Py_DECREF(self);  /* sys.meta_path owns it */
+    return 0;
+
+error:
+    PyErr_Clear();
+    return -1;
+}
@@ -385,6 +385,9 @@ class Check(_VisitorBase):
 _PRIMITIVE_TYPES = [
     'string', 'int', 'float', 'bool',
 
+    # An int that's 2 bytes in C++, for packing small fields
+    'uint16',
+
     # 'any' is used:
     # - for value.Obj in the the Oil expression evaluator.  We're not doing any
     #   dynamic or static checking now.
@@ -57,6 +57,7 @@ _PRIMITIVES = {
     'float': 'double',
     'bool': 'bool',
     'any': 'void*',
+    'uint16': 'uint16_t',  # for packing small fields; int in Python
     # TODO: frontend/syntax.asdl should properly import id enum instead of
     # hard-coding it here.
     'id': 'Id_t',
@@ -115,6 +116,31 @@ def _IsManagedType(typ):
   return _GetCppType(typ).endswith('*')
 
 
+# Size in bytes of each non-pointer C++ field type.  Simple sums are enums,
+# which are int sized.
+_FIELD_SIZES = {
+    'double': 8,
+    'uint16_t': 2,
+    'bool': 1,
+}
+
+
+def _FieldSize(typ):
+  c_type = _GetCppType(typ)
+  if c_type.endswith('*'):
+    return 8
+  return _FIELD_SIZES.get(c_type, 4)
+
+
+def _MemberOrder(all_fields):
+  """Order the C++ members from largest to smallest, so there's no padding
+  between them.  The order of constructor params and pretty printing doesn't
+  change.  field_mask() uses offsetof(), so it follows the new order.
+  """
+  # sorted() is stable, so fields of the same size keep their schema order
+  return sorted(all_fields, key=lambda f: -_FieldSize(f.typ))
+
+
 def _DefaultValue(typ):
   type_name = typ.name
 
@@ -134,6 +160,8 @@ def _DefaultValue(typ):
 
   elif type_name == 'int':
     default = '-1'
+  elif type_name == 'uint16':
+    default = '0'
   elif type_name == 'id':  # hard-coded HACK
     default = '-1'
   elif type_name == 'bool':
@@ -164,7 +192,7 @@ def _HNodeExpr(abbrev, typ, var_name):
   if type_name == 'bool':
     code_str = "Alloc<hnode__Leaf>(%s ? runtime::TRUE_STR : runtime::FALSE_STR, color_e::OtherConst)" % var_name
 
-  elif type_name == 'int':
+  elif type_name in ('int', 'uint16'):
     code_str = 'Alloc<hnode__Leaf>(str(%s), color_e::OtherConst)' % var_name
 
   elif type_name == 'float':
@@ -215,7 +243,11 @@ class ClassDefVisitor(visitor.AsdlVisitor):
   def _EmitEnum(self, sum, sum_name, depth, strong=False, is_simple=False):
     enum = []
     int_to_type = {}
-    for i, variant in enumerate(sum.types):
+    # Number the sum's own variants 1, 2, 3, ... without gaps for the shared
+    # types, which have tags starting at 64.  Dense ranges let the C++
+    # compiler turn tagswitch into a small jump table.
+    own_tag = 0
+    for variant in sum.types:
       if variant.shared_type:  # Copied from gen_python.py
         tag_num = self._shared_type_tags[variant.shared_type]
         # e.g. double_quoted may have base types expr_t, word_part_t
@@ -229,7 +261,8 @@ class ClassDefVisitor(visitor.AsdlVisitor):
           bases.append(base_class)
         type_str = variant.shared_type
       else:
-        tag_num = i + 1
+        own_tag += 1
+        tag_num = own_tag
         type_str = '%s__%s' % (sum_name, variant.name)
       int_to_type[tag_num] = type_str
       enum.append((variant.name, tag_num))  # zero is reserved
@@ -365,10 +398,11 @@ class ClassDefVisitor(visitor.AsdlVisitor):
     self.Emit(" public:", depth)
 
     all_fields = ast_node.fields + attributes
+    members = _MemberOrder(all_fields)
 
     bits = []
     if all_fields:
-      for field in all_fields:
+      for field in members:
         if _IsManagedType(field.typ):
           bits.append('maskbit(offsetof(%s, %s))' % (class_name, field.name))
 
@@ -390,7 +424,7 @@ class ClassDefVisitor(visitor.AsdlVisitor):
     # types with no fields.
     if ast_node.fields:
       default_inits = [header_init]
-      for field in all_fields:
+      for field in members:
         default = _DefaultValue(field.typ)
         default_inits.append('%s(%s)' % (field.name, default))
 
@@ -405,9 +439,12 @@ class ClassDefVisitor(visitor.AsdlVisitor):
 
     for f in ast_node.fields:
       params.append('%s %s' % (_GetCppType(f.typ), f.name))
-      inits.append('%s(%s)' % (f.name, f.name))
-    for f in attributes:  # spids are initialized separately
-      inits.append('%s(%s)' % (f.name, _DefaultValue(f.typ)))
+    # Initialize in member order, to match the declarations
+    for f in members:
+      if f in attributes:  # spids are initialized separately
+        inits.append('%s(%s)' % (f.name, _DefaultValue(f.typ)))
+      else:
+        inits.append('%s(%s)' % (f.name, f.name))
 
     # Define constructor with N args
     self.Emit('  %s(%s)' % (class_name, ', '.join(params)), depth)
@@ -424,7 +461,7 @@ class ClassDefVisitor(visitor.AsdlVisitor):
     # Members
     #
     self.Emit('  GC_OBJ(header_);')
-    for field in all_fields:
+    for field in members:
       self.Emit("  %s %s;" % (_GetCppType(field.typ), field.name))
 
     if bits:
@@ -220,6 +220,32 @@ TEST literal_test() {
   PASS();
 }
 
+using typed_demo_asdl::packed;
+
+TEST layout_test() {
+  // header, 2 pointers, int, uint16, 2 bools.  In schema order it would be 48
+  // bytes because of padding.
+  ASSERT_EQ_FMT(32, static_cast<int>(sizeof(packed)), "%d");
+  ASSERT_EQ_FMT(2, static_cast<int>(sizeof(packed::small)), "%d");
+
+  // The GC still finds both pointers
+  uint16_t mask = packed::field_mask();
+  ASSERT_EQ(maskbit(offsetof(packed, s)) | maskbit(offsetof(packed, nums)),
+            mask);
+
+  // Constructor params are in schema order
+  auto nums = NewList<int>();
+  auto p = Alloc<packed>(true, StrFromC("s"), 65535, -1, false, nums);
+  ASSERT_EQ(true, p->b1);
+  ASSERT(str_equals0("s", p->s));
+  ASSERT_EQ_FMT(65535, p->small, "%d");
+  ASSERT_EQ_FMT(-1, p->i, "%d");
+  ASSERT_EQ(false, p->b2);
+  ASSERT_EQ(nums, p->nums);
+
+  PASS();
+}
+
 GREATEST_MAIN_DEFS();
 
 int main(int argc, char** argv) {
@@ -232,6 +258,7 @@ int main(int argc, char** argv) {
   RUN_TEST(pretty_print_test);
   RUN_TEST(maps_test);
   RUN_TEST(literal_test);
+  RUN_TEST(layout_test);
 
   GREATEST_MAIN_END(); /* display results */
   return 0;
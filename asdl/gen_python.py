@@ -19,6 +19,7 @@ _PRIMITIVES = {
     'float': 'float',
     'bool': 'bool',
     'any': 'Any',
+    'uint16': 'int',  # packed in C++
     # TODO: frontend/syntax.asdl should properly import id enum instead of
     # hard-coding it here.
     'id': 'Id_t',
@@ -78,7 +79,7 @@ def _DefaultValue(typ):
     else:
       default = 'None'
 
-  elif type_name == 'int':
+  elif type_name in ('int', 'uint16'):
     #default = '-1'
     pass
 
@@ -114,7 +115,7 @@ def _HNodeExpr(abbrev, typ, var_name):
   if type_name == 'bool':
     code_str = "hnode.Leaf('T' if %s else 'F', color_e.OtherConst)" % var_name
 
-  elif type_name == 'int':
+  elif type_name in ('int', 'uint16'):
     code_str = 'hnode.Leaf(str(%s), color_e.OtherConst)' % var_name
 
   elif type_name == 'float':
@@ -412,7 +413,8 @@ class GenMyPyVisitor(visitor.AsdlVisitor):
     # enum for the tag
     self.Emit('class %s_e(object):' % sum_name, depth)
 
-    for i, variant in enumerate(sum.types):
+    own_tag = 0  # dense, like asdl/gen_cpp.py
+    for variant in sum.types:
       if variant.shared_type:
         tag_num = self._shared_type_tags[variant.shared_type]
         # e.g. double_quoted may have base types expr_t, word_part_t
@@ -426,7 +428,8 @@ class GenMyPyVisitor(visitor.AsdlVisitor):
         else:
           bases.append(base_class)
       else:
-        tag_num = i + 1
+        own_tag += 1
+        tag_num = own_tag
       self.Emit('  %s = %d' % (variant.name, tag_num), depth)
       tag_str = '%s.%s' % (sum_name, variant.name)
       int_to_str[tag_num] = tag_str
@@ -485,16 +488,18 @@ class GenMyPyVisitor(visitor.AsdlVisitor):
     depth = self.current_depth
     self.Emit('')
 
-    for i, variant in enumerate(sum.types):
+    own_tag = 0
+    for variant in sum.types:
       if variant.shared_type:
         # Don't generate a class.
         pass
       else:
+        own_tag += 1
         # Use fully-qualified name, so we can have osh_cmd.Simple and
         # oil_cmd.Simple.
         fq_name = '%s__%s' % (sum_name, variant.name)
         self._GenClass(variant, sum.attributes, fq_name, (sum_name + '_t',),
-                       depth, i+1)
+                       depth, own_tag)
 
     # Emit a namespace
     self.Emit('class %s(object):' % sum_name, depth)
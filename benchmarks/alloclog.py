@@ -1,12 +1,19 @@
 #!/usr/bin/env python2
 """
-alloclog.py - Parse output of -D ALLOC_LOG build
+alloclog.py - Summarize the output of the alloclog variant
+
+Usage:
+  benchmarks/alloclog.py types TYPES_TSV     # count and bytes by type
+  benchmarks/alloclog.py sizes TYPES_TSV     # cumulative obj_len histogram
+  benchmarks/alloclog.py sites SITES_TSV [N] # top call sites by count
+
+TYPES_TSV is written to $OIL_ALLOC_LOG, and SITES_TSV to $OIL_ALLOC_LOG_SITES.
+See mycpp/alloc_log.h.
 """
 from __future__ import print_function
 
-import sys
-
 import collections
+import sys
 
 
 def log(msg, *args):
@@ -15,22 +22,78 @@ def log(msg, *args):
   print(msg, file=sys.stderr)
 
 
-def main(argv):
-  d = collections.defaultdict(list)
-  for i, line in enumerate(sys.stdin):
-    address, length = line.split()
-    count = int(length)
-    d[address].append(count)
+def ReadTsv(path):
+  with open(path) as f:
+    header = f.readline().rstrip('\n').split('\t')
+    for line in f:
+      yield dict(zip(header, line.rstrip('\n').split('\t')))
+
+
+def Types(path):
+  counts = collections.Counter()
+  num_bytes = collections.Counter()
+  tags = {}
+  for row in ReadTsv(path):
+    name = row['type_name']
+    n = int(row['count'])
+    counts[name] += n
+    num_bytes[name] += n * int(row['obj_len'])
+    tags[name] = row['type_tag']
+
+  total_count = sum(counts.values())
+  total_bytes = sum(num_bytes.values())
+  log('%d allocations, %d bytes', total_count, total_bytes)
+
+  print('\t'.join(['type_name', 'type_tag', 'count', 'bytes', 'count_percent',
+                   'bytes_percent', 'mean_obj_len']))
+  for name, n in counts.most_common():
+    b = num_bytes[name]
+    print('%s\t%s\t%d\t%d\t%.2f\t%.2f\t%.1f' % (
+        name, tags[name], n, b, n * 100.0 / total_count,
+        b * 100.0 / total_bytes, float(b) / n))
 
-  log('Read %d items', i)
 
-  # Find the ones with the most
-  longest = sorted(d, key=lambda addr: len(d[addr]))
+def Sizes(path):
+  counts = collections.Counter()
+  for row in ReadTsv(path):
+    counts[int(row['obj_len'])] += int(row['count'])
+
+  total = sum(counts.values())
+
+  print('\t'.join(['obj_len', 'count', 'n_less_than', 'percent']))
+  n_less_than = 0
+  for obj_len in sorted(counts):
+    n = counts[obj_len]
+    n_less_than += n
+    print('%d\t%d\t%d\t%.2f' % (obj_len, n, n_less_than,
+                                n_less_than * 100.0 / total))
+
+
+def Sites(path, limit):
+  rows = list(ReadTsv(path))
+  rows.sort(key=lambda row: int(row['count']), reverse=True)
+
+  print('\t'.join(['call_site', 'type_name', 'count', 'bytes']))
+  for row in rows[:limit]:
+    print('\t'.join(row[k] for k in ('call_site', 'type_name', 'count', 'bytes')))
+
+
+def main(argv):
+  try:
+    action = argv[1]
+    path = argv[2]
+  except IndexError:
+    raise RuntimeError('Usage: alloclog.py (types|sizes|sites) TSV')
 
-  for addr in longest:
-    lengths = d[addr]
-    #print('%s %s' % (addr, lengths))
-    print('%s %d %d' % (addr, len(lengths), max(lengths)))
+  if action == 'types':
+    Types(path)
+  elif action == 'sizes':
+    Sizes(path)
+  elif action == 'sites':
+    limit = int(argv[3]) if len(argv) > 3 else 20
+    Sites(path, limit)
+  else:
+    raise RuntimeError('Invalid action %r' % action)
 
 
 if __name__ == '__main__':
@@ -1,11 +1,12 @@
 #!/usr/bin/env bash
 #
 # Usage:
-#   benchmarks/sizelog.sh <function name>
+#   benchmarks/alloclog.sh <function name>
 #
 # Example:
-#   ninja _test/oils_cpp.alloclog
-#   benchmarks/alloclog.sh alloc-hist
+#   ninja _bin/cxx-alloclog/osh
+#   benchmarks/alloclog.sh parse configure
+#   benchmarks/alloclog.sh types parse.configure
 
 set -o nounset
 set -o pipefail
@@ -13,43 +14,63 @@ set -o errexit
 
 source benchmarks/common.sh
 
+# The alloclog variant writes exact histograms of allocations by type and call
+# site.  See mycpp/alloc_log.h.
+readonly ALLOCLOG_BIN=_bin/cxx-alloclog/osh
+readonly BASE_DIR=_tmp/alloclog
+
+run() {
+  local name=$1
+  shift
+
+  mkdir -p $BASE_DIR
+  OIL_ALLOC_LOG=$BASE_DIR/$name.types.tsv \
+  OIL_ALLOC_LOG_SITES=$BASE_DIR/$name.sites.tsv \
+    $ALLOCLOG_BIN "$@"
+
+  echo "Wrote $BASE_DIR/$name.{types,sites}.tsv"
+}
+
 # ~191K total allocations for configure
 # ~2.1M for abuild
 # ~15.7M for benchmarks/testdata/configure
 # ~42.8M for benchmarks/testdata/configure-coreutils
-alloc-hist() {
-  local prog=${1:-configure}
-  _bin/oils_cpp.alloclog -n $prog | egrep '^new|^malloc' | hist
-  #_bin/oils_cpp.sizelog -n $prog | egrep '^new|^malloc' | hist
+parse() {
+  local file=${1:-configure}
+  run parse.$(basename $file) --ast-format none -n $file
 }
 
-list-lengths() {
-  ### Show the address of each list, its length, and its maximum element
-  local prog=${1:-configure}
-  _bin/oils_cpp.alloclog -n $prog | egrep '^0x' | benchmarks/alloclog.py
+execute() {
+  run ex.compute-fib benchmarks/compute/fib.sh 1000 44
 }
 
-# Hm this shows that almost all lists have 1-3 elements.
-# Are these the spid lists?
-#
-# Should we then do small size optimization?
-# TODO: Where are they allocated from?  Can uftrace answer that?
-#
-#   count listlength
-#     734 6
-#    1835 5
-#   10718 4
-#   66861 2
-#   67841 3
-#  179893 1
-#
-# 329628 _tmp/lists.txt
+types() {
+  ### Count and bytes by type, e.g. Str, List<Str*>, syntax_asdl::Token
+  local name=${1:-parse.configure}
+  benchmarks/alloclog.py types $BASE_DIR/$name.types.tsv
+}
 
+sizes() {
+  ### Cumulative histogram of object sizes
+  local name=${1:-parse.configure}
+  benchmarks/alloclog.py sizes $BASE_DIR/$name.types.tsv
+}
 
-length-hist() {
-  list-lengths "$@" | awk '{print $2}' > _tmp/lists.txt
-  cat _tmp/lists.txt | hist
-  wc -l _tmp/lists.txt
+sites() {
+  ### Top call sites, with source locations
+  local name=${1:-parse.configure}
+  local n=${2:-20}
+
+  benchmarks/alloclog.py sites $BASE_DIR/$name.sites.tsv $n |
+  while IFS=$'\t' read -r site type_name count bytes; do
+    if test "$site" = call_site; then
+      echo -e "location\ttype_name\tcount\tbytes"
+      continue
+    fi
+    local loc
+    loc=$(addr2line -f -C -i -e $ALLOCLOG_BIN $site | head -n 2 | tr '\n' ' ')
+    echo -e "$loc\t$type_name\t$count\t$bytes"
+  done
 }
 
 build-variants() {
@@ -126,6 +126,19 @@ array_ref-tasks() {
 #EOF
 }
 
+# Copying arrays.  "$@" is passed through functions, so every level makes a
+# new argv.
+array_pass-tasks() {
+  local provenance=$1
+
+  cat $provenance | filter-provenance bash "$OSH_CPP_REGEX" |
+  while read fields; do
+    for n in 10000 100000; do
+      echo "array_pass $n _" | xargs -n 3 -- echo "$fields"
+    done
+  done
+}
+
 palindrome-tasks() {
   local provenance=$1
 
@@ -219,6 +232,16 @@ array_ref-one() {
   seq $n | shuf | $runtime benchmarks/compute/array_ref.$(ext $runtime) $mode
 }
 
+array_pass-one() {
+  ### Run one array_pass task (arrays, function calls)
+
+  local name=${1:-array_pass}
+  local runtime=$2
+  local n=${3:-10000}
+
+  $runtime benchmarks/compute/array_pass.$(ext $runtime) $n
+}
+
 palindrome-one() {
   ### Run one palindrome task (strings)
 
@@ -257,6 +280,8 @@ bubble_sort-all() { task-all bubble_sort "$@"; }
 # Array that is not quadratic
 array_ref-all() { task-all array_ref "$@"; }
 
+array_pass-all() { task-all array_pass "$@"; }
+
 # Hm osh is a little slower here
 palindrome-all() { task-all palindrome "$@"; }
 
@@ -404,6 +429,8 @@ measure() {
   # array_ref takes too long to show quadratic behavior, and that's only
   # necessary on 1 machine.  I think I will make a separate blog post,
   # if anything.
+  #
+  # array_pass isn't in the report yet.  Run it with array_pass-all.
 
   maybe-tree $out_dir
 }
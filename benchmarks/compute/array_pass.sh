@@ -0,0 +1,39 @@
+#!/usr/bin/env bash
+#
+# Pass a large array through 5 levels of functions.  Each level expands
+# "$@" or "${a[@]}" into a new argv, and the last one copies it into a local
+# array.
+#
+# Usage:
+#   ./array_pass.sh N
+
+set -o nounset
+set -o pipefail
+set -o errexit
+
+level5() {
+  local -a copy=("$@")
+  echo "${#copy[@]} ${copy[0]} ${copy[-1]}"
+}
+
+level4() { level5 "$@"; }
+level3() { level4 "$@"; }
+level2() { level3 "$@"; }
+
+level1() {
+  local -a copy=("${array[@]}")
+  level2 "${copy[@]}"
+}
+
+main() {
+  local n=$1
+
+  mapfile -t array < <(seq $n)
+
+  local i
+  for (( i = 0; i < 10; ++i )); do
+    level1
+  done
+}
+
+main "$@"
@@ -109,6 +109,9 @@ print-tasks() {
     # good GC stats
     "_bin/cxx-opt/osh${TAB}mut+alloc+free+gc"
     "_bin/cxx-opt/osh${TAB}mut+alloc+free+gc+exit"
+
+    # copying collector, with the same GC points and threshold policy
+    "_bin/cxx-cheney/osh${TAB}mut+alloc+free+gc"
   )
 
   local id=0
@@ -125,6 +128,12 @@ print-tasks() {
         "ex.bashcomp-parse-help${TAB}zsh"*)
           continue
           ;;
+        # The Cheney heap can only collect where no method is on the stack,
+        # since 'this' isn't rooted.  The parser's GC points are like that,
+        # but CommandEvaluator's aren't.
+        "ex."*"${TAB}_bin/cxx-cheney/osh"*)
+          continue
+          ;;
       esac
 
       local join_id="gc-$id"
@@ -197,7 +206,7 @@ run-tasks() {
     # Wrap in a command that writes one row of a TSV
     local -a time_argv=(
       time-tsv -o $tsv_out --append 
-      --rusage
+      --rusage --perf
       --field "$join_id" --field "$task" --field "$sh_path" --field "$shell_runtime_opts"
       -- "${argv[@]}"
     )
@@ -320,14 +329,14 @@ more-variants() {
 }
 
 measure-all() {
-  ninja _bin/cxx-bumpleak/osh _bin/cxx-opt/osh
+  ninja _bin/cxx-bumpleak/osh _bin/cxx-opt/osh _bin/cxx-cheney/osh
 
   local tsv_out=${1:-$BASE_DIR/raw/times.tsv}
   mkdir -p $(dirname $tsv_out)
 
   # Make the header
   time-tsv -o $tsv_out --print-header \
-    --rusage --field join_id --field task --field sh_path --field shell_runtime_opts
+    --rusage --perf --field join_id --field task --field sh_path --field shell_runtime_opts
 
   time print-tasks | run-tasks $tsv_out
 
@@ -414,6 +423,22 @@ EOF
 
   cmark << 'EOF'
 - Underlying data: [stage2/times.tsv](stage2/times.tsv)
+EOF
+
+  cmark << 'EOF'
+### Hardware Counters
+
+From `perf_event_open()`, in user space, for the OSH variants.  IPC is
+instructions per cycle, and MPKI is misses per 1000 instructions.  Deltas are
+relative to `osh-native` with `mut+alloc+free+gc`.  They're NA on machines
+that don't allow counters.
+
+EOF
+
+  tsv2html $in_dir/counters.tsv
+
+  cmark << 'EOF'
+- Underlying data: [stage2/counters.tsv](stage2/counters.tsv)
 EOF
 
   cat <<EOF
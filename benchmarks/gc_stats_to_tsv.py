@@ -11,7 +11,8 @@ import os
 import sys
 
 def main(argv):
-  header = None
+  header = []
+  rows = []
 
   for path in argv[1:]:
     filename = os.path.basename(path)
@@ -31,15 +32,16 @@ def main(argv):
         value = value.strip()
         d[key] = value
 
-    if header is None:
-      header = d.keys()
-      print("\t".join(header))
-    else:
-      # Ensure the order
-      assert d.keys() == header
+    # Different heaps (e.g. mark-sweep and Cheney) print different stats, so
+    # the header is the union of the keys
+    for key in d:
+      if key not in header:
+        header.append(key)
+    rows.append(d)
 
-    row = d.values()
-    print("\t".join(row))
+  print("\t".join(header))
+  for d in rows:
+    print("\t".join(d.get(key, 'NA') for key in header))
 
 
 if __name__ == '__main__':
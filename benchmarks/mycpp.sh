@@ -90,6 +90,71 @@ fi
 EOF
 }
 
+print-bench-report() {
+  local in_dir=$1
+
+  benchmark-html-head 'mycpp Runtime Micro-Benchmarks'
+
+  cat <<EOF
+  <body class="width60">
+    <p id="home-link">
+      <a href="/">oilshell.org</a>
+    </p>
+EOF
+  cmark <<EOF
+
+## mycpp Runtime Micro-Benchmarks
+
+Source code: [oil/mycpp/bench](https://github.com/oilshell/oil/tree/master/mycpp/bench)
+
+### Nanoseconds per Op (median)
+
+EOF
+
+  tsv2html $in_dir/ns_per_op.tsv
+
+  cmark <<EOF
+### Allocations per Op
+
+EOF
+
+  tsv2html $in_dir/allocs_per_op.tsv
+
+  cmark <<EOF
+### Details
+
+EOF
+
+  tsv2html $in_dir/details.tsv
+
+  cat <<EOF
+  </body>
+</html>
+EOF
+}
+
+bench-run() {
+  # Run mycpp/bench for each GC variant, and report ns/op and allocs/op
+
+  local base_dir=${1:-_tmp/mycpp-bench}
+  local in_tsv=_test/mycpp-bench.tsv
+
+  # Force SERIAL reexecution
+  rm -r -f --verbose _test/bench $in_tsv
+  ninja -j 1 $in_tsv
+
+  mkdir -p $base_dir/raw
+  cp -v $in_tsv $base_dir/raw
+
+  local dir2=$base_dir/stage2
+  mkdir -p $dir2
+
+  R_LIBS_USER=$R_PATH benchmarks/report.R mycpp-bench $base_dir/raw $dir2
+
+  $0 print-bench-report $dir2 > $base_dir/index.html
+  echo "Wrote $base_dir/index.html"
+}
+
 soil-run() {
   # Run and report mycpp/examples BENCHMARKS only.
 
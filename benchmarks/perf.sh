@@ -222,6 +222,32 @@ profile-hash-table() {
   profile-cpp 'hash_table' $mode $bin -t hash_speed_test
 }
 
+# Per-command profile written by the shell itself, rather than sampled by perf.
+# See doc/xtrace.md.
+#
+#   $0 profile-trace benchmarks/compute/fib.sh 200 44
+#     => _tmp/perf/trace-fib.{json,folded,svg}
+profile-trace() {
+  local script=${1:-benchmarks/compute/fib.sh}
+  shift || true
+
+  local bin=_bin/cxx-opt/osh
+  ninja $bin
+
+  local dir=$BASE_DIR
+  mkdir -p $dir
+  local prefix=$dir/trace-$(basename $script .sh)
+
+  # A high fd is unlikely to conflict with the script
+  OIL_PROFILE_FD=9 $bin $script "$@" 9> $prefix.bin > /dev/null
+
+  benchmarks/profile_trace.py chrome $prefix.bin > $prefix.json
+  benchmarks/profile_trace.py folded $prefix.bin > $prefix.folded
+  flamegraph --countname us $prefix.folded > $prefix.svg
+
+  echo "Wrote $prefix.json (for chrome://tracing) and $prefix.svg"
+}
+
 # Perf note: Without -o, for some reason osh output is shown on the console.
 # It doesn't go to wc?
 #perf record -o perf.data -- _bin/osh -n benchmarks/testdata/abuild | wc -l
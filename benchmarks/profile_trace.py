@@ -0,0 +1,245 @@
+#!/usr/bin/env python2
+"""
+profile_trace.py - Convert the binary profile written to $OIL_PROFILE_FD
+
+Usage:
+  benchmarks/profile_trace.py chrome PROFILE > trace.json  # chrome://tracing
+  benchmarks/profile_trace.py folded PROFILE > out.folded  # for flamegraph.pl
+  benchmarks/profile_trace.py tsv PROFILE                  # one row per span
+
+The format is described in core/pyos.py.  Each chunk has the PID of the
+process that wrote it.  A child process inherits the span stack of its parent,
+so a span's parent may be in another process; PROFILE_FORK events link them.
+"""
+from __future__ import print_function
+
+import json
+import struct
+import sys
+
+CHUNK_HEADER = struct.Struct('<4siii')
+RECORD = struct.Struct('<BBHiiiiiq')
+
+# Mirrors core/dev.py
+PROFILE_BEGIN = 1
+PROFILE_END = 2
+PROFILE_FORK = 3
+PROFILE_EXEC = 4
+PROFILE_EXIT = 5
+
+KIND_NAMES = ['other', 'builtin', 'external', 'proc']
+
+
+def log(msg, *args):
+  if args:
+    msg = msg % args
+  print(msg, file=sys.stderr)
+
+
+class Span(object):
+
+  def __init__(self, pid, span_id, parent_id, name, begin):
+    self.pid = pid
+    self.span_id = span_id
+    self.parent_id = parent_id
+    self.name = name
+    self.begin = begin
+    self.end = -1
+    self.kind = 0
+    self.status = -1
+    self.parent = None  # Span, maybe in another process
+    self.fork_name = None  # e.g. 'command sub', for the top of a child
+    self.children = []
+
+
+def ReadEvents(f):
+  """Yield (pid, event, kind, span_id, parent_id, child_pid, status, t_ns,
+  name)."""
+  while True:
+    header = f.read(CHUNK_HEADER.size)
+    if len(header) == 0:
+      break
+    if len(header) < CHUNK_HEADER.size:
+      raise RuntimeError('Truncated chunk header')
+    magic, pid, length, _ = CHUNK_HEADER.unpack(header)
+    if magic != 'OILP':
+      raise RuntimeError('Bad magic %r' % magic)
+
+    body = f.read(length)
+    pos = 0
+    while pos < len(body):
+      (event, kind, name_len, span_id, parent_id, child_pid, status, _,
+       t_ns) = RECORD.unpack_from(body, pos)
+      pos += RECORD.size
+      name = body[pos : pos + name_len]
+      pos += name_len
+      yield pid, event, kind, span_id, parent_id, child_pid, status, t_ns, name
+
+
+def Load(f):
+  """Returns a list of spans, and a list of fork events.
+
+  Chunks from different processes may be out of order, so this makes two
+  passes.
+  """
+  spans = {}  # (pid, span_id) -> Span
+  ordered = []
+  forks = []
+  fork_parent = {}  # child pid -> (parent pid, fork name)
+  exits = {}  # child pid -> (t_ns, status)
+  exec_kinds = {}  # (pid, span_id) -> kind
+  last_t = {}  # pid -> last timestamp
+
+  for (pid, event, kind, span_id, parent_id, child_pid, status, t_ns,
+       name) in ReadEvents(f):
+    last_t[pid] = t_ns
+
+    if event == PROFILE_BEGIN:
+      sp = Span(pid, span_id, parent_id, name, t_ns)
+      spans[pid, span_id] = sp
+      ordered.append(sp)
+
+    elif event == PROFILE_END:
+      sp = spans.get((pid, span_id))
+      if sp:
+        sp.end = t_ns
+        sp.kind = kind
+        sp.status = status
+
+    elif event == PROFILE_FORK:
+      fork_parent[child_pid] = (pid, name)
+      forks.append((pid, child_pid, name, t_ns))
+
+    elif event == PROFILE_EXEC:
+      exec_kinds[pid, span_id] = kind
+
+    elif event == PROFILE_EXIT:
+      exits[child_pid] = (t_ns, status)
+
+    else:
+      raise RuntimeError('Invalid event %d' % event)
+
+  for sp in ordered:
+    # The span stack is inherited by child processes, so the parent may be in
+    # an ancestor process.
+    parent = spans.get((sp.pid, sp.parent_id))
+    if parent is None and sp.pid in fork_parent:
+      sp.fork_name = fork_parent[sp.pid][1]  # label the top of the child
+      p = fork_parent[sp.pid][0]
+      while parent is None and p is not None:
+        parent = spans.get((p, sp.parent_id))
+        p = fork_parent[p][0] if p in fork_parent else None
+    if parent:
+      sp.parent = parent
+      parent.children.append(sp)
+
+    # Spans replaced by exec() end when the process is reaped.  Others were cut
+    # off by exit.
+    if sp.end == -1:
+      if (sp.pid, sp.span_id) in exec_kinds:
+        sp.kind = exec_kinds[sp.pid, sp.span_id]
+      if sp.pid in exits:
+        sp.end, sp.status = exits[sp.pid]
+      else:
+        sp.end = last_t[sp.pid]
+
+  return ordered, forks
+
+
+def Stack(sp):
+  names = []
+  while sp:
+    names.append(sp.name.replace(';', ':') or '?')
+    if sp.fork_name:
+      names.append('[%s]' % sp.fork_name)
+    sp = sp.parent
+  names.reverse()
+  return ';'.join(names)
+
+
+def Chrome(spans, forks):
+  if spans:
+    t0 = min(sp.begin for sp in spans)
+  else:
+    t0 = 0
+
+  events = []
+  for sp in spans:
+    events.append({
+        'name': sp.name,
+        'cat': KIND_NAMES[sp.kind] if sp.kind < len(KIND_NAMES) else 'other',
+        'ph': 'X',
+        'ts': (sp.begin - t0) / 1000.0,
+        'dur': (sp.end - sp.begin) / 1000.0,
+        'pid': sp.pid,
+        'tid': sp.pid,
+        'args': {'status': sp.status, 'span_id': sp.span_id},
+    })
+  for pid, child_pid, name, t_ns in forks:
+    events.append({
+        'name': name,
+        'cat': 'fork',
+        'ph': 'i',
+        's': 't',
+        'ts': (t_ns - t0) / 1000.0,
+        'pid': pid,
+        'tid': pid,
+        'args': {'child_pid': child_pid},
+    })
+
+  json.dump({'traceEvents': events, 'displayTimeUnit': 'ms'}, sys.stdout,
+            indent=0)
+  print()
+
+
+def Folded(spans):
+  """Self time in microseconds, for flamegraph.pl."""
+  totals = {}
+  for sp in spans:
+    self_ns = (sp.end - sp.begin) - sum(c.end - c.begin for c in sp.children)
+    stack = Stack(sp)
+    totals[stack] = totals.get(stack, 0) + max(self_ns, 0)
+
+  for stack in sorted(totals):
+    us = totals[stack] // 1000
+    if us > 0:
+      print('%s %d' % (stack, us))
+
+
+def Tsv(spans):
+  print('\t'.join(['pid', 'span_id', 'parent_id', 'kind', 'status',
+                   'begin_us', 'elapsed_us', 'name']))
+  t0 = min(sp.begin for sp in spans) if spans else 0
+  for sp in spans:
+    print('%d\t%d\t%d\t%s\t%d\t%.1f\t%.1f\t%s' % (
+        sp.pid, sp.span_id, sp.parent_id, KIND_NAMES[sp.kind], sp.status,
+        (sp.begin - t0) / 1000.0, (sp.end - sp.begin) / 1000.0, sp.name))
+
+
+def main(argv):
+  try:
+    action = argv[1]
+    path = argv[2]
+  except IndexError:
+    raise RuntimeError('Usage: profile_trace.py (chrome|folded|tsv) PROFILE')
+
+  with open(path, 'rb') as f:
+    spans, forks = Load(f)
+  log('%d spans, %d forks', len(spans), len(forks))
+
+  if action == 'chrome':
+    Chrome(spans, forks)
+  elif action == 'folded':
+    Folded(spans)
+  elif action == 'tsv':
+    Tsv(spans)
+  else:
+    raise RuntimeError('Invalid action %r' % action)
+
+
+if __name__ == '__main__':
+  try:
+    main(sys.argv)
+  except RuntimeError as e:
+    print('FATAL: %s' % e, file=sys.stderr)
+    sys.exit(1)
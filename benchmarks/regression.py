@@ -0,0 +1,283 @@
+#!/usr/bin/env python2
+"""
+regression.py - Compare benchmark runs, and fail on significant regressions
+
+Usage:
+  benchmarks/regression.py compare BASELINE_DIR CANDIDATE_DIR
+
+Each dir has the output of 'benchmarks/regression.sh measure':
+
+  times.tsv      from time_.py --rusage --perf, with task and rep fields
+  gc_stats.tsv   from gc_stats_to_tsv.py, optional
+
+For each task and metric, the repetitions of the baseline and candidate are
+compared with a one-sided Mann-Whitney U test.  A metric regresses when it's
+significant AND the medians differ by more than a threshold, so tiny but
+consistent changes don't fail the gate, and neither do noisy big ones.
+
+Instruction counts are nearly deterministic, so their threshold is smaller.
+They're NA when perf_event_open() isn't allowed, and then they're skipped.
+
+Exits 1 if anything regressed, or if a comparison has too few reps to ever
+be significant at --alpha.
+"""
+from __future__ import print_function
+
+import math
+import optparse
+import sys
+
+# (metric, relative threshold, absolute threshold)
+#
+# The absolute threshold avoids failing on sub-millisecond GC pauses.
+METRICS = [
+    ('elapsed_secs', 0.05, 0.0),
+    ('user_secs', 0.05, 0.0),
+    ('max_rss_KiB', 0.05, 0.0),
+    ('max_gc_millis', 0.10, 1.0),
+    ('instructions', 0.02, 0.0),
+]
+
+
+def log(msg, *args):
+  if args:
+    msg = msg % args
+  print(msg, file=sys.stderr)
+
+
+def ReadTsv(path):
+  with open(path) as f:
+    header = f.readline().rstrip('\n').split('\t')
+    for line in f:
+      yield dict(zip(header, line.rstrip('\n').split('\t')))
+
+
+def Load(in_dir):
+  """Returns {task: {metric: [float, ...]}}."""
+  gc_stats = {}
+  try:
+    for row in ReadTsv(in_dir + '/gc_stats.tsv'):
+      gc_stats[row['join_id']] = row
+  except IOError:
+    pass  # e.g. binaries without OIL_GC_STATS_FD
+
+  result = {}
+  for row in ReadTsv(in_dir + '/times.tsv'):
+    if row['status'] != '0':
+      raise RuntimeError('Task %s rep %s failed with status %s in %s' %
+                         (row['task'], row['rep'], row['status'], in_dir))
+
+    row.update(gc_stats.get(row['join_id'], {}))
+
+    metrics = result.setdefault(row['task'], {})
+    for name, _, _ in METRICS:
+      value = row.get(name, 'NA')
+      if value == 'NA':
+        continue
+      metrics.setdefault(name, []).append(float(value))
+  return result
+
+
+def Median(xs):
+  s = sorted(xs)
+  n = len(s)
+  if n % 2 == 1:
+    return s[n // 2]
+  return (s[n // 2 - 1] + s[n // 2]) / 2.0
+
+
+def _Ranks(values):
+  """Average ranks, starting at 1, and the tie correction term."""
+  order = sorted(range(len(values)), key=lambda i: values[i])
+  ranks = [0.0] * len(values)
+  tie_term = 0.0
+  i = 0
+  while i < len(order):
+    j = i
+    while j + 1 < len(order) and values[order[j + 1]] == values[order[i]]:
+      j += 1
+    avg = (i + j) / 2.0 + 1
+    for k in xrange(i, j + 1):
+      ranks[order[k]] = avg
+    t = j - i + 1
+    tie_term += t * t * t - t
+    i = j + 1
+  return ranks, tie_term
+
+
+def _ExactUpperTail(n1, n2, u):
+  """P(U >= u) under the null hypothesis, with no ties.
+
+  Counts the orderings of n1 x's and n2 y's by the number of (x, y) pairs
+  with x > y.
+  """
+  # counts[i][j] is a list indexed by U, for i x's and j y's
+  counts = [[None] * (n2 + 1) for _ in xrange(n1 + 1)]
+  for i in xrange(n1 + 1):
+    for j in xrange(n2 + 1):
+      if i == 0 or j == 0:
+        counts[i][j] = [1]
+        continue
+      # The largest value is an x, which beats all j y's, or it's a y
+      a = counts[i - 1][j]
+      b = counts[i][j - 1]
+      c = [0] * (i * j + 1)
+      for k, n in enumerate(a):
+        c[k + j] += n
+      for k, n in enumerate(b):
+        c[k] += n
+      counts[i][j] = c
+
+  dist = counts[n1][n2]
+  total = float(sum(dist))
+  u = int(math.ceil(u))
+  return sum(dist[u:]) / total
+
+
+def MinPValue(n1, n2):
+  """The smallest one-sided p-value MannWhitneyGreater() can return.
+
+  That's when every x is greater than every y, which is 1 of the
+  C(n1 + n2, n1) orderings.  Ties only make it larger.  With 4 reps on each
+  side it's 1/70, so nothing is significant at alpha = 0.01.
+  """
+  n = n1 + n2
+  k = min(n1, n2)
+  orderings = 1
+  for i in xrange(k):
+    orderings = orderings * (n - i) // (i + 1)
+  return 1.0 / orderings
+
+
+def MannWhitneyGreater(xs, ys):
+  """One-sided p-value for the hypothesis that xs tend to be greater than ys.
+
+  Exact for small samples without ties; otherwise the normal approximation
+  with tie and continuity corrections.
+  """
+  n1 = len(xs)
+  n2 = len(ys)
+  ranks, tie_term = _Ranks(list(xs) + list(ys))
+  r1 = sum(ranks[:n1])
+  u = r1 - n1 * (n1 + 1) / 2.0  # pairs with x > y, ties count 1/2
+
+  if tie_term == 0 and n1 * n2 <= 400:
+    return _ExactUpperTail(n1, n2, u)
+
+  n = n1 + n2
+  mean = n1 * n2 / 2.0
+  var = n1 * n2 / 12.0 * ((n + 1) - tie_term / (n * (n - 1)))
+  if var == 0:
+    return 1.0  # all values are equal
+  z = (u - mean - 0.5) / math.sqrt(var)
+  return 0.5 * math.erfc(z / math.sqrt(2))
+
+
+def Compare(base, cand, alpha, min_reps):
+  """Yields (task, metric, base_median, cand_median, delta_pct, p, verdict)."""
+  for task in sorted(cand):
+    if task not in base:
+      log('Task %r is not in the baseline', task)
+      continue
+    for metric, rel_threshold, abs_threshold in METRICS:
+      xs = cand[task].get(metric)
+      ys = base[task].get(metric)
+      if not xs or not ys:
+        continue
+
+      base_med = Median(ys)
+      cand_med = Median(xs)
+      diff = cand_med - base_med
+      if base_med != 0:
+        delta_pct = diff * 100.0 / base_med
+      else:
+        delta_pct = 0.0
+
+      if len(xs) < min_reps or len(ys) < min_reps:
+        yield task, metric, base_med, cand_med, delta_pct, -1.0, 'too-few'
+        continue
+
+      # Otherwise we would silently report 'same' for any difference
+      min_p = MinPValue(len(xs), len(ys))
+      if min_p >= alpha:
+        yield task, metric, base_med, cand_med, delta_pct, min_p, 'underpowered'
+        continue
+
+      big = (abs(diff) > abs_threshold and
+             abs(diff) > rel_threshold * abs(base_med))
+
+      p_worse = MannWhitneyGreater(xs, ys)
+      p_better = MannWhitneyGreater(ys, xs)
+      if diff > 0 and big and p_worse < alpha:
+        verdict = 'REGRESSION'
+        p = p_worse
+      elif diff < 0 and big and p_better < alpha:
+        verdict = 'improvement'
+        p = p_better
+      else:
+        verdict = 'same'
+        p = min(p_worse, p_better)
+
+      yield task, metric, base_med, cand_med, delta_pct, p, verdict
+
+
+def Options():
+  p = optparse.OptionParser('regression.py compare BASELINE_DIR CANDIDATE_DIR')
+  p.add_option(
+      '--alpha', dest='alpha', type='float', default=0.01,
+      help='Significance level for the one-sided Mann-Whitney test')
+  p.add_option(
+      '--min-reps', dest='min_reps', type='int', default=5,
+      help='Fewer repetitions than this are reported but never fail')
+  return p
+
+
+def main(argv):
+  opts, args = Options().parse_args(argv[1:])
+  try:
+    action = args[0]
+  except IndexError:
+    raise RuntimeError('Action required')
+
+  if action == 'compare':
+    try:
+      base_dir, cand_dir = args[1:3]
+    except ValueError:
+      raise RuntimeError('Expected BASELINE_DIR CANDIDATE_DIR')
+
+    base = Load(base_dir)
+    cand = Load(cand_dir)
+
+    print('\t'.join(['task', 'metric', 'base_median', 'cand_median',
+                     'delta_pct', 'p_value', 'verdict']))
+    num_regressions = 0
+    num_underpowered = 0
+    for task, metric, base_med, cand_med, delta_pct, p, verdict in Compare(
+        base, cand, opts.alpha, opts.min_reps):
+      print('%s\t%s\t%.4f\t%.4f\t%.2f\t%.4f\t%s' % (
+          task, metric, base_med, cand_med, delta_pct, p, verdict))
+      if verdict == 'REGRESSION':
+        num_regressions += 1
+      elif verdict == 'underpowered':
+        num_underpowered += 1
+
+    if num_regressions:
+      log('regression.py: %d significant regressions', num_regressions)
+      return 1
+    if num_underpowered:
+      log('regression.py: %d comparisons have too few reps to reach p < %s; '
+          'run more reps', num_underpowered, opts.alpha)
+      return 1
+    log('regression.py: no significant regressions')
+    return 0
+
+  else:
+    raise RuntimeError('Invalid action %r' % action)
+
+
+if __name__ == '__main__':
+  try:
+    sys.exit(main(sys.argv))
+  except RuntimeError as e:
+    print('FATAL: %s' % e, file=sys.stderr)
+    sys.exit(2)
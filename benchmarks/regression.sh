@@ -0,0 +1,122 @@
+#!/usr/bin/env bash
+#
+# A performance regression gate.  Compares an OSH binary against a baseline
+# that was measured on the same machine, and fails on significant regressions
+# in time, memory, GC pauses, or instruction counts.
+#
+# Usage:
+#   benchmarks/regression.sh <function name>
+#
+# Examples:
+#
+#   $0 save-baseline             # measure _bin/cxx-opt/osh, e.g. on master
+#   $0 check                     # after your change; exits 1 on regressions
+#   $0 check _bin/cxx-opt/osh 11 # more repetitions
+#
+# Runs offline, with the benchmarks/testdata corpus.  See
+# benchmarks/regression.py for the statistics.
+
+set -o nounset
+set -o pipefail
+set -o errexit
+
+REPO_ROOT=$(cd "$(dirname $0)/.."; pwd)
+
+source benchmarks/common.sh  # die
+source test/tsv-lib.sh  # time-tsv
+
+readonly BASE_DIR=_tmp/regression
+
+# Baselines are per machine, and they're kept outside the repo, like the other
+# benchmark data.
+readonly BASELINE_DIR=${REGRESSION_BASELINE_DIR:-../benchmark-data/regression}
+
+readonly DEFAULT_REPS=7
+
+print-tasks() {
+  # task, then argv for osh
+  cat <<EOF
+parse.configure-coreutils --ast-format none -n benchmarks/testdata/configure-coreutils
+parse.abuild --ast-format none -n benchmarks/testdata/abuild
+parse.ltmain --ast-format none -n benchmarks/testdata/ltmain.sh
+ex.compute-fib benchmarks/compute/fib.sh 100 44
+ex.bashcomp-parse-help benchmarks/parse-help/pure-excerpt.sh parse_help_file benchmarks/parse-help/clang.txt
+ex.abuild-print-help testdata/osh-runtime/abuild -h
+EOF
+}
+
+measure() {
+  local osh=${1:-$OSH_CPP_NINJA_BUILD}
+  local out_dir=${2:-$BASE_DIR/candidate}
+  local reps=${3:-$DEFAULT_REPS}
+
+  rm -r -f $out_dir
+  mkdir -p $out_dir/gc
+
+  local tsv_out=$out_dir/times.tsv
+  time-tsv -o $tsv_out --print-header \
+    --rusage --perf --field join_id --field task --field rep
+
+  # Repetitions are the outer loop, so slow drift in the machine's state
+  # affects all tasks alike
+  local rep
+  for rep in $(seq $reps); do
+    local task argv
+    while read -r task argv; do
+      local join_id="$task.$rep"
+      log "*** $osh $join_id"
+
+      OIL_GC_STATS_FD=99 \
+        time-tsv -o $tsv_out --append --rusage --perf \
+          --field "$join_id" --field "$task" --field "$rep" \
+          -- $osh $argv \
+          > /dev/null 99> $out_dir/gc/$join_id.txt
+    done < <(print-tasks)
+  done
+
+  benchmarks/gc_stats_to_tsv.py $out_dir/gc/*.txt > $out_dir/gc_stats.tsv
+
+  log "Wrote $out_dir"
+}
+
+save-baseline() {
+  local osh=${1:-$OSH_CPP_NINJA_BUILD}
+  local reps=${2:-$DEFAULT_REPS}
+
+  local dir=$BASELINE_DIR/$(hostname)
+  measure $osh $dir $reps
+}
+
+compare() {
+  local baseline=${1:-$BASELINE_DIR/$(hostname)}
+  local candidate=${2:-$BASE_DIR/candidate}
+
+  mkdir -p $BASE_DIR
+  local status=0
+  benchmarks/regression.py compare $baseline $candidate \
+    > $BASE_DIR/compare.tsv || status=$?
+
+  if command -v pretty-tsv > /dev/null; then
+    pretty-tsv $BASE_DIR/compare.tsv
+  else
+    cat $BASE_DIR/compare.tsv
+  fi
+  return $status
+}
+
+check() {
+  local osh=${1:-$OSH_CPP_NINJA_BUILD}
+  local reps=${2:-$DEFAULT_REPS}
+
+  local baseline=$BASELINE_DIR/$(hostname)
+  if ! test -f $baseline/times.tsv; then
+    die "No baseline for $(hostname).  Run '$0 save-baseline' first."
+  fi
+
+  measure $osh $BASE_DIR/candidate $reps
+
+  # Instruction counts are skipped if the baseline or candidate has NA
+  compare $baseline $BASE_DIR/candidate
+}
+
+"$@"
@@ -0,0 +1,102 @@
+#!/usr/bin/env python2
+"""
+regression_test.py: Tests for regression.py
+"""
+from __future__ import print_function
+
+import unittest
+
+from benchmarks import regression  # module under test
+
+
+class MannWhitneyTest(unittest.TestCase):
+
+  def testExact(self):
+    # Complete separation: 1 / C(10, 5)
+    p = regression.MannWhitneyGreater([6, 7, 8, 9, 10], [1, 2, 3, 4, 5])
+    self.assertAlmostEqual(1 / 252.0, p)
+
+    p = regression.MannWhitneyGreater([1, 2, 3, 4, 5], [6, 7, 8, 9, 10])
+    self.assertAlmostEqual(1.0, p)
+
+    # Interleaved: no evidence either way
+    p = regression.MannWhitneyGreater([1, 3, 5, 7], [2, 4, 6, 8])
+    self.assertTrue(0.3 < p < 0.8, p)
+
+  def testTies(self):
+    # Normal approximation
+    p = regression.MannWhitneyGreater([2, 2, 3, 3, 3], [1, 1, 2, 2, 2])
+    self.assertTrue(p < 0.05, p)
+
+    # All equal
+    p = regression.MannWhitneyGreater([1, 1, 1], [1, 1, 1])
+    self.assertEqual(1.0, p)
+
+  def testNormalMatchesExact(self):
+    xs = [float(i) for i in range(20, 40)]
+    ys = [i + 0.5 for i in range(0, 30)]
+    exact = regression.MannWhitneyGreater(xs, ys)
+
+    # Add a tie to force the approximation
+    ys[0] = 20.0
+    approx = regression.MannWhitneyGreater(xs, ys)
+    self.assertTrue(abs(exact - approx) < 0.01, (exact, approx))
+
+
+  def testMinPValue(self):
+    self.assertAlmostEqual(1 / 20.0, regression.MinPValue(3, 3))
+    self.assertAlmostEqual(1 / 70.0, regression.MinPValue(4, 4))
+    self.assertAlmostEqual(1 / 252.0, regression.MinPValue(5, 5))
+    self.assertAlmostEqual(1 / 56.0, regression.MinPValue(3, 5))
+
+    # It's what the exact test gives when every x is greater
+    self.assertAlmostEqual(
+        regression.MinPValue(4, 4),
+        regression.MannWhitneyGreater([5, 6, 7, 8], [1, 2, 3, 4]))
+
+
+class CompareTest(unittest.TestCase):
+
+  def testVerdicts(self):
+    base = {'fib': {
+        'elapsed_secs': [1.00, 1.01, 0.99, 1.02, 1.00, 0.98, 1.01],
+        'max_rss_KiB': [1000, 1000, 1001, 1000, 1000, 1000, 1001],
+        'max_gc_millis': [0.2, 0.3, 0.2, 0.2, 0.3, 0.2, 0.2],
+    }}
+    cand = {'fib': {
+        # 20% slower
+        'elapsed_secs': [1.20, 1.21, 1.19, 1.22, 1.20, 1.18, 1.21],
+        # 1% bigger is under the threshold
+        'max_rss_KiB': [1010, 1010, 1011, 1010, 1010, 1010, 1011],
+        # 2x longer pauses are under the absolute threshold
+        'max_gc_millis': [0.4, 0.6, 0.4, 0.4, 0.6, 0.4, 0.4],
+    }}
+    rows = list(regression.Compare(base, cand, 0.01, 3))
+    verdicts = dict((row[1], row[-1]) for row in rows)
+    self.assertEqual('REGRESSION', verdicts['elapsed_secs'])
+    self.assertEqual('same', verdicts['max_rss_KiB'])
+    self.assertEqual('same', verdicts['max_gc_millis'])
+
+    rows = list(regression.Compare(cand, base, 0.01, 3))
+    verdicts = dict((row[1], row[-1]) for row in rows)
+    self.assertEqual('improvement', verdicts['elapsed_secs'])
+
+  def testTooFew(self):
+    base = {'fib': {'elapsed_secs': [1.0, 1.0]}}
+    cand = {'fib': {'elapsed_secs': [2.0, 2.0]}}
+    rows = list(regression.Compare(base, cand, 0.01, 3))
+    self.assertEqual('too-few', rows[0][-1])
+
+  def testUnderpowered(self):
+    # 4 reps can't be significant at 0.01, however big the difference
+    base = {'fib': {'elapsed_secs': [1.0, 1.01, 0.99, 1.02]}}
+    cand = {'fib': {'elapsed_secs': [2.0, 2.01, 1.99, 2.02]}}
+    rows = list(regression.Compare(base, cand, 0.01, 3))
+    self.assertEqual('underpowered', rows[0][-1])
+
+    rows = list(regression.Compare(base, cand, 0.05, 3))
+    self.assertEqual('REGRESSION', rows[0][-1])
+
+
+if __name__ == '__main__':
+  unittest.main()
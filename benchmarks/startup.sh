@@ -103,6 +103,10 @@ compare() {
   $callback _bin/true
   echo
 
+  echo 'OSH app bundle true, importing from .zip only'
+  _OVM_BUNDLE=0 $callback _bin/true
+  echo
+
   echo 'OSH app bundle Hello World'
   $callback _bin/osh -c 'echo hi'
   echo
@@ -116,6 +120,30 @@ compare-time() {
   compare time-callback
 }
 
+# Compare importing from the mmap()'d bytecode bundle with zipimport.  See
+# build/make_bundle.py.
+bundle-vs-zip() {
+  local ovm=${1:-_bin/oil.ovm}
+  local n=${2:-20}
+
+  local label i
+  for label in bundle zip; do
+    local env_val=1
+    if test $label = zip; then
+      env_val=0
+    fi
+
+    echo "$label: $n x '$ovm true'"
+    time for i in $(seq $n); do
+      _OVM_BUNDLE=$env_val $ovm true
+    done
+
+    echo "$label: syscalls"
+    _OVM_BUNDLE=$env_val strace-callback $ovm true
+    echo
+  done
+}
+
 import-stats() {
   # 152 sys calls!  More than bash needs to start up.
   echo json
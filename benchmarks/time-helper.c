@@ -1,15 +1,23 @@
-#define _GNU_SOURCE  // for timersub()
+#define _GNU_SOURCE  // for timersub(), pipe2()
 #include <assert.h>
 #include <errno.h>
+#include <fcntl.h>  // O_CLOEXEC
 #include <getopt.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>        // exit()
+#include <string.h>        // memset()
 #include <sys/resource.h>  // getrusage()
 #include <sys/time.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>  // __NR_perf_event_open
+#endif
+
 void die_errno(const char *message) {
   perror(message);
   exit(1);
@@ -32,6 +40,7 @@ typedef struct Spec_t {
   bool U;  // %U user time
   bool S;  // %S system time
   bool M;  // %M maxrss
+  bool P;  // hardware counters from perf_event_open()
   int argc;
   char **argv;
 } Spec;
@@ -49,19 +58,117 @@ void time_cell(FILE *f, char delimiter, struct timeval *val) {
   fprintf(f, "%c%ld.%06ld", delimiter, val->tv_sec, val->tv_usec);
 }
 
+// Hardware counters, written as extra columns with -P.  They're far less noisy
+// than elapsed time on shared machines.  Keep in sync with PERF_COLUMNS in
+// benchmarks/time_.py.
+
+#ifdef __linux__
+#define L1D_READ_MISS                                               \
+  (PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | \
+   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+#define LL_READ_MISS                                               \
+  (PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | \
+   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+struct counter_def {
+  uint32_t type;
+  uint64_t config;
+};
+
+static struct counter_def counter_defs[] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_HW_CACHE, L1D_READ_MISS},
+    {PERF_TYPE_HW_CACHE, LL_READ_MISS},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+};
+#define NUM_COUNTERS ((int)(sizeof(counter_defs) / sizeof(counter_defs[0])))
+#else
+#define NUM_COUNTERS 6
+#endif
+
+// Counts the child and its descendants, in user space, starting at exec().
+// Returns -1 if the counter isn't available, e.g. in a VM or with
+// perf_event_paranoid > 2.
+int open_counter(int i, pid_t pid) {
+#ifdef __linux__
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = counter_defs[i].type;
+  attr.config = counter_defs[i].config;
+  attr.disabled = 1;
+  attr.enable_on_exec = 1;
+  attr.inherit = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  // The kernel multiplexes counters when there are too many
+  attr.read_format =
+      PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+  return syscall(__NR_perf_event_open, &attr, pid, -1, -1, 0);
+#else
+  return -1;
+#endif
+}
+
+// Returns the count, scaled up if it was multiplexed, or -1 on error
+long long read_counter(int fd) {
+  if (fd < 0) {
+    return -1;
+  }
+  uint64_t buf[3];  // value, time enabled, time running
+  if (read(fd, buf, sizeof(buf)) != sizeof(buf)) {
+    return -1;
+  }
+  if (buf[2] == 0) {  // never scheduled
+    return -1;
+  }
+  if (buf[2] < buf[1]) {
+    return (long long)((double)buf[0] * buf[1] / buf[2]);
+  }
+  return (long long)buf[0];
+}
+
+// NA is what R's read.table() expects
+void counter_cell(FILE *f, char delimiter, long long val) {
+  if (val < 0) {
+    fprintf(f, "%cNA", delimiter);
+  } else {
+    fprintf(f, "%c%lld", delimiter, val);
+  }
+}
+
 int time_helper(Spec *spec, FILE *f) {
   char *prog = spec->argv[0];
 
   struct timeval start;
   struct timeval end;
 
+  // With -P, the child waits for the parent to attach counters before exec().
+  // The read end gets EOF when the parent closes the write end.
+  int sync_fds[2] = {-1, -1};
+  if (spec->P && pipe2(sync_fds, O_CLOEXEC) < 0) {
+    die_errno("pipe2");
+  }
+  int counter_fds[NUM_COUNTERS];
+
   int status = 0;
-  switch (fork()) {
+  pid_t pid = fork();
+  switch (pid) {
   case -1:
     die_errno("fork");
     break;
 
   case 0:  // child exec
+    if (spec->P) {
+      char c;
+      close(sync_fds[1]);
+      if (read(sync_fds[0], &c, 1) < 0) {
+        die_errno("read");
+      }
+    }
     if (execvp(prog, spec->argv) < 0) {
       fprintf(stderr, "time-helper: error executing '%s'\n", prog);
       die_errno("execvp");
@@ -69,6 +176,16 @@ int time_helper(Spec *spec, FILE *f) {
     assert(0);  // execvp() never returns
 
   default:  // parent measures elapsed time of child
+    if (spec->P) {
+      close(sync_fds[0]);
+      for (int i = 0; i < NUM_COUNTERS; ++i) {
+        counter_fds[i] = open_counter(i, pid);
+      }
+      if (spec->verbose && counter_fds[0] < 0) {
+        perror("time-helper: perf_event_open");
+      }
+      close(sync_fds[1]);  // let the child exec
+    }
     if (gettimeofday(&start, NULL) < 0) {
       die_errno("gettimeofday");
     }
@@ -118,6 +235,14 @@ int time_helper(Spec *spec, FILE *f) {
   if (spec->M) {
     int_cell(f, d, usage.ru_maxrss);
   }
+  if (spec->P) {
+    for (int i = 0; i < NUM_COUNTERS; ++i) {
+      counter_cell(f, d, read_counter(counter_fds[i]));
+      if (counter_fds[i] >= 0) {
+        close(counter_fds[i]);
+      }
+    }
+  }
 
   return exit_status;
 }
@@ -130,7 +255,7 @@ int main(int argc, char **argv) {
   // http://www.gnu.org/software/libc/manual/html_node/Example-of-Getopt.html
   // + means to be strict about flag parsing.
   char c;
-  while ((c = getopt(argc, argv, "+o:ad:vxeUSM")) != -1) {
+  while ((c = getopt(argc, argv, "+o:ad:vxeUSMP")) != -1) {
     switch (c) {
     case 'o':
       spec.out_path = optarg;
@@ -161,6 +286,9 @@ int main(int argc, char **argv) {
     case 'M':
       spec.M = true;
       break;
+    case 'P':
+      spec.P = true;
+      break;
 
     case '?':  // getopt library will print error
       return 2;
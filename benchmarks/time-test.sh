@@ -186,6 +186,17 @@ test-rusage() {
   #cat $out
 }
 
+test-perf() {
+  local out=_tmp/time-perf.tsv
+
+  # Counters may be NA in VMs and containers, but the columns are always there
+  time-tool --tsv -o $out --rusage --perf -- seq 100000 > /dev/null
+  cat $out | count-lines-and-cols 1 11
+
+  time-tool --tsv -o $out --perf --field a -- seq 1
+  cat $out | count-lines-and-cols 1 9
+}
+
 # Compare vs. /usr/bin/time.
 test-maxrss() {
   if which time; then  # Ignore this on continuous build
@@ -213,6 +224,9 @@ test-print-header() {
   time-tool --print-header --rusage --field foo --field bar
   assert $? -eq 0
 
+  time-tool --tsv --print-header --rusage --perf --field name
+  assert $? -eq 0
+
   time-tool -o _tmp/time-test-1 \
     --print-header --rusage --stdout DUMMY --tsv --field a --field b
   assert $? -eq 0
@@ -250,6 +264,12 @@ test-time-helper() {
   assert $? -eq 42
   cat $tmp
   echo
+
+  # Hardware counters
+  $th -o $tmp -a -d , -x -e -P -- sh -c "$cmd"
+  assert $? -eq 42
+  cat $tmp
+  echo
   
   # Error case
   $th -z
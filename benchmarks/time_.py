@@ -41,6 +41,13 @@ TIME_HELPER = os.path.abspath(
     os.path.join(THIS_DIR, '../_devbuild/bin/time-helper'))
 
 
+# Written by time-helper -P, in this order
+PERF_COLUMNS = [
+    'instructions', 'cycles', 'branch_misses', 'l1d_misses', 'llc_misses',
+    'page_faults'
+]
+
+
 def log(msg, *args):
   if args:
     msg = msg % args
@@ -56,6 +63,10 @@ def Options():
   p.add_option(
       '--rusage', dest='rusage', default=False, action='store_true',
       help='Also show user time, system time, and max resident set size')
+  p.add_option(
+      '--perf', dest='perf', default=False, action='store_true',
+      help='Also show hardware counters from perf_event_open(), or NA if '
+           'they are unavailable')
   p.add_option(
       '-o', '--output', dest='output', default=None,
       help='Name of output file to write to to')
@@ -73,7 +84,8 @@ def Options():
       help='Save stdout to this file, and add a column for its md5 checksum')
   p.add_option(
       '--print-header', dest='print_header', default=False, action='store_true',
-      help='Print an XSV header, respecting --rusage, --stdout, --field, and --tsv')
+      help='Print an XSV header, respecting --rusage, --perf, --stdout, '
+           '--field, and --tsv')
   return p
 
 
@@ -99,6 +111,8 @@ def main(argv):
     names = ['status', 'elapsed_secs']
     if opts.rusage:
       names.extend(['user_secs', 'sys_secs', 'max_rss_KiB'])
+    if opts.perf:
+      names.extend(PERF_COLUMNS)
     if opts.stdout:
       names.append('stdout_md5sum')
     names.extend(opts.fields)
@@ -131,6 +145,8 @@ def main(argv):
     # %S: sys time
     # %M: Max RSS
     time_argv.extend(['-U', '-S', '-M'])
+  if opts.perf:
+    time_argv.append('-P')
 
   time_argv.append('--')
   time_argv.extend(child_argv)
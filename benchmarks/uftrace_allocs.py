@@ -5,9 +5,9 @@ Count allocations and show sizes.
 
 Annoying thing about uftrace: it swallows ImportError and other errors!
 
-TODO:
-  Attribute allocations and sizes to Str, List, Dict, Token, etc.
-  How do we do that?  We need the call graph relationship
+Note: the alloclog variant attributes allocations and sizes to Str, List,
+Dict, Token, etc. exactly.  See benchmarks/alloclog.sh.  This plugin has to
+reconstruct the types from the call graph:
 
 Structures to catch:
 
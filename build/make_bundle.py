@@ -0,0 +1,190 @@
+#!/usr/bin/env python2
+"""
+make_bundle.py
+
+Takes the bytecode .zip and writes the .pyc files in it to a bundle that
+Modules/ovmimport.c can import from without parsing the zip directory.
+
+  build/make_bundle.py OUT.bundle < IN.zip
+
+The app bundle is the OVM binary, then the bundle, then the zip:
+
+  cat ovm-opt.stripped bytecode-opy.bundle bytecode-opy.zip > oil.ovm
+
+The zip still has everything, so it's the fallback, and resources like help
+files are read from it.  The bundle is found through the zip's end of central
+directory record.
+
+Format, all integers are little-endian uint32:
+
+  header      'OVMB' version pyc_magic num_slots num_buckets
+  buckets     num_buckets displacements
+  slots       num_slots x (name_off name_len code_off code_len flags)
+  strings     module names, e.g. 'core.util'
+  code        marshalled code objects, i.e. .pyc files without the header
+  trailer     bundle_size 'OVMB'
+
+Offsets are relative to the start of the bundle.  Empty slots have
+name_len == 0.
+
+The module table is a perfect hash built with "hash and displace": a name is
+in bucket Hash(0, name) % num_buckets, and then in slot
+Hash(d, name) % num_slots, where d is the bucket's displacement.  A lookup
+hashes twice and compares one name.
+"""
+
+import struct
+import sys
+import zipfile
+
+MAGIC = 'OVMB'
+VERSION = 1
+
+FLAG_PACKAGE = 1
+
+HEADER = struct.Struct('<4sIIII')
+SLOT = struct.Struct('<IIIII')
+TRAILER = struct.Struct('<I4s')
+
+# Should be enough for any load factor we use
+MAX_DISPLACEMENT = 1 << 16
+
+
+def Hash(seed, s):
+  """FNV-1a with a seed, then the murmur3 finalizer.  Must match ovmimport.c.
+
+  The finalizer matters because the low bits of FNV are weak.
+  """
+  h = (2166136261 ^ (seed * 16777619)) & 0xFFFFFFFF
+  for c in s:
+    h ^= ord(c)
+    h = (h * 16777619) & 0xFFFFFFFF
+  h ^= h >> 16
+  h = (h * 0x85ebca6b) & 0xFFFFFFFF
+  h ^= h >> 13
+  h = (h * 0xc2b2ae35) & 0xFFFFFFFF
+  h ^= h >> 16
+  return h
+
+
+def PerfectHash(names, num_slots, num_buckets):
+  """Returns (displacements, slots), or None if it failed.
+
+  slots[i] is an index into names, or -1.
+  """
+  buckets = [[] for _ in xrange(num_buckets)]
+  for i, name in enumerate(names):
+    buckets[Hash(0, name) % num_buckets].append(i)
+
+  displacements = [0] * num_buckets
+  slots = [-1] * num_slots
+
+  # Place the biggest buckets first, while the table is empty
+  order = sorted(xrange(num_buckets), key=lambda b: len(buckets[b]),
+                 reverse=True)
+  for b in order:
+    bucket = buckets[b]
+    if not bucket:
+      break
+    for d in xrange(1, MAX_DISPLACEMENT):
+      taken = [Hash(d, names[i]) % num_slots for i in bucket]
+      if (len(set(taken)) == len(taken) and
+          all(slots[s] == -1 for s in taken)):
+        break
+    else:
+      return None
+    displacements[b] = d
+    for i, s in zip(bucket, taken):
+      slots[s] = i
+
+  return displacements, slots
+
+
+def ReadModules(z):
+  """Yields (module name, is_package, pyc contents)."""
+  for info in z.infolist():
+    rel_path = info.filename
+    if not rel_path.endswith('.pyc'):
+      continue  # resources are read from the zip
+
+    parts = rel_path[:-len('.pyc')].split('/')
+    is_package = parts[-1] == '__init__'
+    if is_package:
+      parts.pop()
+    yield '.'.join(parts), is_package, z.read(rel_path)
+
+
+def main(argv):
+  out_path = argv[1]
+
+  z = zipfile.ZipFile(sys.stdin)
+  modules = list(ReadModules(z))
+  if not modules:
+    raise RuntimeError('No .pyc files in zip')
+
+  pyc_magic = None
+  for name, _, pyc in modules:
+    if pyc_magic is None:
+      pyc_magic = pyc[:4]
+    elif pyc[:4] != pyc_magic:
+      raise RuntimeError('%s has a different bytecode magic number' % name)
+
+  names = [name for name, _, _ in modules]
+  num_buckets = max(1, len(names) // 4)
+  num_slots = len(names) + len(names) // 4 + 1
+  while True:
+    result = PerfectHash(names, num_slots, num_buckets)
+    if result:
+      break
+    num_slots += 1 + num_slots // 8  # load factor is too high
+  displacements, slots = result
+
+  buckets_off = HEADER.size
+  slots_off = buckets_off + 4 * num_buckets
+  strings_off = slots_off + SLOT.size * num_slots
+
+  strings = []
+  name_offs = []
+  pos = strings_off
+  for name in names:
+    name_offs.append(pos)
+    strings.append(name)
+    pos += len(name)
+
+  code = []
+  code_offs = []
+  for _, _, pyc in modules:
+    code_offs.append(pos)
+    code.append(pyc[8:])  # skip magic and mtime
+    pos += len(pyc) - 8
+
+  bundle_size = pos + TRAILER.size
+
+  with open(out_path, 'wb') as f:
+    f.write(HEADER.pack(MAGIC, VERSION, struct.unpack('<I', pyc_magic)[0],
+                        num_slots, num_buckets))
+    f.write(struct.pack('<%dI' % num_buckets, *displacements))
+    for i in slots:
+      if i == -1:
+        f.write(SLOT.pack(0, 0, 0, 0, 0))
+        continue
+      name, is_package, _ = modules[i]
+      flags = FLAG_PACKAGE if is_package else 0
+      f.write(SLOT.pack(name_offs[i], len(name), code_offs[i], len(code[i]),
+                        flags))
+    for s in strings:
+      f.write(s)
+    for c in code:
+      f.write(c)
+    f.write(TRAILER.pack(bundle_size, MAGIC))
+
+  print >>sys.stderr, 'make_bundle: %d modules in %d slots, %d bytes' % (
+      len(names), num_slots, bundle_size)
+
+
+if __name__ == '__main__':
+  try:
+    main(sys.argv)
+  except RuntimeError as e:
+    print >>sys.stderr, 'make_bundle:', e.args[0]
+    sys.exit(1)
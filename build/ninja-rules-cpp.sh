@@ -147,8 +147,8 @@ setglobal_compile_flags() {
       ;;
 
     (alloclog)
-      # debug flags
-      flags="$flags -O0 -g -D DUMB_ALLOC -D ALLOC_LOG"
+      # Attribute allocations to types.  See mycpp/alloc_log.h
+      flags="$flags -O2 -g -D ALLOC_LOG"
       ;;
 
     (*)
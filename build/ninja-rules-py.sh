@@ -200,6 +200,28 @@ benchmark-table() {
   } > $out
 }
 
+bench-task() {
+  ### Run a mycpp/bench binary, writing TSV
+
+  local bin=$1
+  local variant=$2  # e.g. 'opt' or 'cheney', for the first column
+  local out=$3
+
+  $bin $variant > $out
+}
+
+bench-table() {
+  local out=$1
+  shift
+
+  # Concatenate TSV files with the same header
+  { head -n 1 $1
+    for f in "$@"; do
+      tail -n +2 $f
+    done
+  } > $out
+}
+
 # For consistency, use the copy of MyPy in our mycpp dependencies
 mypy() {
   ( source $MYCPP_VENV/bin/activate
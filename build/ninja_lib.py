@@ -62,6 +62,9 @@ GC_PERF_VARIANTS = [
     # For tracing allocations, or debugging
     ('cxx', 'uftrace'),
 
+    # Histograms of allocations by type
+    ('cxx', 'alloclog'),
+
     # Less memory usage (but slower)
     ('cxx', 'opt32')
 ]
@@ -0,0 +1,168 @@
+#!/usr/bin/env bash
+#
+# Build a bytecode bundle with build/make_bundle.py, and import through
+# Modules/ovmimport.c.
+#
+# The importer is built as an extension module for the Python in $PREPARE_DIR,
+# so the bytecode magic matches and we don't need a full OVM build.
+#
+# Usage:
+#   build/ovm-bundle-test.sh <function name>
+#
+# Example:
+#   build/ovm-bundle-test.sh all
+
+set -o nounset
+set -o pipefail
+set -o errexit
+
+REPO_ROOT=$(cd $(dirname $0)/.. && pwd)
+readonly REPO_ROOT
+
+source build/common.sh  # $PREPARE_DIR, $PY27
+
+readonly TMP=_tmp/ovm-bundle-test
+readonly PYTHON=$PREPARE_DIR/python
+
+build-module() {
+  mkdir -p $TMP
+  cc -shared -fPIC -Wall -o $TMP/ovm_bundle_test.so \
+    -I $PY27/Include -I $PREPARE_DIR \
+    $PY27/Modules/ovmimport.c build/testdata/ovm_bundle_test.c
+}
+
+# Writes $TMP/app.ovm, which is a fake binary, then the bundle, then the zip.
+# zip_only isn't in the bundle, so it's imported with zipimport.
+make-app() {
+  rm -r -f $TMP/src
+  mkdir -p $TMP/src/pkg
+  echo 'x = "mod"' > $TMP/src/mod.py
+  echo 'x = "pkg"' > $TMP/src/pkg/__init__.py
+  echo 'x = "sub"' > $TMP/src/pkg/sub.py
+  echo 'x = "zip"' > $TMP/src/zip_only.py
+
+  $PYTHON -S - $TMP <<'PY'
+import os, py_compile, sys, zipfile
+tmp = sys.argv[1]
+for rel in ['mod', 'pkg/__init__', 'pkg/sub', 'zip_only']:
+  py_compile.compile('%s/src/%s.py' % (tmp, rel), doraise=True)
+
+def WriteZip(path, rels):
+  with zipfile.ZipFile(path, 'w') as z:
+    for rel in rels:
+      z.write('%s/src/%s.pyc' % (tmp, rel), rel + '.pyc')
+
+WriteZip(tmp + '/bundled.zip', ['mod', 'pkg/__init__', 'pkg/sub'])
+WriteZip(tmp + '/app.zip', ['mod', 'pkg/__init__', 'pkg/sub', 'zip_only'])
+PY
+
+  $PYTHON -S build/make_bundle.py $TMP/app.bundle < $TMP/bundled.zip
+
+  { echo 'not really a binary'
+    cat $TMP/app.bundle $TMP/app.zip
+  } > $TMP/app.ovm
+}
+
+# Usage: run-app APP EXPECTED_STATUS
+#
+# Installs the importer for APP, and checks where each module came from.
+run-app() {
+  local app=$1
+  local expected_status=$2
+
+  $PYTHON -S - $TMP $app $expected_status <<'PY'
+import sys
+tmp, app, expected_status = sys.argv[1], sys.argv[2], int(sys.argv[3])
+
+sys.path = [tmp]
+import ovm_bundle_test
+status = ovm_bundle_test.install(app)
+assert status == expected_status, status
+sys.path = [app]
+
+import mod, pkg.sub, zip_only
+assert (mod.x, pkg.x, pkg.sub.x, zip_only.x) == ('mod', 'pkg', 'sub', 'zip')
+
+from_bundle = status == 0
+for m in [mod, pkg, pkg.sub]:
+  is_ovm = type(m.__loader__).__name__ == 'ovmimporter'
+  assert is_ovm == from_bundle, (m, m.__loader__)
+assert type(zip_only.__loader__).__name__ == 'zipimporter'
+
+# Same paths as zipimport
+assert mod.__file__ == app + '/mod.pyc', mod.__file__
+assert pkg.__file__ == app + '/pkg/__init__.pyc', pkg.__file__
+assert pkg.__path__ == [app + '/pkg'], pkg.__path__
+print('OK %s status %d' % (app, status))
+PY
+}
+
+# Usage: corrupt-app OUT PYTHON_STATEMENT
+#
+# Copies app.ovm to OUT, and changes the bundle header or first slot with the
+# given statement, e.g. 'num_slots = 0'.
+corrupt-app() {
+  local out=$1
+  local stmt=$2
+
+  $PYTHON -S - $TMP/app.ovm $out "$stmt" <<'PY'
+import struct, sys
+src, out, stmt = sys.argv[1:]
+data = bytearray(open(src, 'rb').read())
+
+start = data.index(b'OVMB')
+magic, version, pyc_magic, num_slots, num_buckets = struct.unpack_from(
+    '<4sIIII', data, start)
+slot_off = start + 20 + 4 * num_buckets
+while struct.unpack_from('<I', data, slot_off + 4)[0] == 0:
+  slot_off += 20  # skip empty slots
+name_off, name_len, code_off, code_len, flags = struct.unpack_from(
+    '<IIIII', data, slot_off)
+
+exec stmt
+
+struct.pack_into('<4sIIII', data, start, magic, version, pyc_magic,
+                 num_slots, num_buckets)
+struct.pack_into('<IIIII', data, slot_off, name_off, name_len, code_off,
+                 code_len, flags)
+open(out, 'wb').write(data)
+PY
+}
+
+test-import() {
+  run-app $TMP/app.ovm 0
+}
+
+# The importer isn't installed for these, and everything comes from the zip.
+test-fallback() {
+  # No bundle at all
+  run-app $TMP/app.zip -1
+
+  local -a corruptions=(
+    'num_slots = 0'
+    'num_buckets = 0'
+    'num_buckets = 0xFFFFFFFF'
+    'num_slots = 0x10000000'
+    'name_off = 0xFFFFFFF0'
+    'code_len = len(data)'
+    'code_off = 0xFFFFFFFF'
+    'pyc_magic += 1'
+  )
+  local i=0
+  for stmt in "${corruptions[@]}"; do
+    local app=$TMP/corrupt-$i.ovm
+    corrupt-app $app "$stmt"
+    echo "$app: $stmt"
+    run-app $app -1
+    i=$((i + 1))
+  done
+}
+
+all() {
+  build-module
+  make-app
+  test-import
+  test-fallback
+}
+
+"$@"
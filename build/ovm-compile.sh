@@ -108,6 +108,7 @@ Objects/weakrefobject.c
 # Non-standard lib stuff.
 MODULE_OBJS='
 Modules/main.c
+Modules/ovmimport.c
 Modules/gcmodule.c
 '
 
@@ -391,6 +392,7 @@ make-tar() {
     build/clean.sh \
     build/common.sh \
     build/detect-*.c \
+    _build/$app_name/${bytecode_zip%.zip}.bundle \
     _build/$app_name/$bytecode_zip \
     _build/$app_name/*.c \
     py-yajl/yajl/COPYING \
@@ -56,6 +56,11 @@ _build/%/all-deps-c.txt: build/static-c-modules.txt _build/%/app-deps-c.txt
 _build/%/all-deps-py.txt: _build/%/py-to-compile.txt 
 	sort $^ | uniq > $@
 
+# Like the .zip, the bundle is built on the developer machine and included in
+# the tarball.
+_build/%.bundle: _build/%.zip build/make_bundle.py
+	build/make_bundle.py $@ < $<
+
 _build/opy/py27.grammar.marshal: opy/py27.grammar
 	bin/opyc pgen2 $^ $@
 
@@ -84,6 +89,7 @@ _build/%/module_init.c: $(PY27)/Modules/config.c.in _build/%/all-deps-c.txt
 # app source.
 
 _release/%.tar: _build/%/$(BYTECODE_ZIP) \
+                _build/%/$(BYTECODE_BUNDLE) \
                 _build/%/module_init.c \
                 _build/%/main_name.c \
                 _build/%/c-module-srcs.txt
@@ -0,0 +1,30 @@
+/* ovm_bundle_test.c: A Python module that calls OvmImport_Install().
+ *
+ * build/ovm-bundle-test.sh links it with Modules/ovmimport.c, so the importer
+ * can be tested with the Python in $PREPARE_DIR instead of a full OVM build.
+ */
+
+#include "Python.h"
+
+extern int OvmImport_Install(const char *ovm_path);
+
+static PyObject *
+install(PyObject *self, PyObject *args)
+{
+    char *ovm_path;
+
+    if (!PyArg_ParseTuple(args, "s:install", &ovm_path))
+        return NULL;
+    return PyInt_FromLong(OvmImport_Install(ovm_path));
+}
+
+static PyMethodDef methods[] = {
+    {"install", install, METH_VARARGS, NULL},
+    {NULL, NULL}  /* sentinel */
+};
+
+PyMODINIT_FUNC
+initovm_bundle_test(void)
+{
+    Py_InitModule("ovm_bundle_test", methods);
+}
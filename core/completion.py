@@ -1259,10 +1259,7 @@ class ReadlineCallback(object):
     self.debug_f = debug_f
 
     # current completion being processed
-    if mylib.PYTHON:
-      self.comp_iter = None # type: Iterator[str]
-    else:
-      self.comp_matches = None # type: List[str]
+    self.comp_iter = None # type: Iterator[str]
 
   def _GetNextCompletion(self, state):
     # type: (int) -> Optional[str]
@@ -1280,25 +1277,15 @@ class ReadlineCallback(object):
 
       comp = Api(line=buf, begin=begin, end=end)
 
-      if mylib.PYTHON:
-        self.comp_iter = self.root_comp.Matches(comp)
-      else:
-        it = self.root_comp.Matches(comp)
-        self.comp_matches = list(it)
-        self.comp_matches.reverse()
+      # Lazy in both Python and C++, so readline can stop after the first
+      # page of a big directory.
+      self.comp_iter = self.root_comp.Matches(comp)
 
-    if mylib.PYTHON:
-      assert self.comp_iter is not None, self.comp_iter
-      try:
-        next_completion = self.comp_iter.next()
-      except StopIteration:
-        next_completion = None  # signals the end
-    else:
-      assert self.comp_matches is not None, self.comp_matches
-      try:
-        next_completion = self.comp_matches.pop()
-      except IndexError:
-        next_completion = None  # signals the end
+    assert self.comp_iter is not None, self.comp_iter
+    try:
+      next_completion = self.comp_iter.next()
+    except StopIteration:
+      next_completion = None  # signals the end
 
     return next_completion
 
@@ -14,6 +14,7 @@ from _devbuild.gen.syntax_asdl import assign_op_e
 from asdl import runtime
 from core import error
 from core import optview
+from core import pyos
 from core import state
 from core import ui
 from core.pyerror import log
@@ -184,6 +185,27 @@ class ctx_Tracer(object):
     self.tracer.PopMessage(self.label, self.arg)
 
 
+class ctx_Profile(object):
+  """Ends a profile span if the command raised before ending it.
+
+  That happens for 'return' in a function, 'exit', and fatal errors.  The span
+  ends with status -1, so the span stack stays balanced.
+  """
+
+  def __init__(self, tracer, span_id):
+    # type: (Tracer, int) -> None
+    self.tracer = tracer
+    self.span_id = span_id
+
+  def __enter__(self):
+    # type: () -> None
+    pass
+
+  def __exit__(self, type, value, traceback):
+    # type: (Any, Any, Any) -> None
+    self.tracer.ProfileEnd(self.span_id, -1)
+
+
 def _PrintShValue(val, buf):
   # type: (value_t, mylib.BufWriter) -> None
   """Using maybe_shell_encode() for legacy xtrace_details."""
@@ -225,6 +247,20 @@ def _PrintArgv(argv, buf):
   buf.write('\n')
 
 
+# Profile events, for pyos.ProfileEvent()
+PROFILE_BEGIN = 1  # a simple command starts
+PROFILE_END = 2  # it finishes, with its kind and status
+PROFILE_FORK = 3  # a child process starts, with its pid
+PROFILE_EXEC = 4  # the current span replaces the process, without END
+PROFILE_EXIT = 5  # a child process was reaped, with its pid and status
+
+# What a simple command turned out to be.  Known only after it starts.
+PROFILE_KIND_OTHER = 0  # assignment-like, not found, etc.
+PROFILE_KIND_BUILTIN = 1
+PROFILE_KIND_EXTERNAL = 2
+PROFILE_KIND_PROC = 3
+
+
 class Tracer(object):
   """For shell's set -x, and Oil's hierarchical, parsable tracing.
 
@@ -280,6 +316,13 @@ class Tracer(object):
     self.lval_punct = lvalue.Named('SHX_punct')
     self.lval_pid_str = lvalue.Named('SHX_pid_str')
 
+    # For the binary profile.  Spans are simple commands; the stack is copied
+    # into child processes, so they know their parent span.
+    self.profile_fd = -1
+    self.next_span_id = 0
+    self.span_stack = []  # type: List[int]
+    self.span_kinds = []  # type: List[int]
+
   def CheckCircularDeps(self):
     # type: () -> None
     assert self.word_ev is not None
@@ -359,8 +402,95 @@ class Tracer(object):
     buf.write(prefix)
     return buf
 
+  #
+  # Binary profile: one span per simple command.  See doc/xtrace.md.
+  #
+
+  def InitProfile(self, fd):
+    # type: (int) -> None
+    pyos.ProfileInit(fd)
+    self.profile_fd = fd
+
+  def ProfileBegin(self, argv):
+    # type: (List[str]) -> int
+    """Returns a span ID to pass to ProfileEnd(), or -1 if disabled."""
+    if self.profile_fd == -1 or not self.exec_opts.profile():
+      return -1
+
+    span_id = self.next_span_id
+    self.next_span_id += 1
+    parent_id = self._ProfileParent()
+    self.span_stack.append(span_id)
+    self.span_kinds.append(PROFILE_KIND_OTHER)
+
+    name = ''
+    if len(argv):
+      name = argv[0]
+    pyos.ProfileEvent(PROFILE_BEGIN, PROFILE_KIND_OTHER, span_id, parent_id,
+                      -1, 0, name)
+    return span_id
+
+  def ProfileEnd(self, span_id, status):
+    # type: (int, int) -> None
+    """Ends the innermost span.  Does nothing if it already ended.
+
+    ctx_Profile calls this again when the command is done.
+    """
+    if span_id == -1:
+      return
+    if len(self.span_stack) == 0 or self.span_stack[-1] != span_id:
+      return
+
+    self.span_stack.pop()
+    kind = self.span_kinds.pop()
+    pyos.ProfileEvent(PROFILE_END, kind, span_id, -1, -1, status, '')
+
+  def _ProfileParent(self):
+    # type: () -> int
+    if len(self.span_stack):
+      return self.span_stack[-1]
+    return -1
+
+  def _ProfileSetKind(self, kind):
+    # type: (int) -> None
+    """The first hook to run determines the kind of the current span."""
+    if len(self.span_kinds) and self.span_kinds[-1] == PROFILE_KIND_OTHER:
+      self.span_kinds[-1] = kind
+
+  def _ProfileFork(self, pid, why):
+    # type: (int, trace_t) -> None
+    if self.profile_fd == -1:
+      return
+
+    name = ''
+    UP_why = why
+    with tagswitch(why) as case:
+      if case(trace_e.External):
+        self._ProfileSetKind(PROFILE_KIND_EXTERNAL)
+        why = cast(trace__External, UP_why)
+        name = why.argv[0]
+      elif case(trace_e.ForkWait):
+        name = 'forkwait'
+      elif case(trace_e.CommandSub):
+        name = 'command sub'
+      elif case(trace_e.ProcessSub):
+        name = 'proc sub'
+      elif case(trace_e.HereDoc):
+        name = 'here doc'
+      elif case(trace_e.Fork):
+        name = 'fork'
+      elif case(trace_e.PipelinePart):
+        name = 'part'
+      else:
+        raise AssertionError()
+
+    pyos.ProfileEvent(PROFILE_FORK, PROFILE_KIND_OTHER, -1,
+                      self._ProfileParent(), pid, 0, name)
+
   def OnProcessStart(self, pid, why):
     # type: (int, trace_t) -> None
+    self._ProfileFork(pid, why)
+
     buf = self._RichTraceBegin('|')
     if not buf:
       return
@@ -399,6 +529,11 @@ class Tracer(object):
 
   def OnProcessEnd(self, pid, status):
     # type: (int, int) -> None
+    if self.profile_fd != -1:
+      # Ends spans that were replaced by exec()
+      pyos.ProfileEvent(PROFILE_EXIT, PROFILE_KIND_OTHER, -1, -1, pid, status,
+                        '')
+
     buf = self._RichTraceBegin(';')
     if not buf:
       return
@@ -417,6 +552,9 @@ class Tracer(object):
   def PushMessage(self, label, argv):
     # type: (str, Optional[List[str]]) -> None
     """For synchronous constructs that aren't processes."""
+    if label == 'proc' and self.profile_fd != -1:
+      self._ProfileSetKind(PROFILE_KIND_PROC)
+
     buf = self._RichTraceBegin('>')
     if buf:
       buf.write(label)
@@ -459,6 +597,10 @@ class Tracer(object):
 
   def OnExec(self, argv):
     # type: (List[str]) -> None
+    if self.profile_fd != -1 and len(self.span_stack):
+      pyos.ProfileEvent(PROFILE_EXEC, PROFILE_KIND_EXTERNAL,
+                        self.span_stack[-1], -1, -1, 0, '')
+
     buf = self._RichTraceBegin('.')
     if not buf:
       return
@@ -468,6 +610,9 @@ class Tracer(object):
 
   def OnBuiltin(self, builtin_id, argv):
     # type: (builtin_t, List[str]) -> None
+    if self.profile_fd != -1:
+      self._ProfileSetKind(PROFILE_KIND_BUILTIN)
+
     if builtin_id in (builtin_i.eval, builtin_i.source, builtin_i.wait):
       return  # These 3 builtins handled separately
 
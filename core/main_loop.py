@@ -197,7 +197,11 @@ def Interactive(flag, cmd_ev, c_parser, display, prompt_plugin, errfmt):
   status = 0
   done = False
   while not done:
-    mylib.MaybeCollect()  # manual GC point
+    # manual GC point
+    mylib.MaybeCollect()
+    # After a lot of allocation, also free dead objects and return memory to
+    # the OS, before we wait for input
+    mylib.IdleCollect()
 
     # - This loop has a an odd structure because we want to do cleanup after
     # every 'break'.  (The ones without 'done = True' were 'continue')
@@ -488,6 +488,11 @@ class ChildStateChange(object):
     # type: () -> None
     raise NotImplementedError()
 
+  def AppendFdActions(self, actions):
+    # type: (List[int]) -> None
+    """Describe what Apply() does, for posix.spawn_child()."""
+    raise NotImplementedError()
+
 
 class StdinFromPipe(ChildStateChange):
   def __init__(self, pipe_read_fd, w):
@@ -507,6 +512,15 @@ class StdinFromPipe(ChildStateChange):
     posix.close(self.w)  # we're reading from the pipe, not writing
     #log('child CLOSE w %d pid=%d', self.w, posix.getpid())
 
+  def AppendFdActions(self, actions):
+    # type: (List[int]) -> None
+    actions.append(self.r)
+    actions.append(0)
+    actions.append(self.r)
+    actions.append(-1)
+    actions.append(self.w)
+    actions.append(-1)
+
 
 class StdoutToPipe(ChildStateChange):
   def __init__(self, r, pipe_write_fd):
@@ -526,6 +540,15 @@ class StdoutToPipe(ChildStateChange):
     posix.close(self.r)  # we're writing to the pipe, not reading
     #log('child CLOSE r %d pid=%d', self.r, posix.getpid())
 
+  def AppendFdActions(self, actions):
+    # type: (List[int]) -> None
+    actions.append(self.w)
+    actions.append(1)
+    actions.append(self.w)
+    actions.append(-1)
+    actions.append(self.r)
+    actions.append(-1)
+
 
 class ExternalProgram(object):
   """The capability to execute an external program like 'ls'. """
@@ -559,6 +582,12 @@ class ExternalProgram(object):
     self._Exec(argv0_path, cmd_val.argv, cmd_val.arg_spids[0], environ, True)
     assert False, "This line should never execute" # NO RETURN
 
+  def CanSpawn(self):
+    # type: () -> bool
+    """Can posix.spawn_child() be used instead of fork() and Exec()?"""
+    # Looking at the shebang line is done in Python
+    return len(self.hijack_shebang) == 0
+
   def _Exec(self, argv0_path, argv, argv0_spid, environ, should_retry):
     # type: (str, List[str], int, Dict[str, str], bool) -> None
     if len(self.hijack_shebang):
@@ -587,6 +616,7 @@ class ExternalProgram(object):
         finally:  # TODO: use context manager
           f.close()
 
+    pyos.ProfileFlush()  # exec() discards buffers
     try:
       posix.execve(argv0_path, argv, environ)
     except OSError as e:
@@ -675,6 +705,29 @@ class ExternalThunk(Thunk):
     self.ext_prog.Exec(self.argv0_path, self.cmd_val, self.environ)
 
 
+if mylib.PYTHON:
+  def _SpawnExternal(thunk, fd_actions):
+    # type: (ExternalThunk, List[int]) -> int
+    """Start an external program in a child process, and return its PID.
+
+    Like fork() and then ExternalThunk.Run(), but the child doesn't run any
+    Python code.
+    """
+    ext_prog = thunk.ext_prog
+    cmd_val = thunk.cmd_val
+    # Same signals as Process.Start()
+    pid, err, used_sh = posix.spawn_child(
+        thunk.argv0_path, cmd_val.argv, thunk.environ, fd_actions,
+        [SIGPIPE, SIGQUIT, SIGTSTP, SIGTTOU, SIGTTIN])
+    if err != 0:
+      # The child exited with 126 or 127, like ExternalProgram._Exec()
+      path = '/bin/sh' if used_sh else thunk.argv0_path
+      ext_prog.errfmt.Print_(
+          "Can't execute %r: %s" % (path, posix.strerror(err)),
+          span_id=cmd_val.arg_spids[0])
+    return pid
+
+
 class SubProgramThunk(Thunk):
   """A subprogram that can be executed in another process."""
 
@@ -723,6 +776,7 @@ class SubProgramThunk(Thunk):
     # If ProcessInit() doesn't turn off buffering, this is needed before
     # _exit()
     pyos.FlushStdout()
+    pyos.ProfileFlush()
 
     # We do NOT want to raise SystemExit here.  Otherwise dev.Tracer::Pop()
     # gets called in BOTH processes.
@@ -759,6 +813,7 @@ class _HereDocWriterThunk(Thunk):
     posix.close(self.w)
     #log('Closed %d', self.w)
 
+    pyos.ProfileFlush()
     posix._exit(0)
 
 
@@ -885,6 +940,22 @@ class Process(Job):
     #
     # The whole job control mechanism is complicated and hacky.
 
+    # Otherwise buffered profile records would be written by both processes
+    pyos.ProfileFlush()
+
+    if mylib.PYTHON:
+      # Fast path for external commands: the child is set up and exec'd in C
+      if (isinstance(self.thunk, ExternalThunk) and
+          self.thunk.ext_prog.CanSpawn()):
+        fd_actions = []  # type: List[int]
+        for st in self.state_changes:
+          st.AppendFdActions(fd_actions)
+        pid = _SpawnExternal(self.thunk, fd_actions)
+        self.tracer.OnProcessStart(pid, why)
+        self.pid = pid
+        self.job_state.AddChildProcess(pid, self)
+        return pid
+
     pid = posix.fork()
     if pid < 0:
       # When does this happen?
@@ -58,7 +58,8 @@ class ProcessTest(unittest.TestCase):
                                             util.NullDebugFile())
 
   def _ExtProc(self, argv):
-    arg_vec = cmd_value.Argv(argv, [0] * len(argv))
+    # The arena is empty, so errors are printed without a location
+    arg_vec = cmd_value.Argv(argv, [runtime.NO_SPID] * len(argv))
     argv0_path = None
     for path_entry in ['/bin', '/usr/bin']:
       full_path = os.path.join(path_entry, argv[0])
@@ -114,7 +115,8 @@ class ProcessTest(unittest.TestCase):
 
     Banner('does-not-exist')
     p = self._ExtProc(['does-not-exist'])
-    print(p.RunWait(self.waiter, why))
+    status = p.RunWait(self.waiter, why)
+    self.assertEqual(127, status)
 
     # 12 file descriptors open!
     print('FDS AFTER', os.listdir('/dev/fd'))
@@ -6,10 +6,12 @@ Like py{error,util}.py, it won't be translated to C++.
 from __future__ import print_function
 
 from errno import EINTR
+import atexit
 import pwd
 import resource
 import signal
 import select
+import struct
 import sys
 import termios  # for read -n
 import time
@@ -223,6 +225,75 @@ def Time():
   return t, u.ru_utime, u.ru_stime
 
 
+# Binary profile written by dev.Tracer.  Records are buffered, and flushed in
+# chunks of at most PIPE_BUF bytes, so each write() is atomic even when forked
+# processes share the fd.  Layout (little endian):
+#
+#   chunk:  'OILP' pid:i32 len:i32 reserved:i32   then len bytes of records
+#   record: event:u8 kind:u8 name_len:u16 span_id:i32 parent_id:i32
+#           child_pid:i32 status:i32 reserved:i32 t_ns:i64   then name bytes
+#
+# benchmarks/profile_trace.py converts it to Chrome trace JSON and folded
+# stacks.
+
+PROFILE_CHUNK_SIZE = 4096  # PIPE_BUF on Linux
+_PROFILE_CHUNK_HEADER = struct.Struct('<4siii')
+_PROFILE_RECORD = struct.Struct('<BBHiiiiiq')
+_PROFILE_MAX_NAME = 255
+
+_profile_fd = -1
+_profile_buf = []  # type: List[str]
+_profile_len = 0
+
+
+def ProfileInit(fd):
+  # type: (int) -> None
+  """Start writing profile records to the given fd."""
+  global _profile_fd
+  if _profile_fd == -1:
+    atexit.register(ProfileFlush)
+  _profile_fd = fd
+
+
+def ProfileEvent(event, kind, span_id, parent_id, child_pid, status, name):
+  # type: (int, int, int, int, int, int, str) -> None
+  """Append a record with the current time.
+
+  Note: CPython 2 has no monotonic clock, so this uses time.time().  The C++
+  version uses CLOCK_MONOTONIC.
+  """
+  global _profile_len
+  if _profile_fd == -1:
+    return
+
+  name = name[:_PROFILE_MAX_NAME]
+  t_ns = int(time.time() * 1e9)
+  rec = _PROFILE_RECORD.pack(event, kind, len(name), span_id, parent_id,
+                             child_pid, status, 0, t_ns) + name
+
+  if _profile_len + len(rec) > PROFILE_CHUNK_SIZE - _PROFILE_CHUNK_HEADER.size:
+    ProfileFlush()
+  _profile_buf.append(rec)
+  _profile_len += len(rec)
+
+
+def ProfileFlush():
+  # type: () -> None
+  """Write buffered records.  Called before fork(), exec(), and _exit()."""
+  global _profile_len
+  if _profile_fd == -1 or _profile_len == 0:
+    return
+
+  chunk = _PROFILE_CHUNK_HEADER.pack('OILP', posix.getpid(), _profile_len, 0)
+  chunk += ''.join(_profile_buf)
+  del _profile_buf[:]
+  _profile_len = 0
+  try:
+    posix.write(_profile_fd, chunk)
+  except OSError:
+    pass  # the profile is best effort
+
+
 def PrintTimes():
   # type: () -> None
   utime, stime, cutime, cstime, elapsed = posix.times()
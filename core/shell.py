@@ -352,6 +352,18 @@ def Main(lang, arg_r, environ, login_shell, loader, readline):
   tracer = dev.Tracer(parse_ctx, exec_opts, mutable_opts, mem, trace_f)
   fd_state.tracer = tracer  # circular dep
 
+  # A raw fd, like OIL_GC_STATS_FD, so the profile doesn't mix with the
+  # script's output
+  profile_fd_str = environ.get('OIL_PROFILE_FD', '')
+  if len(profile_fd_str):
+    try:
+      profile_fd = int(profile_fd_str)
+    except ValueError:
+      profile_fd = -1
+    if profile_fd >= 0:
+      tracer.InitProfile(profile_fd)
+      mutable_opts.set_profile()
+
   trap_state = builtin_trap.TrapState()
   trap_state.InitShell()
   waiter = process.Waiter(job_state, exec_opts, trap_state, tracer)
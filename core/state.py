@@ -639,6 +639,11 @@ class MutableOpts(object):
     # type: (bool) -> None
     self._Set(option_i.xtrace, b)
 
+  def set_profile(self):
+    # type: () -> None
+    """When $OIL_PROFILE_FD is set."""
+    self._Set(option_i.profile, True)
+
   def _SetArrayByNum(self, opt_num, b):
     # type: (int, bool) -> None
     if (opt_num in consts.PARSE_OPTION_NUMS and
@@ -856,6 +861,14 @@ class _ArgFrame(object):
 
   def GetArgv(self):
     # type: () -> List[str]
+    """The returned list must not be mutated.
+
+    It's shared with the frame when nothing is shifted, so "$@" doesn't copy
+    all the args.  This is safe because the argv of a frame is never mutated
+    in place: set -- replaces it, and shift only changes num_shifted.
+    """
+    if self.num_shifted == 0:
+      return self.argv
     return self.argv[self.num_shifted : ]
 
   def GetNumArgs(self):
@@ -1580,6 +1593,28 @@ class Mem(object):
 
     raise AssertionError()
 
+  def _LookupCell(self, name, which_scopes):
+    # type: (str, scope_t) -> Optional[cell]
+    """Like _ResolveNameOnly(), but for reading.
+
+    It doesn't return the name_map, so the common cases don't allocate a tuple.
+    """
+    if which_scopes == scope_e.Dynamic:
+      for i in xrange(len(self.var_stack) - 1, -1, -1):
+        cell = self.var_stack[i].get(name)
+        if cell:
+          return cell
+      return None
+
+    if which_scopes == scope_e.LocalOrGlobal:
+      cell = self.var_stack[-1].get(name)
+      if cell:
+        return cell
+      return self.var_stack[0].get(name)
+
+    cell, _ = self._ResolveNameOnly(name, which_scopes)
+    return cell
+
   def _ResolveNameOrRef(self, name, which_scopes, is_setref, ref_trail=None):
     # type: (str, scope_t, bool, Optional[List[str]]) -> Tuple[Optional[cell], Dict[str, cell], str]
     """Look up a cell and namespace, but respect the nameref flag.
@@ -1906,7 +1941,8 @@ class Mem(object):
       # TODO:
       # - Reuse the MaybeStrArray?
       # - @@ could be an alias for ARGV (in command mode, but not expr mode)
-      return value.MaybeStrArray(self.GetArgv())
+      # A copy, since Oil code can mutate it
+      return value.MaybeStrArray(list(self.GetArgv()))
 
     # "Registers"
     if name == '_status':
@@ -2007,7 +2043,9 @@ class Mem(object):
     # 1. Call self.unsafe_arith.ParseVarRef() -> braced_var_sub
     # 2. Call self.unsafe_arith.GetNameref(bvs_part), and get a value_t
     #    We still need a ref_trail to detect cycles.
-    cell, _, _ = self._ResolveNameOrRef(name, which_scopes, False)
+    cell = self._LookupCell(name, which_scopes)
+    if cell and cell.nameref:
+      cell, _, _ = self._ResolveNameOrRef(name, which_scopes, False)
     if cell:
       return cell.val
 
@@ -313,6 +313,23 @@ class MemTest(unittest.TestCase):
     mem.SetArgv(['i', 'j', 'k'])
     self.assertEqual(['i', 'j', 'k'], mem.GetArgv())
 
+  def testArgvShared(self):
+    mem = _InitMem()
+    argv = ['a', 'b']
+    mem.PushCall('my-func', 0, argv)
+
+    # "$@" doesn't copy the args
+    self.assertTrue(argv is mem.GetArgv())
+
+    # ARGV is a copy, since Oil code can mutate it
+    val = mem.GetValue('ARGV')
+    self.assertEqual(['a', 'b'], val.strs)
+    self.assertFalse(val.strs is argv)
+
+    mem.Shift(1)
+    self.assertEqual(['b'], mem.GetArgv())
+    self.assertEqual(['a', 'b'], argv)
+
 
 if __name__ == '__main__':
   unittest.main()
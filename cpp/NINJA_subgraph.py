@@ -119,10 +119,14 @@ def NinjaGraph(ru):
       srcs = ['cpp/fanos.cc'],
       deps = ['//cpp/fanos_shared', '//mycpp/runtime'])
 
+  ru.cc_library(
+      '//cpp/glob_shared', 
+      srcs = ['cpp/glob_shared.c'])
+
   ru.cc_library(
       '//cpp/libc', 
       srcs = ['cpp/libc.cc'],
-      deps = ['//mycpp/runtime'])
+      deps = ['//cpp/glob_shared', '//mycpp/runtime'])
 
   ru.cc_binary(
       'cpp/libc_test.cc', 
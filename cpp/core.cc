@@ -7,6 +7,8 @@
 #include <math.h>  // fmod()
 #include <pwd.h>   // passwd
 #include <signal.h>
+#include <stdlib.h>        // atexit()
+#include <string.h>        // memcpy()
 #include <sys/resource.h>  // getrusage
 #include <sys/stat.h>      // stat
 #include <sys/times.h>     // tms / times()
@@ -200,6 +202,80 @@ void PrintTimes() {
   putc('\n', stdout);
 }
 
+// Records are buffered and written in chunks of at most PIPE_BUF bytes, so
+// each write() is atomic even when forked processes share the fd.
+const int kProfileChunkSize = 4096;
+const int kProfileChunkHeader = 16;
+const int kProfileRecordHeader = 32;
+const int kProfileMaxName = 255;
+
+static int gProfileFd = -1;
+static bool gProfileAtExit = false;
+static char gProfileBuf[kProfileChunkSize];
+static int gProfileLen = kProfileChunkHeader;  // after the chunk header
+
+static inline void PutInt32(char* p, int32_t i) {
+  memcpy(p, &i, sizeof(i));  // little endian on the platforms we support
+}
+
+void ProfileInit(int fd) {
+  if (!gProfileAtExit) {
+    atexit(ProfileFlush);
+    gProfileAtExit = true;
+  }
+  gProfileFd = fd;
+}
+
+void ProfileEvent(int event, int kind, int span_id, int parent_id,
+                  int child_pid, int status, Str* name) {
+  if (gProfileFd == -1) {
+    return;
+  }
+
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  int64_t t_ns = static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+
+  int name_len = len(name);
+  if (name_len > kProfileMaxName) {
+    name_len = kProfileMaxName;
+  }
+  if (gProfileLen + kProfileRecordHeader + name_len > kProfileChunkSize) {
+    ProfileFlush();
+  }
+
+  char* p = gProfileBuf + gProfileLen;
+  p[0] = static_cast<char>(event);
+  p[1] = static_cast<char>(kind);
+  uint16_t n16 = name_len;
+  memcpy(p + 2, &n16, sizeof(n16));
+  PutInt32(p + 4, span_id);
+  PutInt32(p + 8, parent_id);
+  PutInt32(p + 12, child_pid);
+  PutInt32(p + 16, status);
+  PutInt32(p + 20, 0);
+  memcpy(p + 24, &t_ns, sizeof(t_ns));
+  memcpy(p + kProfileRecordHeader, name->data_, name_len);
+
+  gProfileLen += kProfileRecordHeader + name_len;
+}
+
+void ProfileFlush() {
+  if (gProfileFd == -1 || gProfileLen == kProfileChunkHeader) {
+    return;
+  }
+
+  memcpy(gProfileBuf, "OILP", 4);
+  PutInt32(gProfileBuf + 4, getpid());
+  PutInt32(gProfileBuf + 8, gProfileLen - kProfileChunkHeader);
+  PutInt32(gProfileBuf + 12, 0);
+
+  // Best effort: errors are ignored
+  int unused = ::write(gProfileFd, gProfileBuf, gProfileLen);
+  (void)unused;
+  gProfileLen = kProfileChunkHeader;
+}
+
 bool InputAvailable(int fd) {
   FAIL(kNotImplemented);
 }
@@ -74,6 +74,12 @@ Tuple3<double, double, double> Time();
 
 void PrintTimes();
 
+// Binary profile for dev.Tracer.  See core/pyos.py for the format.
+void ProfileInit(int fd);
+void ProfileEvent(int event, int kind, int span_id, int parent_id,
+                  int child_pid, int status, Str* name);
+void ProfileFlush();
+
 bool InputAvailable(int fd);
 
 inline void FlushStdout() {
@@ -3,6 +3,7 @@
 #include <errno.h>        // errno
 #include <fcntl.h>        // O_RDWR
 #include <signal.h>       // SIG*, kill()
+#include <string.h>       // memcpy()
 #include <sys/stat.h>     // stat
 #include <sys/utsname.h>  // uname
 #include <unistd.h>       // getpid(), getuid(), environ
@@ -297,6 +298,49 @@ TEST dir_cache_key_test() {
   PASS();
 }
 
+TEST profile_test() {
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+
+  pyos::ProfileInit(fds[1]);
+  pyos::ProfileEvent(1, 0, 0, -1, -1, 0, StrFromC("foo"));
+
+  // Names are truncated to 255 bytes
+  Str* long_name = NewStr(300);
+  memset(long_name->data_, 'x', 300);
+  pyos::ProfileEvent(2, 1, 0, -1, -1, 42, long_name);
+  pyos::ProfileFlush();
+  pyos::ProfileFlush();  // nothing more to write
+
+  char buf[4096];
+  int n = ::read(fds[0], buf, sizeof(buf));
+  int expected = 16 + (32 + 3) + (32 + 255);
+  ASSERT_EQ_FMT(expected, n, "%d");
+
+  ASSERT_EQ(0, memcmp(buf, "OILP", 4));
+  int32_t i;
+  memcpy(&i, buf + 4, 4);
+  ASSERT_EQ_FMT(getpid(), i, "%d");
+  memcpy(&i, buf + 8, 4);
+  ASSERT_EQ_FMT(expected - 16, i, "%d");
+
+  char* rec = buf + 16;
+  ASSERT_EQ(1, rec[0]);
+  ASSERT_EQ(3, rec[2]);  // name_len
+  ASSERT_EQ(0, memcmp(rec + 32, "foo", 3));
+
+  rec += 32 + 3;
+  ASSERT_EQ(2, rec[0]);
+  memcpy(&i, rec + 16, 4);
+  ASSERT_EQ_FMT(42, i, "%d");  // status
+
+  pyos::ProfileInit(-1);  // disable the flush at exit
+  close(fds[0]);
+  close(fds[1]);
+
+  PASS();
+}
+
 GREATEST_MAIN_DEFS();
 
 int main(int argc, char** argv) {
@@ -317,6 +361,7 @@ int main(int argc, char** argv) {
   RUN_TEST(signal_test);
   RUN_TEST(passwd_test);
   RUN_TEST(dir_cache_key_test);
+  RUN_TEST(profile_test);
 
   gHeap.CleanProcessExit();
 
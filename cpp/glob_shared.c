@@ -0,0 +1,656 @@
+// For memmem() and FNM_EXTMATCH
+#define _GNU_SOURCE 1
+
+#include "cpp/glob_shared.h"
+
+#include <fnmatch.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wctype.h>
+
+#ifdef FNM_EXTMATCH
+  #define FNMATCH_FLAGS FNM_EXTMATCH
+#else
+  #define FNMATCH_FLAGS 0
+#endif
+
+//
+// UTF-8
+//
+
+// Bytes that aren't part of a valid sequence are decoded as themselves, with
+// this bit set, so they never equal a code point.
+#define INVALID_BYTE 0x80000000u
+
+// Decodes the character at s[i] into *ch, and returns its length in bytes.
+static int DecodeChar(const unsigned char* s, int n, int i, uint32_t* ch) {
+  unsigned char b = s[i];
+  if (b < 0x80) {
+    *ch = b;
+    return 1;
+  }
+
+  int len;
+  uint32_t c;
+  if (0xC2 <= b && b <= 0xDF) {
+    len = 2;
+    c = b & 0x1F;
+  } else if (0xE0 <= b && b <= 0xEF) {
+    len = 3;
+    c = b & 0x0F;
+  } else if (0xF0 <= b && b <= 0xF4) {
+    len = 4;
+    c = b & 0x07;
+  } else {
+    *ch = INVALID_BYTE | b;
+    return 1;
+  }
+
+  if (i + len > n) {
+    *ch = INVALID_BYTE | b;
+    return 1;
+  }
+  for (int j = 1; j < len; ++j) {
+    unsigned char cont = s[i + j];
+    if ((cont & 0xC0) != 0x80) {
+      *ch = INVALID_BYTE | b;
+      return 1;
+    }
+    c = (c << 6) | (cont & 0x3F);
+  }
+  *ch = c;
+  return len;
+}
+
+//
+// Compiler
+//
+
+enum StepKind {
+  STEP_CHAR,   // a literal character
+  STEP_ANY,    // ?
+  STEP_CLASS,  // [abc] [!a-z] [[:alpha:]]
+  STEP_STAR,   // *
+};
+
+typedef struct {
+  int kind;
+  uint32_t ch;      // STEP_CHAR
+  int first_item;   // STEP_CLASS: items[first_item, first_item + num_items)
+  int num_items;
+  int negated;
+} Step;
+
+// One item in a [...] class: a range of characters, or a named class
+typedef struct {
+  uint32_t lo;
+  uint32_t hi;
+  wctype_t named;  // nonzero for [:alpha:] etc.
+} ClassItem;
+
+typedef struct {
+  Step* steps;
+  int num_steps;
+  ClassItem* items;
+  int num_items;
+
+  // Literal bytes at the start and end of the pattern
+  const char* prefix;  // points into pat
+  int prefix_len;
+  int prefix_steps;
+  const char* suffix;
+  int suffix_len;
+  int all_literal;  // the pattern is just prefix
+  int bad_range;    // e.g. [z-a], which matches nothing
+
+  // NFA state: the start position of the best thread in each of the
+  // num_steps + 1 states, or -1
+  int* cur;
+  int* next;
+} GlobProgram;
+
+static void FreeProgram(GlobProgram* prog) {
+  if (prog == NULL) {
+    return;
+  }
+  free(prog->steps);
+  free(prog->items);
+  free(prog->cur);
+  free(prog->next);
+  free(prog);
+}
+
+static int IsExtglobOp(const char* pat, int pat_len, int i) {
+  return i + 1 < pat_len && pat[i + 1] == '(' &&
+         strchr("?*+@!", pat[i]) != NULL;
+}
+
+// Decodes a possibly backslash-escaped char inside [], and returns the
+// position after it.
+static int ClassChar(const char* pat, int pat_len, int i, uint32_t* ch) {
+  if (pat[i] == '\\' && i + 1 < pat_len) {
+    i++;
+  }
+  return i + DecodeChar((const unsigned char*)pat, pat_len, i, ch);
+}
+
+// Parses [...] starting at pat[i] == '['.  Returns the position after the
+// closing ], or -1 if the class can't be compiled.
+//
+// A [ without a ] is usually a literal, but libc's rules for that are subtle,
+// so those patterns aren't compiled.
+static int ParseClass(GlobProgram* prog, const char* pat, int pat_len, int i,
+                      Step* step) {
+  int j = i + 1;
+  step->kind = STEP_CLASS;
+  step->first_item = prog->num_items;
+  step->num_items = 0;
+  step->negated = 0;
+  if (j < pat_len && (pat[j] == '!' || pat[j] == '^')) {
+    step->negated = 1;
+    j++;
+  }
+
+  int first = 1;
+  while (1) {
+    if (j >= pat_len) {
+      return -1;  // no closing ]
+    }
+    if (pat[j] == ']' && !first) {
+      return j + 1;
+    }
+    first = 0;
+
+    ClassItem* item = &prog->items[prog->num_items];
+    item->named = 0;
+
+    if (pat[j] == '[' && j + 1 < pat_len &&
+        (pat[j + 1] == '=' || pat[j + 1] == '.')) {
+      return -1;  // equivalence classes and collating symbols
+    }
+
+    if (pat[j] == '[' && j + 1 < pat_len && pat[j + 1] == ':') {
+      const char* name = pat + j + 2;
+      const char* close = strstr(name, ":]");
+      if (close == NULL || close >= pat + pat_len) {
+        return -1;
+      }
+      char buf[16];
+      int name_len = close - name;
+      if (name_len >= (int)sizeof(buf)) {
+        return -1;
+      }
+      memcpy(buf, name, name_len);
+      buf[name_len] = '\0';
+      item->named = wctype(buf);
+      if (item->named == 0) {
+        return -1;
+      }
+      j = close + 2 - pat;
+    } else {
+      j = ClassChar(pat, pat_len, j, &item->lo);
+      item->hi = item->lo;
+      if (j + 1 < pat_len && pat[j] == '-' && pat[j + 1] != ']') {
+        j = ClassChar(pat, pat_len, j + 1, &item->hi);
+        if (item->hi < item->lo) {
+          prog->bad_range = 1;
+        }
+      }
+    }
+    prog->num_items++;
+    step->num_items++;
+  }
+}
+
+// Returns NULL if the pattern can't be compiled, e.g. for extended globs.
+static GlobProgram* Compile(const char* pat, int pat_len) {
+  GlobProgram* prog = (GlobProgram*)calloc(1, sizeof(GlobProgram));
+  // Each step and class item consumes at least one byte of the pattern
+  prog->steps = (Step*)malloc(sizeof(Step) * (pat_len + 1));
+  prog->items = (ClassItem*)malloc(sizeof(ClassItem) * (pat_len + 1));
+
+  int in_prefix = 1;
+  int suffix_start = 0;  // start of the trailing run of literal bytes
+
+  int i = 0;
+  while (i < pat_len) {
+    Step* step = &prog->steps[prog->num_steps];
+    int start = i;
+    int literal_start = i;  // where the bytes of a literal char are
+
+    if (IsExtglobOp(pat, pat_len, i)) {
+      FreeProgram(prog);
+      return NULL;
+    }
+
+    char c = pat[i];
+    if (c == '*') {
+      while (i < pat_len && pat[i] == '*' && !IsExtglobOp(pat, pat_len, i)) {
+        i++;  // ** is the same as *
+      }
+      step->kind = STEP_STAR;
+    } else if (c == '?') {
+      step->kind = STEP_ANY;
+      i++;
+    } else if (c == '[') {
+      i = ParseClass(prog, pat, pat_len, start, step);
+      if (i == -1) {
+        FreeProgram(prog);
+        return NULL;
+      }
+    } else if (c == '\\' && i + 1 == pat_len) {
+      // A trailing backslash is an error in libc, so let it decide
+      FreeProgram(prog);
+      return NULL;
+    } else {
+      if (c == '\\') {
+        i++;
+        literal_start = i;
+      }
+      step->kind = STEP_CHAR;
+      i += DecodeChar((const unsigned char*)pat, pat_len, i, &step->ch);
+    }
+
+    if (step->kind == STEP_CHAR) {
+      // The prefix and suffix are bytes of the pattern, so they stop at
+      // escaped chars, e.g. a\*b has the prefix 'a'.  They also stop at
+      // invalid UTF-8, which may decode differently in the string.
+      int plain = literal_start == start && !(step->ch & INVALID_BYTE);
+      if (in_prefix && plain) {
+        prog->prefix_len = i;
+        prog->prefix_steps = prog->num_steps + 1;
+      } else {
+        in_prefix = 0;
+      }
+      if (!plain) {
+        suffix_start = i;
+      }
+    } else {
+      in_prefix = 0;
+      suffix_start = i;
+    }
+    prog->num_steps++;
+  }
+
+  prog->prefix = pat;
+  prog->suffix = pat + suffix_start;
+  prog->suffix_len = pat_len - suffix_start;
+  prog->all_literal = prog->prefix_len == pat_len;
+  if (!prog->all_literal && suffix_start < prog->prefix_len) {
+    prog->suffix_len = 0;  // it overlaps with the prefix
+  }
+
+  prog->cur = (int*)malloc(sizeof(int) * (prog->num_steps + 1));
+  prog->next = (int*)malloc(sizeof(int) * (prog->num_steps + 1));
+  return prog;
+}
+
+//
+// Cache of compiled patterns
+//
+
+#define CACHE_SIZE 64  // power of 2
+
+typedef struct {
+  char* pat;  // NULL if the entry is empty
+  int pat_len;
+  GlobProgram* prog;  // NULL if the pattern can't be compiled
+} CacheEntry;
+
+static CacheEntry gCache[CACHE_SIZE];
+
+// Returns NULL if the pattern can't be compiled.
+static GlobProgram* CompileCached(const char* pat, int pat_len) {
+  unsigned h = 2166136261u;  // FNV-1a
+  for (int i = 0; i < pat_len; ++i) {
+    h ^= (unsigned char)pat[i];
+    h *= 16777619u;
+  }
+  CacheEntry* e = &gCache[h & (CACHE_SIZE - 1)];
+  if (e->pat != NULL && e->pat_len == pat_len &&
+      memcmp(e->pat, pat, pat_len) == 0) {
+    return e->prog;
+  }
+
+  // Evict the old pattern
+  free(e->pat);
+  FreeProgram(e->prog);
+
+  e->pat = (char*)malloc(pat_len + 1);
+  memcpy(e->pat, pat, pat_len);
+  e->pat[pat_len] = '\0';
+  e->pat_len = pat_len;
+  e->prog = Compile(e->pat, pat_len);  // prefix and suffix point into e->pat
+  return e->prog;
+}
+
+//
+// NFA
+//
+
+static int StepMatches(GlobProgram* prog, Step* step, uint32_t ch) {
+  switch (step->kind) {
+  case STEP_CHAR:
+    return step->ch == ch;
+  case STEP_ANY:
+    return 1;
+  case STEP_CLASS: {
+    int found = 0;
+    for (int i = 0; i < step->num_items; ++i) {
+      ClassItem* item = &prog->items[step->first_item + i];
+      if (item->named) {
+        if (!(ch & INVALID_BYTE) && iswctype(ch, item->named)) {
+          found = 1;
+          break;
+        }
+      } else if (item->lo <= ch && ch <= item->hi) {
+        found = 1;
+        break;
+      }
+    }
+    return found != step->negated;
+  }
+  default:
+    return 0;  // STEP_STAR is handled by the caller
+  }
+}
+
+static void Clear(GlobProgram* prog, int* states) {
+  for (int q = 0; q <= prog->num_steps; ++q) {
+    states[q] = -1;
+  }
+}
+
+// Adds a thread in state q that started at 'start', and follows * steps,
+// which can match nothing.  When two threads are in the same state, they
+// have the same future, so only the one with the lowest (or highest) start
+// is kept.
+static void AddThread(GlobProgram* prog, int* states, int q, int start,
+                      int keep_max) {
+  while (1) {
+    int old = states[q];
+    if (old != -1 && (keep_max ? start <= old : start >= old)) {
+      return;  // a better thread is already here
+    }
+    states[q] = start;
+    if (q < prog->num_steps && prog->steps[q].kind == STEP_STAR) {
+      q++;
+    } else {
+      return;
+    }
+  }
+}
+
+// Moves the threads in prog->cur past the character 'ch', into prog->next,
+// and swaps them.  Returns whether any thread is alive.
+static int Advance(GlobProgram* prog, uint32_t ch, int keep_max) {
+  int* cur = prog->cur;
+  int* next = prog->next;
+  Clear(prog, next);
+
+  int alive = 0;
+  for (int q = 0; q < prog->num_steps; ++q) {
+    int start = cur[q];
+    if (start == -1) {
+      continue;
+    }
+    Step* step = &prog->steps[q];
+    if (step->kind == STEP_STAR) {
+      AddThread(prog, next, q, start, keep_max);
+      alive = 1;
+    } else if (StepMatches(prog, step, ch)) {
+      AddThread(prog, next, q + 1, start, keep_max);
+      alive = 1;
+    }
+  }
+
+  prog->cur = next;
+  prog->next = cur;
+  return alive;
+}
+
+static int HasPrefix(GlobProgram* prog, const char* s, int s_len) {
+  return s_len >= prog->prefix_len &&
+         memcmp(s, prog->prefix, prog->prefix_len) == 0;
+}
+
+static int HasSuffix(GlobProgram* prog, const char* s, int s_len) {
+  return s_len >= prog->suffix_len &&
+         memcmp(s + s_len - prog->suffix_len, prog->suffix,
+                prog->suffix_len) == 0;
+}
+
+//
+// Fallback for extended globs
+//
+
+// fnmatch() on s[start:end]
+static int FnmatchSlice(const char* pat, const char* s, int start, int end) {
+  char* buf = (char*)malloc(end - start + 1);
+  memcpy(buf, s + start, end - start);
+  buf[end - start] = '\0';
+  int ret = fnmatch(pat, buf, FNMATCH_FLAGS);
+  free(buf);
+  return ret == 0;
+}
+
+static int NextChar(const char* s, int s_len, int i) {
+  uint32_t ch;
+  return i + DecodeChar((const unsigned char*)s, s_len, i, &ch);
+}
+
+//
+// API
+//
+
+int glob_match(const char* pat, int pat_len, const char* s, int s_len) {
+  GlobProgram* prog = CompileCached(pat, pat_len);
+  if (prog == NULL) {
+    switch (fnmatch(pat, s, FNMATCH_FLAGS)) {
+    case 0:
+      return 1;
+    case FNM_NOMATCH:
+      return 0;
+    default:
+      return -1;
+    }
+  }
+
+  if (prog->all_literal) {
+    return s_len == pat_len && memcmp(s, pat, pat_len) == 0;
+  }
+  if (s_len < prog->prefix_len + prog->suffix_len ||
+      !HasPrefix(prog, s, s_len) || !HasSuffix(prog, s, s_len)) {
+    return 0;
+  }
+
+  // Start after the literal prefix
+  Clear(prog, prog->cur);
+  AddThread(prog, prog->cur, prog->prefix_steps, 0, 0);
+  int i = prog->prefix_len;
+  while (i < s_len) {
+    uint32_t ch;
+    i += DecodeChar((const unsigned char*)s, s_len, i, &ch);
+    if (!Advance(prog, ch, 0)) {
+      return 0;
+    }
+  }
+  return prog->cur[prog->num_steps] != -1;
+}
+
+int glob_match_prefix(const char* pat, int pat_len, const char* s, int s_len,
+                      int longest) {
+  GlobProgram* prog = CompileCached(pat, pat_len);
+  if (prog == NULL) {
+    int result = -1;
+    int i = 0;
+    while (1) {
+      if (FnmatchSlice(pat, s, 0, i)) {
+        result = i;
+        if (!longest) {
+          break;
+        }
+      }
+      if (i >= s_len) {
+        break;
+      }
+      i = NextChar(s, s_len, i);
+    }
+    return result;
+  }
+
+  if (!HasPrefix(prog, s, s_len)) {
+    return -1;
+  }
+
+  int result = -1;
+  Clear(prog, prog->cur);
+  AddThread(prog, prog->cur, prog->prefix_steps, 0, 0);
+  int i = prog->prefix_len;
+  while (1) {
+    if (prog->cur[prog->num_steps] != -1) {
+      result = i;
+      if (!longest) {
+        break;
+      }
+    }
+    if (i >= s_len) {
+      break;
+    }
+    uint32_t ch;
+    i += DecodeChar((const unsigned char*)s, s_len, i, &ch);
+    if (!Advance(prog, ch, 0)) {
+      break;
+    }
+  }
+  return result;
+}
+
+int glob_match_suffix(const char* pat, int pat_len, const char* s, int s_len,
+                      int longest) {
+  GlobProgram* prog = CompileCached(pat, pat_len);
+  if (prog == NULL) {
+    int result = -1;
+    int i = 0;
+    while (1) {
+      if (FnmatchSlice(pat, s, i, s_len)) {
+        result = i;
+        if (longest) {
+          break;
+        }
+      }
+      if (i >= s_len) {
+        break;
+      }
+      i = NextChar(s, s_len, i);
+    }
+    return result;
+  }
+
+  if (!HasSuffix(prog, s, s_len)) {
+    return -1;
+  }
+
+  // Start a thread at every position.  At the end, the accepting state has
+  // the lowest start for the longest suffix, or the highest for the shortest.
+  int keep_max = !longest;
+  Clear(prog, prog->cur);
+  int i = 0;
+  while (1) {
+    AddThread(prog, prog->cur, 0, i, keep_max);
+    if (i >= s_len) {
+      break;
+    }
+    uint32_t ch;
+    i += DecodeChar((const unsigned char*)s, s_len, i, &ch);
+    Advance(prog, ch, keep_max);
+  }
+  return prog->cur[prog->num_steps];
+}
+
+int glob_search(const char* pat, int pat_len, const char* s, int s_len,
+                int pos, int* start, int* end) {
+  GlobProgram* prog = CompileCached(pat, pat_len);
+  if (prog == NULL) {
+    // Leftmost, then longest
+    int i = pos;
+    while (i <= s_len) {
+      int j = glob_match_prefix(pat, pat_len, s + i, s_len - i, 1);
+      if (j != -1) {
+        *start = i;
+        *end = i + j;
+        return 1;
+      }
+      if (i >= s_len) {
+        break;
+      }
+      i = NextChar(s, s_len, i);
+    }
+    return 0;
+  }
+  if (prog->bad_range) {
+    return -1;
+  }
+
+  // memmem() can skip to a position only if it's a character boundary.  Lead
+  // bytes and ASCII are always on one.
+  int can_skip = prog->prefix_len > 0 &&
+                 ((unsigned char)prog->prefix[0] < 0x80 ||
+                  (unsigned char)prog->prefix[0] >= 0xC0);
+
+  int best_start = -1;
+  int best_end = -1;
+  int alive = 0;
+
+  Clear(prog, prog->cur);
+  int i = pos;
+  while (1) {
+    if (best_start == -1) {  // start another thread
+      if (!alive && can_skip) {
+        const char* p = (const char*)memmem(s + i, s_len - i, prog->prefix,
+                                            prog->prefix_len);
+        if (p == NULL) {
+          break;
+        }
+        i = p - s;
+      }
+      AddThread(prog, prog->cur, 0, i, 0);
+    }
+
+    int accepted = prog->cur[prog->num_steps];
+    if (accepted != -1 && (best_start == -1 || accepted <= best_start)) {
+      best_start = accepted;
+      best_end = i;
+    }
+
+    if (i >= s_len) {
+      break;
+    }
+    uint32_t ch;
+    i += DecodeChar((const unsigned char*)s, s_len, i, &ch);
+    alive = Advance(prog, ch, 0);
+
+    if (best_start != -1) {
+      // Threads that started later can't give a better match
+      alive = 0;
+      for (int q = 0; q <= prog->num_steps; ++q) {
+        if (prog->cur[q] > best_start) {
+          prog->cur[q] = -1;
+        } else if (prog->cur[q] != -1) {
+          alive = 1;
+        }
+      }
+      if (!alive) {
+        break;
+      }
+    }
+  }
+
+  if (best_start == -1) {
+    return 0;
+  }
+  *start = best_start;
+  *end = best_end;
+  return 1;
+}
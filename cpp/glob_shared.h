@@ -0,0 +1,46 @@
+#ifndef GLOB_SHARED_H
+#define GLOB_SHARED_H
+
+// Glob matching for fnmatch() and the string operations ${x#pat},
+// ${x%pat}, ${x/pat/rep}, and case and [[ == ]].
+//
+// This library is shared between cpp/ and pyext/.
+//
+// A pattern is compiled to a sequence of steps.  Each step matches one
+// character (a literal, ? or [...]) or any number of characters (*).  The steps
+// are run as an NFA over the string, one UTF-8 character at a time, so
+// matching is linear in the length of the string times the number of steps.
+// There's no backtracking.
+//
+// Compiled patterns are kept in a small cache keyed by the pattern string.  A
+// literal prefix and suffix are extracted at compile time, to reject strings
+// early and to skip ahead with memmem().
+//
+// Extended globs like @(foo|bar) aren't compiled.  For those, these functions
+// fall back on libc's fnmatch() with FNM_EXTMATCH, in a loop.
+//
+// All positions are byte offsets on character boundaries.  Strings must be
+// NUL-terminated, for the fallback.
+
+// Like fnmatch(pat, s, FNM_EXTMATCH).  Returns 1 for a match, 0 for no match,
+// and -1 for an error.
+int glob_match(const char* pat, int pat_len, const char* s, int s_len);
+
+// Returns the end of the shortest or longest prefix of s that matches pat, or
+// -1 if none does.
+int glob_match_prefix(const char* pat, int pat_len, const char* s, int s_len,
+                      int longest);
+
+// Returns the start of the shortest or longest suffix of s that matches pat,
+// or -1 if none does.
+int glob_match_suffix(const char* pat, int pat_len, const char* s, int s_len,
+                      int longest);
+
+// Finds the leftmost-longest match of pat in s that starts at or after 'pos'.
+// Returns 1 and sets *start and *end, or returns 0 if there's no match.
+// Returns -1 if pat has a reversed range like [z-a].  (The other functions
+// treat that as no match, like fnmatch().)
+int glob_search(const char* pat, int pat_len, const char* s, int s_len,
+                int pos, int* start, int* end);
+
+#endif  // GLOB_SHARED_H
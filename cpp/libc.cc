@@ -3,7 +3,6 @@
 #include "cpp/libc.h"
 
 #include <errno.h>
-#include <fnmatch.h>
 #include <glob.h>
 #include <locale.h>
 #include <regex.h>
@@ -11,6 +10,8 @@
 #include <unistd.h>  // gethostname()
 #include <wchar.h>
 
+#include "cpp/glob_shared.h"
+
 namespace libc {
 
 Str* gethostname() {
@@ -35,17 +36,33 @@ Str* realpath(Str* path) {
 }
 
 int fnmatch(Str* pat, Str* str) {
-  int flags = FNM_EXTMATCH;
-  int result = ::fnmatch(pat->data_, str->data_, flags);
-  switch (result) {
-  case 0:
-    return 1;
-  case FNM_NOMATCH:
-    return 0;
-  default:
-    // Other error
-    return -1;
+  return glob_match(pat->data_, len(pat), str->data_, len(str));
+}
+
+int fnmatch_prefix(Str* pat, Str* str, bool longest) {
+  return glob_match_prefix(pat->data_, len(pat), str->data_, len(str),
+                           longest);
+}
+
+int fnmatch_suffix(Str* pat, Str* str, bool longest) {
+  return glob_match_suffix(pat->data_, len(pat), str->data_, len(str),
+                           longest);
+}
+
+Tuple2<int, int>* fnmatch_search(Str* pat, Str* str, int pos) {
+  if (pos < 0 || pos > len(str)) {
+    throw Alloc<ValueError>();
+  }
+  int start, end;
+  int ret = glob_search(pat->data_, len(pat), str->data_, len(str), pos, &start,
+                        &end);
+  if (ret == -1) {
+    throw Alloc<RuntimeError>(StrFromC("Invalid range in glob"));
+  }
+  if (ret == 0) {
+    return nullptr;
   }
+  return Alloc<Tuple2<int, int>>(start, end);
 }
 
 List<Str*>* glob(Str* pat) {
@@ -22,6 +22,14 @@ Str* gethostname();
 
 int fnmatch(Str* pat, Str* str);
 
+// For ${x#pat} and ${x%pat}: the end of the matching prefix, or the start of
+// the matching suffix.  -1 if there's none.
+int fnmatch_prefix(Str* pat, Str* str, bool longest);
+int fnmatch_suffix(Str* pat, Str* str, bool longest);
+
+// For ${x/pat/rep}: the leftmost-longest match starting at or after pos.
+Tuple2<int, int>* fnmatch_search(Str* pat, Str* str, int pos);
+
 List<Str*>* glob(Str* pat);
 
 Tuple2<int, int>* regex_first_group_match(Str* pattern, Str* str, int pos);
@@ -61,6 +61,23 @@ TEST libc_test() {
   ASSERT(libc::fnmatch(StrFromC("*(foo|bar).py"), StrFromC("foo.py")));
   ASSERT(!libc::fnmatch(StrFromC("*(foo|bar).py"), StrFromC("foo.p")));
 
+  // ? is one UTF-8 character
+  ASSERT(libc::fnmatch(StrFromC("?"), StrFromC("\xce\xbc")));
+  ASSERT(!libc::fnmatch(StrFromC("??"), StrFromC("\xce\xbc")));
+
+  Str* path = StrFromC("dir/sub/file.tar.gz");
+  ASSERT_EQ_FMT(4, libc::fnmatch_prefix(StrFromC("*/"), path, false), "%d");
+  ASSERT_EQ_FMT(8, libc::fnmatch_prefix(StrFromC("*/"), path, true), "%d");
+  ASSERT_EQ_FMT(-1, libc::fnmatch_prefix(StrFromC("x*"), path, true), "%d");
+  ASSERT_EQ_FMT(16, libc::fnmatch_suffix(StrFromC(".*"), path, false), "%d");
+  ASSERT_EQ_FMT(12, libc::fnmatch_suffix(StrFromC(".*"), path, true), "%d");
+  ASSERT_EQ_FMT(-1, libc::fnmatch_suffix(StrFromC("*x"), path, true), "%d");
+
+  Tuple2<int, int>* span = libc::fnmatch_search(StrFromC("f*."), path, 0);
+  ASSERT_EQ_FMT(8, span->at0(), "%d");
+  ASSERT_EQ_FMT(17, span->at1(), "%d");  // longest: file.tar.
+  ASSERT_EQ(nullptr, libc::fnmatch_search(StrFromC("f*."), path, 9));
+
   List<Str*>* results =
       libc::regex_match(StrFromC("(a+).(a+)"), StrFromC("-abaacaaa"));
   ASSERT_EQ_FMT(3, len(results), "%d");
@@ -36,6 +36,37 @@ def DummyToken(id_, val):
   return Token(id_, col, length, line_id, runtime.NO_SPID, val)
 
 
+# The values of these tokens are interned.  They're names, which are looked up
+# in dicts.  Arbitrary words (Lit_Chars) aren't, since interned strings live
+# for the whole process in C++.
+_INTERN_IDS = [
+    Id.Lit_VarLike, Id.Lit_ArithVarLike, Id.VSub_Name, Id.VSub_DollarName
+]  # type: List[Id_t]
+
+
+if mylib.PYTHON:
+  # Tokens of these kinds are created without a value in LineLexer.Read()
+  _NO_VALUE_KINDS = (
+      Kind.Arith, Kind.Op, Kind.VTest, Kind.VOp0, Kind.VOp2, Kind.VOp3,
+      Kind.WS, Kind.Ignored, Kind.Eof
+  )
+
+  def _InitReadToken():
+    # type: () -> None
+    from _devbuild.gen.id_kind import ID_TO_KIND
+
+    table = ['\0'] * (max(ID_TO_KIND) + 1)
+    for id_, kind in ID_TO_KIND.iteritems():
+      if kind in _NO_VALUE_KINDS:
+        table[id_] = '\1'
+    for id_ in _INTERN_IDS:
+      table[id_] = '\2'
+    match.fastlex.InitReadToken(Token, ''.join(table))
+
+  if match.fastlex:
+    _InitReadToken()
+
+
 class LineLexer(object):
   def __init__(self, line, arena):
     # type: (str, Arena) -> None
@@ -176,6 +207,18 @@ class LineLexer(object):
 
   def Read(self, lex_mode):
     # type: (lex_mode_t) -> Token
+    if mylib.PYTHON:
+      # The fastlex extension does everything below in one call
+      if match.fastlex:
+        t = match.fastlex.ReadToken(lex_mode, self.line, self.line_pos,
+                                    self.line_id, self.arena.tokens,
+                                    self.replace_last_token)
+        if t is None:
+          return _EOL_TOK
+        self.replace_last_token = False
+        self.line_pos = t.col + t.length
+        return t
+
     # Inner loop optimization
     line = self.line
     line_pos = self.line_pos
@@ -195,12 +238,16 @@ class LineLexer(object):
     # - Kind.ControlFlow doesn't work because we word_.StaticEval()
     # if kind in (Kind.Lit, Kind.VSub, Kind.Redir, Kind.Char, Kind.Backtick, Kind.KW, Kind.Right):
 
+    # Keep in sync with _NO_VALUE_KINDS
     if kind in (Kind.Arith, Kind.Op,
         Kind.VTest, Kind.VOp0, Kind.VOp2, Kind.VOp3,
         Kind.WS, Kind.Ignored, Kind.Eof):
       tok_val = None  # type: Optional[str]
     else:
       tok_val = line[line_pos:end_pos]
+      # Names are looked up in dicts, so equal names should share one string.
+      if tok_type in _INTERN_IDS:
+        tok_val = mylib.Intern(tok_val)
     # NOTE: We're putting the arena hook in LineLexer and not Lexer because we
     # want it to be "low level".  The only thing fabricated here is a newline
     # added at the last line, so we don't end with \0.
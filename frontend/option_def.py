@@ -255,6 +255,10 @@ def _Init(opt_def):
   opt_def.Add('failglob')
   opt_def.Add('extglob')
 
+  # Binary per-command profile, written to $OIL_PROFILE_FD.  Setting the env
+  # var turns it on.  See doc/xtrace.md.
+  opt_def.Add('profile')
+
   # Compatibility
   opt_def.Add('eval_unsafe_arith')  # recursive parsing and evaluation (ble.sh)
   opt_def.Add('parse_dynamic_arith')  # dynamic LHS
@@ -9,6 +9,16 @@ import sys
 
 from build.ninja_lib import log, COMPILERS_VARIANTS, COMPILERS_VARIANTS_LEAKY
 
+# mycpp/bench binaries are built and run for each GC variant
+BENCH_VARIANTS = ['opt', 'bumpleak', 'cheney', 'tcmalloc']
+
+CHENEY_TEST_MATRIX = [
+    ('cxx', 'asan', '-D CHENEY_GC'),
+    ('cxx', 'ubsan', '-D CHENEY_GC'),
+    ('cxx', 'gcalways', '-D CHENEY_GC'),
+    ('clang', 'coverage', '-D CHENEY_GC'),
+]
+
 def DefineTargets(ru):
 
   ru.py_binary(
@@ -20,22 +30,12 @@ def DefineTargets(ru):
       '//mycpp/cheney_heap', 
       srcs = ['mycpp/cheney_heap.cc'])
 
-  # special test with -D
-  ru.cc_binary(
-      'mycpp/cheney_heap_test.cc',
-      deps = ['//mycpp/cheney_heap'],
-      matrix = [
-        ('cxx', 'asan', '-D CHENEY_GC'),
-        ('cxx', 'ubsan', '-D CHENEY_GC'),
-        ('clang', 'coverage', '-D CHENEY_GC'),
-      ],
-      phony_prefix = 'mycpp-unit')
-
   ru.cc_library(
       '//mycpp/runtime', 
       # TODO: separate into //mycpp/runtime_{marksweep,bumpleak,cheney}
       deps = [ '//mycpp/cheney_heap' ],
       srcs = [
+        'mycpp/alloc_log.cc',
         'mycpp/bump_leak_heap.cc',
         'mycpp/gc_builtins.cc',
         'mycpp/gc_mylib.cc',
@@ -44,6 +44,13 @@ def DefineTargets(ru):
       ]
   )
 
+  # Special test with -D
+  ru.cc_binary(
+      'mycpp/cheney_heap_test.cc',
+      deps = ['//mycpp/runtime'],
+      matrix = CHENEY_TEST_MATRIX,
+      phony_prefix = 'mycpp-unit')
+
   # Special test with -D
   ru.cc_binary(
       'mycpp/bump_leak_heap_test.cc',
@@ -63,7 +70,9 @@ def DefineTargets(ru):
       'mycpp/gc_builtins_test.cc',
       'mycpp/gc_mylib_test.cc',
 
+      'mycpp/gc_deque_test.cc',
       'mycpp/gc_dict_test.cc',
+      'mycpp/gc_generator_test.cc',
       'mycpp/gc_list_test.cc',
       'mycpp/gc_str_test.cc',
       'mycpp/gc_tuple_test.cc',
@@ -76,6 +85,24 @@ def DefineTargets(ru):
         matrix = COMPILERS_VARIANTS,
         phony_prefix = 'mycpp-unit')
 
+  # The containers also run on the copying collector, which moves objects
+  for test_main in [
+      'mycpp/gc_builtins_test.cc',
+      'mycpp/gc_mylib_test.cc',
+
+      'mycpp/gc_deque_test.cc',
+      'mycpp/gc_dict_test.cc',
+      'mycpp/gc_generator_test.cc',
+      'mycpp/gc_list_test.cc',
+      'mycpp/gc_str_test.cc',
+      'mycpp/gc_tuple_test.cc',
+  ]:
+    ru.cc_binary(
+        test_main,
+        deps = ['//mycpp/runtime'],
+        matrix = CHENEY_TEST_MATRIX,
+        phony_prefix = 'mycpp-unit')
+
   for test_main in [
       'mycpp/demo/gc_header.cc',
       'mycpp/demo/hash_table.cc',
@@ -88,6 +115,16 @@ def DefineTargets(ru):
         matrix = COMPILERS_VARIANTS + [('cxx', 'opt32')],
         phony_prefix = 'mycpp-unit')
 
+  ru.cc_library(
+      '//mycpp/bench/harness',
+      srcs = ['mycpp/bench/bench.cc'])
+
+  ru.cc_binary(
+      'mycpp/bench/runtime_bench.cc',
+      deps = ['//mycpp/bench/harness', '//mycpp/runtime'],
+      matrix = [('cxx', v) for v in BENCH_VARIANTS],
+      phony_prefix = 'mycpp-bench')
+
   # ASDL schema that examples/parse.py depends on
   ru.asdl_library('mycpp/examples/expr.asdl')
 
@@ -268,6 +305,14 @@ def NinjaGraph(ru):
          command='build/ninja-rules-py.sh benchmark-table $out $in',
          description='benchmark-table $out $in')
   n.newline()
+  n.rule('bench-task',
+         command='build/ninja-rules-py.sh bench-task $in $variant $out',
+         description='bench-task $in $variant $out')
+  n.newline()
+  n.rule('bench-table',
+         command='build/ninja-rules-py.sh bench-table $out $in',
+         description='bench-table $out $in')
+  n.newline()
 
   # For simplicity, this is committed to the repo.  We could also have
   # build/dev.sh minimal generate it?
@@ -291,6 +336,9 @@ def NinjaGraph(ru):
 
       # NOTE: _test/benchmark-table.tsv isn't included in any phony target
 
+      # Run mycpp/bench for each GC variant, and make _test/mycpp-bench.tsv
+      'mycpp-bench': [],
+
       # Targets dynamically added:
       #
       # mycpp-unit-$compiler-$variant
@@ -411,3 +459,17 @@ def NinjaGraph(ru):
   n.build([out], 'benchmark-table', benchmark_tasks)
   n.newline()
 
+  # Micro-benchmarks of the runtime.  Run them serially with ninja -j 1.
+  bench_tsv = []
+  for variant in BENCH_VARIANTS:
+    b = '_bin/cxx-%s/mycpp/bench/runtime_bench' % variant
+    tsv = '_test/bench/runtime_bench.%s.tsv' % variant
+    n.build([tsv], 'bench-task', [b], variables=[('variant', variant)])
+    n.newline()
+    bench_tsv.append(tsv)
+
+  out = '_test/mycpp-bench.tsv'
+  n.build([out], 'bench-table', bench_tsv)
+  n.newline()
+  ru.phony['mycpp-bench'].append(out)
+
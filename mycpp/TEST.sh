@@ -244,10 +244,6 @@ test-runtime() {
     local bin=_bin/cxx-$variant-D_BUMP_LEAK/mycpp/bump_leak_heap_test
     ninja $bin
     run-test-bin $bin
-
-    local bin=_bin/cxx-$variant-D_CHENEY_GC/mycpp/cheney_heap_test
-    ninja $bin
-    run-test-bin $bin
   done
 
   # Run other tests with all variants
@@ -256,6 +252,11 @@ test-runtime() {
 
   unit '' asan
   unit '' gcalways
+
+  # cheney_heap_test and the container tests, with the copying collector
+  unit '' asan-D_CHENEY_GC
+  unit '' ubsan-D_CHENEY_GC
+  unit '' gcalways-D_CHENEY_GC
 }
 
 #
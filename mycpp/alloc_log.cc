@@ -0,0 +1,111 @@
+#include "mycpp/alloc_log.h"
+
+// Every runtime variant links this file, but only the alloclog variant uses
+// it.
+#ifdef ALLOC_LOG
+
+#include <inttypes.h>  // PRId64
+#include <stdio.h>     // fopen()
+#include <stdlib.h>    // getenv()
+#include <string.h>    // strstr()
+
+#include <string>
+
+// Defined by the GNU linker.  Call sites are written relative to it.
+extern char __executable_start;
+
+void AllocLog::Record(const char* type_name, int type_tag, int obj_len) {
+  if (num_records_ == kRingSize) {
+    Flush();
+  }
+  AllocRecord* r = &ring_[num_records_++];
+  r->type_name = type_name;
+  r->call_site = __builtin_return_address(0);
+  r->obj_len = obj_len;
+  r->type_tag = type_tag;
+}
+
+void AllocLog::Flush() {
+  for (int i = 0; i < num_records_; ++i) {
+    AllocRecord* r = &ring_[i];
+
+    by_type_[std::make_pair(r->type_name, r->obj_len)]++;
+
+    SiteStats& s = by_site_[std::make_pair(r->call_site, r->type_name)];
+    s.count++;
+    s.bytes += r->obj_len;
+
+    type_tags_[r->type_name] = r->type_tag;
+  }
+  num_records_ = 0;
+}
+
+// "const char* TypeName() [with T = List<Str*>]" -> "List<Str*>"
+static std::string ExtractTypeName(const char* pretty) {
+  const char* p = strstr(pretty, "T = ");
+  if (p == nullptr) {
+    return pretty;
+  }
+  p += 4;
+  std::string s(p);
+  // Remove trailing ]
+  if (!s.empty() && s.back() == ']') {
+    s.pop_back();
+  }
+  return s;
+}
+
+void AllocLog::Dump() {
+  Flush();
+
+  // Each instantiation may have a string per translation unit, so merge by
+  // name
+  char* path = getenv("OIL_ALLOC_LOG");
+  if (path && strlen(path)) {
+    std::map<std::pair<std::string, uint32_t>, int64_t> merged;
+    std::map<std::string, int> tags;
+    for (auto& it : by_type_) {
+      std::string name = ExtractTypeName(it.first.first);
+      merged[std::make_pair(name, it.first.second)] += it.second;
+      tags[name] = type_tags_[it.first.first];
+    }
+
+    FILE* f = fopen(path, "w");
+    if (f == nullptr) {
+      log("alloclog: couldn't open %s", path);
+    } else {
+      fprintf(f, "type_name\ttype_tag\tobj_len\tcount\n");
+      for (auto& it : merged) {
+        fprintf(f, "%s\t%d\t%u\t%" PRId64 "\n", it.first.first.c_str(),
+                tags[it.first.first], it.first.second, it.second);
+      }
+      fclose(f);
+    }
+  }
+
+  path = getenv("OIL_ALLOC_LOG_SITES");
+  if (path && strlen(path)) {
+    FILE* f = fopen(path, "w");
+    if (f == nullptr) {
+      log("alloclog: couldn't open %s", path);
+    } else {
+      // The offsets only help 'addr2line -e BINARY' on PIE builds.  A non-PIE
+      // binary is linked at a fixed address, so its call sites are already
+      // absolute; add &__executable_start back to the offset before lookup.
+      fprintf(f, "call_site\ttype_name\tcount\tbytes\n");
+      for (auto& it : by_site_) {
+        uintptr_t offset = reinterpret_cast<uintptr_t>(it.first.first) -
+                           reinterpret_cast<uintptr_t>(&__executable_start);
+        fprintf(f, "0x%lx\t%s\t%" PRId64 "\t%" PRId64 "\n",
+                static_cast<unsigned long>(offset),
+                ExtractTypeName(it.first.second).c_str(), it.second.count,
+                it.second.bytes);
+      }
+      fclose(f);
+    }
+  }
+}
+
+AllocLog gAllocLog;
+
+#endif  // ALLOC_LOG
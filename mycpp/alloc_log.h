@@ -0,0 +1,82 @@
+// mycpp/alloc_log.h: Attribute allocations to types, in the alloclog variant
+//
+// With -D ALLOC_LOG, Alloc<T>(), NewStr(), and NewSlab<T>() call
+// gAllocLog.Record() after the object is constructed, when its header is
+// valid.  Records go in a fixed-size ring, which is folded into exact
+// histograms when it fills up:
+//
+// - by (type, obj_len) -> count.  Written to $OIL_ALLOC_LOG as TSV.
+// - by (call site, type) -> count, bytes.  Written to $OIL_ALLOC_LOG_SITES.
+//
+// The type name comes from the template argument, e.g. List<Str*> or
+// syntax_asdl::Token, because type_tag alone is ambiguous: every mycpp class
+// is TypeTag::OtherClass, and ASDL variant tags are only unique within a sum
+// type.
+//
+// benchmarks/alloclog.sh runs the variant and summarizes the output.
+
+#ifndef MYCPP_ALLOC_LOG_H
+#define MYCPP_ALLOC_LOG_H
+
+#include <stdint.h>  // uint32_t
+
+#include <map>
+#include <utility>  // std::pair
+
+#include "mycpp/common.h"
+
+// Returns a string with static storage, like
+//   const char* TypeName() [with T = List<Str*>]
+// AllocLog::Dump() extracts the type.
+template <typename T>
+const char* TypeName() {
+  return __PRETTY_FUNCTION__;
+}
+
+struct AllocRecord {
+  const char* type_name;  // from TypeName<T>()
+  void* call_site;        // return address of Record()
+  uint32_t obj_len;
+  uint8_t type_tag;
+};
+
+class AllocLog {
+ public:
+  AllocLog() : num_records_(0) {
+  }
+
+  // Not inlined, so the return address is in the function that allocated
+  void Record(const char* type_name, int type_tag, int obj_len);
+
+  // Fold the ring into the histograms
+  void Flush();
+
+  // Write TSV files named by OIL_ALLOC_LOG and OIL_ALLOC_LOG_SITES, if set
+  void Dump();
+
+  static const int kRingSize = 4096;
+
+  AllocRecord ring_[kRingSize];
+  int num_records_;
+
+  // (type name, obj_len) -> count
+  std::map<std::pair<const char*, uint32_t>, int64_t> by_type_;
+
+  struct SiteStats {
+    int64_t count;
+    int64_t bytes;
+  };
+  // (call site, type name) -> stats
+  std::map<std::pair<void*, const char*>, SiteStats> by_site_;
+
+  // type name -> type_tag
+  std::map<const char*, int> type_tags_;
+
+  DISALLOW_COPY_AND_ASSIGN(AllocLog);
+};
+
+#ifdef ALLOC_LOG
+extern AllocLog gAllocLog;
+#endif
+
+#endif  // MYCPP_ALLOC_LOG_H
@@ -0,0 +1,133 @@
+#include "mycpp/bench/bench.h"
+
+#include <math.h>    // sqrt()
+#include <stdlib.h>  // getenv()
+#include <string.h>  // strlen()
+#include <time.h>    // clock_gettime()
+
+#include <algorithm>  // sort()
+
+#include "mycpp/runtime.h"
+
+namespace bench {
+
+#ifdef BUMP_LEAK
+// gMemory is a fixed size, and it's shared by all the benchmarks
+const int64_t kMaxBytesPerRep = MiB(8);
+#else
+const int64_t kMaxBytesPerRep = MiB(256);
+#endif
+
+const int kMaxOps = 1 << 30;
+
+static int IntFromEnv(const char* name, int default_value) {
+  char* e = getenv(name);
+  int result;
+  if (e && StringToInteger(e, strlen(e), 10, &result) && result > 0) {
+    return result;
+  }
+  return default_value;
+}
+
+void Summarize(std::vector<double>* samples, Summary* result) {
+  int n = samples->size();
+  DCHECK(n > 0);
+
+  std::sort(samples->begin(), samples->end());
+
+  result->min = (*samples)[0];
+  if (n % 2 == 1) {
+    result->median = (*samples)[n / 2];
+  } else {
+    result->median = ((*samples)[n / 2 - 1] + (*samples)[n / 2]) / 2;
+  }
+
+  double sum = 0.0;
+  for (double x : *samples) {
+    sum += x;
+  }
+  result->mean = sum / n;
+
+  double sum_sq = 0.0;
+  for (double x : *samples) {
+    sum_sq += (x - result->mean) * (x - result->mean);
+  }
+  // sample standard deviation
+  result->stddev = n > 1 ? sqrt(sum_sq / (n - 1)) : 0.0;
+}
+
+Runner::Runner(const char* variant, FILE* out)
+    : reps_(IntFromEnv("BENCH_REPS", 5)),
+      min_millis_(IntFromEnv("BENCH_MIN_MILLIS", 20)),
+      variant_(variant),
+      out_(out) {
+}
+
+void Runner::PrintHeader() {
+  fprintf(out_,
+          "variant\tbenchmark\tnum_ops\treps\t"
+          "ns_per_op_min\tns_per_op_median\tns_per_op_mean\tns_per_op_stddev\t"
+          "allocs_per_op\tbytes_per_op\n");
+}
+
+void Runner::Time(BenchFunc f, int n, Sample* result) {
+  int num_allocated = gHeap.num_allocated_;
+  int64_t bytes_allocated = gHeap.bytes_allocated_;
+
+  struct timespec start, end;
+  if (clock_gettime(CLOCK_MONOTONIC, &start) < 0) {
+    assert(0);
+  }
+
+  f(n);
+
+  if (clock_gettime(CLOCK_MONOTONIC, &end) < 0) {
+    assert(0);
+  }
+
+  result->nanos = (end.tv_sec - start.tv_sec) * 1e9 +
+                  (end.tv_nsec - start.tv_nsec);
+  result->allocs = gHeap.num_allocated_ - num_allocated;
+  result->bytes = gHeap.bytes_allocated_ - bytes_allocated;
+}
+
+void Runner::Run(const char* name, BenchFunc f) {
+  Sample s;
+
+  // Find the number of ops.  This also warms up the caches and allocator.
+  int n = 1;
+  while (true) {
+    Time(f, n, &s);
+    if (s.nanos >= min_millis_ * 1e6 || s.bytes >= kMaxBytesPerRep ||
+        n >= kMaxOps / 2) {
+      break;
+    }
+    n *= 2;
+  }
+
+  Time(f, n, &s);  // warm-up at the final size
+
+  std::vector<double> ns_per_op;
+  int64_t allocs = 0;
+  int64_t bytes = 0;
+  for (int i = 0; i < reps_; ++i) {
+    Time(f, n, &s);
+    ns_per_op.push_back(s.nanos / n);
+    allocs += s.allocs;
+    bytes += s.bytes;
+  }
+
+  Summary sum;
+  Summarize(&ns_per_op, &sum);
+
+  double total_ops = static_cast<double>(n) * reps_;
+  fprintf(out_, "%s\t%s\t%d\t%d\t%.2f\t%.2f\t%.2f\t%.2f\t%.3f\t%.1f\n",
+          variant_, name, n, reps_, sum.min, sum.median, sum.mean, sum.stddev,
+          allocs / total_ops, bytes / total_ops);
+  fflush(out_);
+
+  log("%-24s %10.1f ns/op  %6.2f allocs/op", name, sum.median,
+      allocs / total_ops);
+}
+
+}  // namespace bench
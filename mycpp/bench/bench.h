@@ -0,0 +1,64 @@
+// mycpp/bench/bench.h: Harness for micro-benchmarks of the mycpp runtime
+//
+// A benchmark is a function that does 'n' operations.  Runner::Run() doubles
+// n until a repetition takes at least BENCH_MIN_MILLIS, does one warm-up
+// repetition, and then times BENCH_REPS more.  It prints a TSV row with the
+// min / median / mean / stddev of ns per op, and allocations and bytes per op.
+//
+// The rows can be concatenated across GC variants and read by
+// benchmarks/report.R.
+
+#ifndef MYCPP_BENCH_BENCH_H
+#define MYCPP_BENCH_BENCH_H
+
+#include <stdint.h>  // int64_t
+#include <stdio.h>   // FILE
+
+#include <vector>
+
+namespace bench {
+
+typedef void (*BenchFunc)(int n);
+
+// Keep the compiler from optimizing away a computation whose result is unused
+template <typename T>
+inline void DoNotOptimize(T const& value) {
+  asm volatile("" : : "g"(value) : "memory");
+}
+
+struct Summary {
+  double min;
+  double median;
+  double mean;
+  double stddev;
+};
+
+// Sorts 'samples'
+void Summarize(std::vector<double>* samples, Summary* result);
+
+class Runner {
+ public:
+  // variant: e.g. opt, bumpleak, cheney, tcmalloc, for the first column
+  Runner(const char* variant, FILE* out);
+
+  void PrintHeader();
+  void Run(const char* name, BenchFunc f);
+
+  int reps_;        // BENCH_REPS
+  int min_millis_;  // BENCH_MIN_MILLIS
+
+ private:
+  struct Sample {
+    double nanos;
+    int64_t allocs;
+    int64_t bytes;
+  };
+  void Time(BenchFunc f, int n, Sample* result);
+
+  const char* variant_;
+  FILE* out_;
+};
+
+}  // namespace bench
+
+#endif  // MYCPP_BENCH_BENCH_H
@@ -0,0 +1,374 @@
+// mycpp/bench/runtime_bench.cc: Micro-benchmarks for Str, List, Dict, and the
+// allocators
+//
+// Usage:
+//   _bin/cxx-opt/mycpp/bench/runtime_bench [VARIANT] > out.tsv
+//
+// Each function does n operations.  Functions that allocate have a GC point
+// per op, like generated code in a loop, so collection is part of the cost.
+// Locals are rooted, since the Cheney collector moves objects.
+
+#include <string.h>  // memmem()
+
+#include <string>
+
+#include "mycpp/bench/bench.h"
+#include "mycpp/runtime.h"
+
+GLOBAL_STR(kHello, "hello");
+GLOBAL_STR(kWorld, "world");
+GLOBAL_STR(kSpace, " ");
+GLOBAL_STR(kLine, "the quick brown fox jumps over the lazy dog");
+GLOBAL_STR(kZ, "z");
+GLOBAL_STR(kDog, "dog");
+GLOBAL_STR(kLazyDog, "lazy dog");
+GLOBAL_STR(kCat, "cat");
+
+//
+// Allocators
+//
+
+void BenchAllocStr(int n) {
+  for (int i = 0; i < n; ++i) {
+    bench::DoNotOptimize(StrFromC("hello"));
+    gHeap.MaybeCollect();
+  }
+}
+
+void BenchAllocStrBig(int n) {
+  for (int i = 0; i < n; ++i) {
+    bench::DoNotOptimize(NewStr(4000));
+    gHeap.MaybeCollect();
+  }
+}
+
+void BenchAllocTuple(int n) {
+  for (int i = 0; i < n; ++i) {
+    bench::DoNotOptimize(Alloc<Tuple2<int, Str*>>(i, kHello));
+    gHeap.MaybeCollect();
+  }
+}
+
+void BenchMaybeCollect(int n) {
+  for (int i = 0; i < n; ++i) {
+    gHeap.MaybeCollect();
+  }
+}
+
+// Rooted in main(), so the setup isn't timed
+List<Str*>* gLive = nullptr;
+
+// One full collection with 10,000 live objects
+void BenchCollect(int n) {
+  if (gLive == nullptr) {
+    gLive = NewList<Str*>();
+    for (int i = 0; i < 10000; ++i) {
+      gLive->append(StrFromC("x"));
+    }
+  }
+  for (int i = 0; i < n; ++i) {
+#ifdef BUMP_LEAK
+    gHeap.MaybeCollect();  // no collector
+#else
+    gHeap.Collect();
+#endif
+  }
+}
+
+//
+// Str
+//
+
+void BenchStrConcat(int n) {
+  for (int i = 0; i < n; ++i) {
+    bench::DoNotOptimize(str_concat(kHello, kWorld));
+    gHeap.MaybeCollect();
+  }
+}
+
+void BenchStrFormat(int n) {
+  for (int i = 0; i < n; ++i) {
+    bench::DoNotOptimize(StrFormat("%s=%d", kHello, i));
+    gHeap.MaybeCollect();
+  }
+}
+
+void BenchStrFind(int n) {
+  int total = 0;
+  for (int i = 0; i < n; ++i) {
+    total += kLine->find(kZ);
+  }
+  bench::DoNotOptimize(total);
+}
+
+// A longer haystack, like a $PATH or a line of a script.  Built in main().
+Str* gLongLine = nullptr;
+
+void BenchStrFindLong(int n) {
+  int total = 0;
+  for (int i = 0; i < n; ++i) {
+    total += gLongLine->find(kLazyDog);
+  }
+  bench::DoNotOptimize(total);
+}
+
+// glibc's memmem() on the same input, for reference
+void BenchMemmemLong(int n) {
+  int total = 0;
+  for (int i = 0; i < n; ++i) {
+    const char* p = static_cast<const char*>(
+        memmem(gLongLine->data_, len(gLongLine), kLazyDog->data_,
+               len(kLazyDog)));
+    total += p - gLongLine->data_;
+    bench::DoNotOptimize(total);  // it's a pure function
+  }
+  bench::DoNotOptimize(total);
+}
+
+void BenchStrContains(int n) {
+  int total = 0;
+  for (int i = 0; i < n; ++i) {
+    total += str_contains(kLine, kDog);
+  }
+  bench::DoNotOptimize(total);
+}
+
+// UTF-8 text with some multi-byte chars.  Built in main().
+Str* gUtf8Text = nullptr;
+
+// Counting a string that's too short to be cached
+void BenchUtf8CharCount(int n) {
+  int total = 0;
+  for (int i = 0; i < n; ++i) {
+    total += mylib::Utf8CharCount(gLongLine);
+    bench::DoNotOptimize(total);
+  }
+  bench::DoNotOptimize(total);
+}
+
+// Like for ((i = 0; i < ${#s}; i++)); do c=${s:i:1}; done
+void BenchUtf8CharOffset(int n) {
+  int num_chars = mylib::Utf8CharCount(gUtf8Text);
+  int total = 0;
+  for (int i = 0; i < n; ++i) {
+    total += mylib::Utf8CharOffset(gUtf8Text, i % num_chars);
+  }
+  bench::DoNotOptimize(total);
+}
+
+void BenchStrEquals(int n) {
+  Str* a = nullptr;
+  Str* b = nullptr;
+  StackRoots _roots({&a, &b});
+
+  a = StrFromC("the quick brown fox");
+  b = StrFromC("the quick brown fox");
+  int total = 0;
+  for (int i = 0; i < n; ++i) {
+    total += str_equals(a, b);
+  }
+  bench::DoNotOptimize(total);
+}
+
+void BenchStrSplit(int n) {
+  for (int i = 0; i < n; ++i) {
+    bench::DoNotOptimize(kLine->split(kSpace));
+    gHeap.MaybeCollect();
+  }
+}
+
+void BenchStrJoin(int n) {
+  List<Str*>* parts = nullptr;
+  StackRoots _roots({&parts});
+
+  parts = kLine->split(kSpace);
+  for (int i = 0; i < n; ++i) {
+    bench::DoNotOptimize(kSpace->join(parts));
+    gHeap.MaybeCollect();
+  }
+}
+
+void BenchStrReplace(int n) {
+  for (int i = 0; i < n; ++i) {
+    bench::DoNotOptimize(kLine->replace(kDog, kCat));
+    gHeap.MaybeCollect();
+  }
+}
+
+//
+// List
+//
+
+// One op is one append.  Start a new list every 1000 ops.
+void BenchListAppend(int n) {
+  List<int>* L = nullptr;
+  StackRoots _roots({&L});
+
+  for (int i = 0; i < n; ++i) {
+    if (i % 1000 == 0) {
+      L = NewList<int>();
+      gHeap.MaybeCollect();
+    }
+    L->append(i);
+  }
+}
+
+void BenchListAppendStr(int n) {
+  List<Str*>* L = nullptr;
+  StackRoots _roots({&L});
+
+  for (int i = 0; i < n; ++i) {
+    if (i % 1000 == 0) {
+      L = NewList<Str*>();
+    }
+    L->append(kHello);
+    gHeap.MaybeCollect();
+  }
+}
+
+void BenchListIndex(int n) {
+  List<int>* L = nullptr;
+  StackRoots _roots({&L});
+
+  L = NewList<int>();
+  for (int i = 0; i < 1000; ++i) {
+    L->append(i);
+  }
+  int total = 0;
+  for (int i = 0; i < n; ++i) {
+    total += L->index_(i % 1000);
+  }
+  bench::DoNotOptimize(total);
+}
+
+//
+// Dict
+//
+
+// One op is one set().  Start a new dict every 100 ops.
+void BenchDictSetInt(int n) {
+  Dict<int, int>* d = nullptr;
+  StackRoots _roots({&d});
+
+  for (int i = 0; i < n; ++i) {
+    if (i % 100 == 0) {
+      d = NewDict<int, int>();
+      gHeap.MaybeCollect();
+    }
+    d->set(i, i);
+  }
+}
+
+static List<Str*>* MakeKeys(int num_keys) {
+  List<Str*>* keys = nullptr;
+  StackRoots _roots({&keys});
+
+  keys = NewList<Str*>();
+  for (int i = 0; i < num_keys; ++i) {
+    keys->append(StrFormat("key%d", i));
+  }
+  return keys;
+}
+
+void BenchDictSetStr(int n) {
+  List<Str*>* keys = nullptr;
+  Dict<Str*, int>* d = nullptr;
+  StackRoots _roots({&keys, &d});
+
+  keys = MakeKeys(100);
+  for (int i = 0; i < n; ++i) {
+    if (i % 100 == 0) {
+      d = NewDict<Str*, int>();
+      gHeap.MaybeCollect();
+    }
+    d->set(keys->index_(i % 100), i);
+  }
+}
+
+void BenchDictGetStr(int n) {
+  List<Str*>* keys = nullptr;
+  Dict<Str*, int>* d = nullptr;
+  StackRoots _roots({&keys, &d});
+
+  keys = MakeKeys(100);
+  d = NewDict<Str*, int>();
+  for (int i = 0; i < 100; ++i) {
+    d->set(keys->index_(i), i);
+  }
+
+  // Look up equal strings, not the same pointers
+  List<Str*>* lookups = nullptr;
+  StackRoots _roots2({&lookups});
+  lookups = MakeKeys(100);
+
+  int total = 0;
+  for (int i = 0; i < n; ++i) {
+    total += d->get(lookups->index_(i % 100), -1);
+  }
+  bench::DoNotOptimize(total);
+}
+
+static const char* DefaultVariant() {
+#if defined(BUMP_LEAK)
+  return "bumpleak";
+#elif defined(CHENEY_GC)
+  return "cheney";
+#elif defined(TCMALLOC)
+  return "tcmalloc";
+#else
+  return "opt";
+#endif
+}
+
+int main(int argc, char** argv) {
+  mylib::InitCppOnly();  // the same GC params as the shell
+  gHeap.RootGlobalVar(reinterpret_cast<RawObject**>(&gLive));
+
+  const char* variant = argc > 1 ? argv[1] : DefaultVariant();
+  bench::Runner r(variant, stdout);
+  r.PrintHeader();
+
+  r.Run("alloc.Str", BenchAllocStr);
+  r.Run("alloc.Str4000", BenchAllocStrBig);
+  r.Run("alloc.Tuple2", BenchAllocTuple);
+  r.Run("gc.MaybeCollect", BenchMaybeCollect);
+  r.Run("gc.Collect10K", BenchCollect);
+  gLive = nullptr;
+
+  gHeap.RootGlobalVar(reinterpret_cast<RawObject**>(&gLongLine));
+  gLongLine = StrFromC(
+      "/usr/local/sbin:/usr/local/bin:/usr/sbin:/usr/bin:/sbin:/bin:"
+      "/usr/games:/usr/local/games:/snap/bin:/home/andy/bin:"
+      "the quick brown fox jumps over the lazy dog");
+
+  gHeap.RootGlobalVar(reinterpret_cast<RawObject**>(&gUtf8Text));
+  std::string text;
+  for (int i = 0; i < 200; ++i) {
+    text += "caf\xc3\xa9 na\xc3\xafve r\xc3\xa9sum\xc3\xa9 ";  // 20 chars
+  }
+  gUtf8Text = StrFromC(text.c_str(), text.size());
+
+  r.Run("str_concat", BenchStrConcat);
+  r.Run("StrFormat", BenchStrFormat);
+  r.Run("Str.find", BenchStrFind);
+  r.Run("Str.find.long", BenchStrFindLong);
+  r.Run("memmem.long", BenchMemmemLong);
+  r.Run("str_contains", BenchStrContains);
+  r.Run("str_equals", BenchStrEquals);
+  r.Run("Str.split", BenchStrSplit);
+  r.Run("Str.join", BenchStrJoin);
+  r.Run("Str.replace", BenchStrReplace);
+  r.Run("Utf8CharCount", BenchUtf8CharCount);
+  r.Run("Utf8CharOffset", BenchUtf8CharOffset);
+
+  r.Run("List<int>.append", BenchListAppend);
+  r.Run("List<Str*>.append", BenchListAppendStr);
+  r.Run("List<int>.index_", BenchListIndex);
+
+  r.Run("Dict<int,int>.set", BenchDictSetInt);
+  r.Run("Dict<Str*,int>.set", BenchDictSetStr);
+  r.Run("Dict<Str*,int>.get", BenchDictGetStr);
+
+  gHeap.FastProcessExit();
+  return 0;
+}
@@ -23,7 +23,7 @@ class BumpLeakHeap {
   }
   void PopRoot() {
   }
-  void RootGlobalVar(void* root) {
+  void RootGlobalVar(RawObject** root) {
   }
 
   void* Allocate(size_t num_bytes);
@@ -31,6 +31,9 @@ class BumpLeakHeap {
   int MaybeCollect() {
     return -1;  // no collection attempted
   }
+  int IdleCollect() {
+    return -1;
+  }
 
   void PrintStats(int fd);
 
@@ -1,7 +1,14 @@
 #include "mycpp/cheney_heap.h"
 
+#include <inttypes.h>  // PRId64
+#include <stdlib.h>    // getenv()
+#include <string.h>    // strlen()
 #include <sys/mman.h>  // mmap
+#include <time.h>      // clock_gettime(), CLOCK_PROCESS_CPUTIME_ID
+#include <unistd.h>    // STDERR_FILENO
 
+#include "_build/detected-cpp-config.h"  // for GC_TIMING
+#include "mycpp/gc_builtins.h"           // StringToInteger()
 #include "mycpp/gc_obj.h"
 #include "mycpp/gc_slab.h"
 
@@ -16,6 +23,25 @@ class LayoutForwarded {
   RawObject* new_location;
 };
 
+// Every object must have room for LayoutForwarded, so Allocate(), Relocate(),
+// and the scan loop in Collect() all agree on this size.
+static inline int CopySize(int obj_len) {
+  int n = aligned(obj_len);
+  return n < static_cast<int>(sizeof(LayoutForwarded))
+             ? static_cast<int>(sizeof(LayoutForwarded))
+             : n;
+}
+
+// Where the forwarding pointer is stored.  An object with a vtable may be only
+// 16 bytes, so the pointer overwrites the vtable rather than the first field.
+// It's aligned, so FindObjHeader() still sees that it's not a header.
+static inline RawObject** ForwardingSlot(RawObject* obj, ObjHeader* header) {
+  if (reinterpret_cast<void*>(header) == reinterpret_cast<void*>(obj)) {
+    return &(reinterpret_cast<LayoutForwarded*>(header)->new_location);
+  }
+  return reinterpret_cast<RawObject**>(obj);
+}
+
 void Space::Init(int num_bytes) {
   void* requested_addr = nullptr;
 
@@ -38,6 +64,73 @@ void Space::Init(int num_bytes) {
 
 void Space::Free() {
   munmap(begin_, size_);
+  begin_ = nullptr;
+  size_ = 0;
+}
+
+void CheneyHeap::Init() {
+  Init(1000);  // collect at 1000 objects in tests
+}
+
+void CheneyHeap::Init(int gc_threshold) {
+  gc_threshold_ = gc_threshold;
+
+  char* e;
+  e = getenv("OIL_GC_THRESHOLD");
+  if (e) {
+    int result;
+    if (StringToInteger(e, strlen(e), 10, &result)) {
+      // Override collection threshold
+      gc_threshold_ = result;
+    }
+  }
+
+  // only for developers
+  e = getenv("_OIL_GC_VERBOSE");
+  if (e && strcmp(e, "1") == 0) {
+    gc_verbose_ = true;
+  }
+
+  space_size_ = MiB(1);
+  from_space_.Init(space_size_);
+  free_ = from_space_.begin_;
+  limit_ = free_ + from_space_.size_;
+
+  roots_.reserve(KiB(1));  // prevent resizing in common case
+
+  is_initialized_ = true;
+}
+
+// Called when from_space_ is full.  Unlike the mark-sweep heap, we can't
+// collect here, because the caller's pointers aren't necessarily rooted.
+void CheneyHeap::NewChunk(int n) {
+  full_chunks_.push_back(from_space_);
+
+  from_space_.Init(n > space_size_ ? n : space_size_);
+  free_ = from_space_.begin_;
+  limit_ = free_ + from_space_.size_;
+
+  num_chunks_++;
+}
+
+void* CheneyHeap::Allocate(size_t num_bytes) {
+  DCHECK(is_initialized_);
+
+  int n = CopySize(num_bytes);
+  if (free_ + n > limit_) {
+    NewChunk(n);
+  }
+
+  // Memory from mmap() is zeroed, and we never reuse it without a new mmap()
+  char* p = free_;
+  free_ += n;
+
+  num_live_++;
+  bytes_live_ += n;
+  num_allocated_++;
+  bytes_allocated_ += num_bytes;
+
+  return p;
 }
 
 RawObject* CheneyHeap::Relocate(RawObject* obj, ObjHeader* header) {
@@ -47,116 +140,96 @@ RawObject* CheneyHeap::Relocate(RawObject* obj, ObjHeader* header) {
 
   switch (header->heap_tag) {
   case HeapTag::Forwarded: {
-    auto f = reinterpret_cast<LayoutForwarded*>(header);
-    return f->new_location;
+    return *ForwardingSlot(obj, header);
   }
 
   case HeapTag::Global: {  // e.g. GlobalStr isn't copied or forwarded
-    // log("*** GLOBAL POINTER");
     return obj;
   }
 
   default: {
-    assert(header->heap_tag == HeapTag::Opaque ||
+    DCHECK(header->heap_tag == HeapTag::Opaque ||
            header->heap_tag == HeapTag::FixedSize ||
            header->heap_tag == HeapTag::Scanned);
 
     auto new_location = reinterpret_cast<RawObject*>(free_);
-    // Note: if we wanted to save space on ASDL records, we could calculate
-    // their length from the field_mask here.  How much would it slow down GC?
-    int n = header->obj_len;
-    assert(n > 0);  // detect common problem
+    int n = CopySize(header->obj_len);
     memcpy(new_location, obj, n);
-    // log("memcpy %d bytes from %p -> %p", n, obj, new_location);
-  #if 0
-    if (obj->heap_tag == HeapTag::Opaque) {
-      Str* s = static_cast<Str*>(obj);
-      log("from = %s", s->data_);
-      Str* s2 = static_cast<Str*>(new_location);
-      log("to = %s", s2->data_);
-    }
-  #endif
-    // aligned() like Heap::Allocate()
-    free_ += aligned(n);
+    free_ += n;
 
-  #if GC_STATS
-    num_live_objs_++;
-  #endif
+    num_live_++;
 
-    auto f = reinterpret_cast<LayoutForwarded*>(header);
-    f->header_.heap_tag = HeapTag::Forwarded;
-    f->new_location = new_location;
+    header->heap_tag = HeapTag::Forwarded;
+    *ForwardingSlot(obj, header) = new_location;
     return new_location;
   }
   }  // switch
 }
 
-void CheneyHeap::Collect(int to_space_size) {
-  #if GC_STATS
-  log("--> COLLECT with %d roots", roots_top_);
-  num_collections_++;
+int CheneyHeap::MaybeCollect() {
+  // Maybe collect BEFORE allocation, because the new object won't be rooted
+  #if GC_ALWAYS
+  int result = Collect();
+  #else
+  int result = -1;
+  if (num_live_ > gc_threshold_) {
+    result = Collect();
+  }
   #endif
 
-  if (to_space_size == 0) {
-    to_space_size = from_space_.size_;
+  num_gc_points_++;  // this is a manual collection point
+  return result;
+}
+
+int CheneyHeap::Collect() {
+  #ifdef GC_TIMING
+  struct timespec start, end;
+  if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &start) < 0) {
+    assert(0);
   }
+  #endif
 
-  assert(to_space_size >= from_space_.size_);
+  int num_roots = roots_.size();
+  int num_globals = global_roots_.size();
 
-  to_space_.Init(to_space_size);
+  if (gc_verbose_) {
+    log("");
+    log("%2d. GC with %d roots (%d global) and %d live objects",
+        num_collections_, num_roots + num_globals, num_globals, num_live_);
+  }
 
-  assert(to_space_.size_ >= from_space_.size_);
+  // Everything that's live fits in bytes_live_, no matter how many chunks
+  // it's spread across
+  int to_space_size = space_size_;
+  if (bytes_live_ > to_space_size) {
+    to_space_size = bytes_live_;
+  }
+  to_space_.Init(to_space_size);
 
   char* scan = to_space_.begin_;  // boundary between black and gray
   free_ = scan;                   // where to copy new entries
-  limit_ = scan + to_space_.size_;
 
-  #if GC_STATS
-  num_live_objs_ = 0;
-  #endif
+  num_live_ = 0;
 
-  for (int i = 0; i < roots_top_; ++i) {
+  // Relocate roots, updating the "double indirection" so future accesses to a
+  // local variable use the new location.
+  for (int i = 0; i < num_roots; ++i) {
     RawObject** handle = roots_[i];
-    auto root = *handle;
-  #if GC_VERBOSE
-    log("%d. handle %p", i, handle);
-    log("    root %p", root);
-  #endif
-
+    RawObject* root = *handle;
     if (root) {  // could be nullptr
-      auto header = FindObjHeader(root);
-
-      // This updates the underlying Str/List/Dict with a forwarding pointer,
-      // i.e. for other objects that are pointing to it
-      RawObject* new_location = Relocate(root, header);
-  #if TODO_BUG
-      for (int j = 0; j < roots_top_; ++j) {
-        RawObject** handle2 = roots_[j];
-        auto root2 = *handle2;
-        if (root2) {
-          switch (root2->heap_tag) {
-          case HeapTag::Forwarded:
-          case HeapTag::Global:
-          case HeapTag::Opaque:
-          case HeapTag::FixedSize:
-          case HeapTag::Scanned:
-            break;
-          default:
-            FAIL(kShouldNotGetHere);
-          }
-        }
-      }
-
-  #endif
-
-      // log("    new location %p", new_location);
+      *handle = Relocate(root, FindObjHeader(root));
+    }
+  }
 
-      // This update is for the "double indirection", so future accesses to a
-      // local variable use the new location
-      *handle = new_location;
+  for (int i = 0; i < num_globals; ++i) {
+    RawObject** handle = global_roots_[i];
+    RawObject* root = *handle;
+    if (root) {
+      *handle = Relocate(root, FindObjHeader(root));
     }
   }
 
+  // Scan the gray objects, which copies their children to the end
   while (scan < free_) {
     auto obj = reinterpret_cast<RawObject*>(scan);
     auto header = FindObjHeader(obj);
@@ -165,121 +238,167 @@ void CheneyHeap::Collect(int to_space_size) {
     case HeapTag::FixedSize: {
       auto fixed = reinterpret_cast<LayoutFixed*>(header);
       int mask = fixed->header_.field_mask;
-      for (int i = 0; i < 16; ++i) {
-        if (mask & (1 << i)) {
+      for (int i = 0; mask; ++i, mask >>= 1) {
+        if (mask & 1) {
           RawObject* child = fixed->children_[i];
-          // log("i = %d, p = %p, heap_tag = %d", i, child, child->heap_tag);
           if (child) {
-            auto child_header = FindObjHeader(child);
-            // log("  fixed: child %d from %p", i, child);
-            fixed->children_[i] = Relocate(child, child_header);
-            // log("  to %p", fixed->children_[i]);
+            fixed->children_[i] = Relocate(child, FindObjHeader(child));
           }
         }
       }
       break;
     }
     case HeapTag::Scanned: {
-      // no vtable
-      assert(reinterpret_cast<void*>(header) == reinterpret_cast<void*>(obj));
-
-      auto slab = reinterpret_cast<Slab<void*>*>(header);
-      int n = (slab->header_.obj_len - kSlabHeaderSize) / sizeof(void*);
-      for (int i = 0; i < n; ++i) {
-        RawObject* child = reinterpret_cast<RawObject*>(slab->items_[i]);
+      // The pointers follow the header.  A Slab<T*> is pointers up to
+      // obj_len; a class has field_mask of them, then other members.
+      auto children = reinterpret_cast<RawObject**>(header + 1);
+      RawObject** end;
+      if (header->type_tag == TypeTag::Slab) {
+        end = reinterpret_cast<RawObject**>(scan + header->obj_len);
+      } else {
+        end = children + header->field_mask;
+      }
+      for (RawObject** p = children; p < end; ++p) {
+        RawObject* child = *p;
         if (child) {  // note: List<> may have nullptr; Dict is sparse
-          auto child_header = FindObjHeader(child);
-          slab->items_[i] = Relocate(child, child_header);
+          *p = Relocate(child, FindObjHeader(child));
         }
       }
       break;
     }
-    default: {
-      assert(header->heap_tag == HeapTag::Forwarded ||
-             header->heap_tag == HeapTag::Global ||
-             header->heap_tag == HeapTag::Opaque);
-    }
-
+    default:
       // other tags like HeapTag::Opaque have no children
+      DCHECK(header->heap_tag == HeapTag::Opaque);
     }
-    // aligned() like Heap::Allocate()
-    scan += aligned(header->obj_len);
+    scan += CopySize(header->obj_len);
   }
 
-  Swap();
+  // The old spaces are garbage now
+  from_space_.Free();
+  for (auto& chunk : full_chunks_) {
+    chunk.Free();
+  }
+  full_chunks_.clear();
 
-  to_space_.Free();
+  from_space_ = to_space_;
+  to_space_ = Space();
+  limit_ = from_space_.begin_ + from_space_.size_;
 
-  #if GC_STATS
-  Report();
-  #endif
-}
+  bytes_live_ = free_ - from_space_.begin_;
 
-  #if GC_STATS
-void ShowFixedChildren(RawObject* obj) {
-  assert(obj->heap_tag == HeapTag::FixedSize);
-  auto fixed = reinterpret_cast<LayoutFixed*>(obj);
-  log("MASK:");
-
-  // Note: can this be optimized with the equivalent x & (x-1) trick?
-  // We need the index
-  // There is a de Brjuin sequence solution?
-  // https://stackoverflow.com/questions/757059/position-of-least-significant-bit-that-is-set
-
-  int mask = fixed->field_mask;
-  for (int i = 0; i < 16; ++i) {
-    if (mask & (1 << i)) {
-      RawObject* child = fixed->children_[i];
-      if (child) {
-        // make sure we get HeapTag::Opaque, HeapTag::Scanned, etc.
-        log("i = %d, p = %p, heap_tag = %d", i, child, child->heap_tag);
-      }
-    }
+  num_collections_++;
+  max_survived_ = std::max(max_survived_, num_live_);
+
+  if (gc_verbose_) {
+    log("    %d live after copy (%" PRId64 " bytes)", num_live_, bytes_live_);
   }
-}
-  #endif
 
-void* CheneyHeap::Allocate(int num_bytes) {
-  int n = aligned(num_bytes);
-  // log("n = %d, p = %p", n, p);
+  // Same ad hoc policy as MarkSweepHeap: if the number of live objects is
+  // above 75% of the threshold, set the threshold to 2 times the number of
+  // live objects, so we don't do futile collections.  The next to-space grows
+  // in proportion.
+
+  int water_mark = (gc_threshold_ * 3) / 4;
+  if (num_live_ > water_mark) {
+    gc_threshold_ = num_live_ * 2;
+    num_growths_++;
+    if (gc_verbose_) {
+      log("    exceeded %d live objects; gc_threshold set to %d", water_mark,
+          gc_threshold_);
+    }
+  }
+  if (bytes_live_ > (static_cast<int64_t>(space_size_) * 3) / 4) {
+    space_size_ = bytes_live_ * 2;
+  }
 
-  // This must be at least sizeof(LayoutForwarded), which happens to be 16
-  // bytes, because the GC pointer forwarding requires 16 bytes.  If we
-  // allocated less than 16 the GC would overwrite the adjacent object when
-  // it went to forward the pointer.
-  assert(n >= static_cast<int>(sizeof(LayoutForwarded)));
+  #ifdef GC_TIMING
+  if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &end) < 0) {
+    assert(0);
+  }
 
-  #if GC_ALWAYS
-  Collect();  // force collection to find problems early
-  #endif
+  double start_secs = start.tv_sec + start.tv_nsec / 1e9;
+  double end_secs = end.tv_sec + end.tv_nsec / 1e9;
+  double gc_millis = (end_secs - start_secs) * 1000.0;
 
-  if (free_ + n <= limit_) {  // Common case: we have space for it.
-    return Bump(n);
+  if (gc_verbose_) {
+    log("    %.1f ms GC", gc_millis);
   }
 
-  #if GC_STATS
-    // log("GC free_ %p,  from_space_ %p, space_size_ %d", free_, from_space_,
-    //    space_size_);
+  total_gc_millis_ += gc_millis;
+  if (gc_millis > max_gc_millis_) {
+    max_gc_millis_ = gc_millis;
+  }
   #endif
 
-  Collect();  // Try to free some space.
+  return num_live_;  // for unit tests only
+}
 
-  // log("after GC: from begin %p, free_ %p,  n %d, limit_ %p",
-  //    from_space_.begin_, free_, n, limit_);
+void CheneyHeap::PrintStats(int fd) {
+  dprintf(fd, "  num live        = %10d\n", num_live_);
+  // max survived_ can be less than num_live_, because leave off the last GC
+  dprintf(fd, "  max survived    = %10d\n", max_survived_);
+  dprintf(fd, "\n");
+  dprintf(fd, "  num allocated   = %10d\n", num_allocated_);
+  dprintf(fd, "bytes allocated   = %10" PRId64 "\n", bytes_allocated_);
+  dprintf(fd, "\n");
+  dprintf(fd, "  num gc points   = %10d\n", num_gc_points_);
+  dprintf(fd, "  num collections = %10d\n", num_collections_);
+  dprintf(fd, "\n");
+  dprintf(fd, "   gc threshold   = %10d\n", gc_threshold_);
+  dprintf(fd, "  num growths     = %10d\n", num_growths_);
+  dprintf(fd, "\n");
+  dprintf(fd, "  max gc millis   = %10.1f\n", max_gc_millis_);
+  dprintf(fd, "total gc millis   = %10.1f\n", total_gc_millis_);
+  dprintf(fd, "\n");
+  dprintf(fd, "roots capacity    = %10d\n",
+          static_cast<int>(roots_.capacity()));
+  dprintf(fd, "\n");
+  dprintf(fd, " bytes live       = %10" PRId64 "\n", bytes_live_);
+  dprintf(fd, " space size       = %10d\n", space_size_);
+  dprintf(fd, "  num chunks      = %10d\n", num_chunks_);
+}
 
-  if (free_ + n <= limit_) {  // Now we have space for it.
-    return Bump(n);
+// Cleanup at the end of main() to remain ASAN-safe
+void CheneyHeap::DoProcessExit(bool fast_exit) {
+  char* e = getenv("OIL_GC_ON_EXIT");
+
+  if (fast_exit) {
+    // don't collect by default; OIL_GC_ON_EXIT=1 overrides
+    if (e && strcmp(e, "1") == 0) {
+      Collect();
+    }
+  } else {
+    // collect by default; OIL_GC_ON_EXIT=0 overrides
+    if (e && strcmp(e, "0") == 0) {
+      ;
+    } else {
+      Collect();
+    }
+  }
+
+  int stats_fd = -1;
+  e = getenv("OIL_GC_STATS");
+  if (e && strlen(e)) {  // env var set and non-empty
+    stats_fd = STDERR_FILENO;
+  } else {
+    e = getenv("OIL_GC_STATS_FD");
+    if (e && strlen(e)) {
+      StringToInteger(e, strlen(e), 10, &stats_fd);
+    }
   }
 
-  // It's still too small.  Grow the heap.
-  int multiple = 2;
-  Collect((from_space_.size_ + n) * multiple);
+  if (stats_fd != -1) {
+    PrintStats(stats_fd);
+  }
+}
 
-  #if GC_STATS
-  num_forced_growths_++;
-  #endif
+void CheneyHeap::CleanProcessExit() {
+  DoProcessExit(false);  // not fast_exit
+}
 
-  return Bump(n);
+// for the main binary
+void CheneyHeap::FastProcessExit() {
+  DoProcessExit(true);
 }
 
 #endif  // CHENEY_GC
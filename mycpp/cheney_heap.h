@@ -6,10 +6,14 @@
 #ifndef CHENEY_HEAP_H
 #define CHENEY_HEAP_H
 
+#include <stdint.h>  // int64_t
+
 #include <cassert>  // assert()
 #include <cstdlib>  // malloc
 #include <cstring>  // memcpy
+#include <algorithm>  // max()
 #include <initializer_list>
+#include <vector>
 
 #include "mycpp/common.h"
 
@@ -69,6 +73,16 @@ struct ObjHeader;  // from gc_obj.h
 //
 // This pushes local variables onto the global data structure managed by the
 // GC.
+//
+// Unlike MarkSweepHeap, it's not enough for an object to be reachable: every
+// pointer that's live across a collection has to be updated.  So ListIter,
+// DictIter, StrIter etc. root what they iterate over, and RootGlobalVar()
+// takes the address of the global.
+//
+// Not handled yet: mycpp doesn't root 'this', or the fields of context
+// managers allocated on the C++ stack.  So a MaybeCollect() reached from
+// within a method or a 'with' block leaves those pointers dangling.  The
+// parser's GC points are in plain functions, but CommandEvaluator's aren't.
 
 // TODO: Dicts should actually use hashing!  Test computational complexity.
 
@@ -93,7 +107,7 @@ struct ObjHeader;  // from gc_obj.h
 
 // #defines for degbugging:
 //
-// GC_ALWAYS: Collect() on every Allocate().  Exposes many bugs!
+// GC_ALWAYS: Collect() on every MaybeCollect().  Exposes many bugs!
 // GC_VERBOSE: Log when we collect
 
 // Silly definition for passing types like GlobalList<T, N> and initializer
@@ -104,9 +118,10 @@ class List;
 
 struct RawObject;
 
+// A contiguous region of memory from mmap(), which is zero-filled.
 class Space {
  public:
-  Space() {
+  Space() : begin_(nullptr), size_(0) {
   }
   void Init(int);
 
@@ -122,121 +137,83 @@ class CheneyHeap {
                   // initialization
   }
 
-  // Real initialization with the initial heap size.  The heap grows with
-  // allocations.
-  void Init(int space_size) {
-    from_space_.Init(space_size);
-
-    free_ = from_space_.begin_;  // where we allocate from
-    limit_ = free_ + space_size;
+  // Like MarkSweepHeap, the threshold is a number of live objects.  The size
+  // of the spaces is derived from the number of live bytes.
+  void Init();  // use default threshold
+  void Init(int gc_threshold);
 
-    roots_top_ = 0;
+  // Allocate() never collects, so objects don't move except at manual
+  // collection points.  When from_space_ is full, it continues in a new chunk
+  // of memory, and the next Collect() copies everything into one space.
+  void* Allocate(size_t num_bytes);
 
-    is_initialized_ = true;
-
-#if GC_STATS
-    num_collections_ = 0;
-    num_heap_growths_ = 0;
-    num_forced_growths_ = 0;
-    num_live_objs_ = 0;
-#endif
+  void PushRoot(RawObject** p) {
+    roots_.push_back(p);
   }
 
-  void* Bump(int n) {
-    char* p = free_;
-    free_ += n;
-#if GC_STATS
-    num_live_objs_++;
-#endif
-    return p;
+  void PopRoot() {
+    roots_.pop_back();
   }
 
-  void* Allocate(int);
+  // Takes the address of the global, since Collect() updates it
+  void RootGlobalVar(RawObject** root) {
+    global_roots_.push_back(root);
+  }
 
-  void Swap() {
-    // Swap spaces for next collection.
-    char* tmp = from_space_.begin_;
-    from_space_.begin_ = to_space_.begin_;
-    to_space_.begin_ = tmp;
+  RawObject* Relocate(RawObject* obj, ObjHeader* header);
 
-    int tmp2 = from_space_.size_;
-    from_space_.size_ = to_space_.size_;
-    to_space_.size_ = tmp2;
+  int MaybeCollect();
+  int Collect();
+  // Copying already compacts, and the prompt calls MaybeCollect() too
+  int IdleCollect() {
+    return -1;
   }
 
-  void PushRoot(RawObject** p) {
-    // log("PushRoot %d", roots_top_);
-    roots_[roots_top_++] = p;
-    // TODO: This should be like a malloc() failure?
-    assert(roots_top_ < kMaxRoots);
-  }
+  void PrintStats(int fd);  // public for testing
 
-  void PopRoot() {
-    roots_top_--;
-    // log("PopRoot %d", roots_top_);
-  }
+  void CleanProcessExit();
+  void FastProcessExit();
 
-  RawObject* Relocate(RawObject* obj, ObjHeader* header);
+  bool is_initialized_ = false;
 
-  // mutates free_ and other variables
-  void Collect(int to_space_size = 0);
+  // Runtime params
 
-  // Like MarkSweepHeap
-  int MaybeCollect() {
-    return -1;
-  }
+  int gc_threshold_;  // number of live objects, like MarkSweepHeap
+  int space_size_;    // minimum size of a to-space or new chunk, in bytes
 
-  // Like MarkSweepHeap.  TODO: Does this API work?
-  void RootGlobalVar(void* root) {
-  }
+  bool gc_verbose_ = false;
 
-  // Like MarkSweepHeap
-  void CleanProcessExit() {
-  }
-  void FastProcessExit() {
-  }
+  // Current stats
+  int num_live_ = 0;
+  int64_t bytes_live_ = 0;  // bytes copied, plus bytes allocated since
 
-#if GC_STATS
-  void Report() {
-    log("-----");
-    log("num collections = %d", num_collections_);
-    log("num heap growths = %d", num_heap_growths_);
-    log("num forced heap growths = %d", num_forced_growths_);
-    log("num live objects = %d", num_live_objs_);
-
-    log("from_space_ %p", from_space_.begin_);
-    log("to_space %p", to_space_.begin_);
-    log("-----");
-  }
-#endif
+  // Cumulative stats
+  int max_survived_ = 0;  // max # live after a collection
+  int num_allocated_ = 0;
+  int64_t bytes_allocated_ = 0;  // avoid overflow
+  int num_gc_points_ = 0;        // manual collection points
+  int num_collections_ = 0;
+  int num_growths_ = 0;
+  int num_chunks_ = 0;  // times Allocate() ran out of from_space_
+  double max_gc_millis_ = 0.0;
+  double total_gc_millis_ = 0.0;
 
   Space from_space_;  // space we allocate from
   Space to_space_;    // space that the collector copies to
+  // Earlier chunks we allocated from since the last collection
+  std::vector<Space> full_chunks_;
 
   char* free_;   // next place to allocate, from_space_ <= free_ < limit_
   char* limit_;  // end of space we're allocating from
 
-  // Stack roots.  The obvious data structure is a linked list, but an array
-  // has better locality.
-  //
-  // femtolisp uses a global pointer to dynamically-allocated growable array,
-  // with initial N_STACK = 262144!  Kind of arbitrary.
+  std::vector<RawObject**> roots_;
+  std::vector<RawObject**> global_roots_;
 
-  int roots_top_;
-  RawObject** roots_[kMaxRoots];  // These are pointers to RawObject* pointers
+ private:
+  void NewChunk(int n);
+  void DoProcessExit(bool fast_exit);
 
-  bool is_initialized_ = false;
-
-#if GC_STATS
-  int num_collections_;
-  int num_heap_growths_;
-  int num_forced_growths_;  // when a single allocation is too big
-  int num_live_objs_;
-#endif
+  DISALLOW_COPY_AND_ASSIGN(CheneyHeap);
 };
 
-#if GC_STATS
-void ShowFixedChildren(RawObject* obj);
-#endif
-
 #endif  // CHENEY_HEAP_H
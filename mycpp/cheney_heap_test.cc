@@ -1,15 +1,208 @@
-#include "mycpp/cheney_heap.h"
+#include <unistd.h>  // STDERR_FILENO
 
+#include "mycpp/runtime.h"
 #include "vendor/greatest.h"
 
-// TODO: gc_heap_test.cc used to run with the cheney_heap.h.  Maybe revive
-// that.
+// Cheney-specific tests.  The container tests in gc_*_test.cc are also built
+// with -D CHENEY_GC.
 
 TEST header_test() {
-  CheneyHeap h;
+  ASSERT_EQ(1000, gHeap.gc_threshold_);
+  ASSERT(gHeap.from_space_.begin_ != nullptr);
 
-  h.Init(100);
-  h.Collect(200);
+  Str* s = StrFromC("cheney");
+  ASSERT_EQ_FMT(kStrHeaderSize + 6 + 1, s->header_.obj_len, "%d");
+  ASSERT_EQ_FMT(6, len(s), "%d");
+  ASSERT_EQ_FMT(6, STR_LEN(s->header_), "%d");
+
+  // Global strings derive their length the same way
+  ASSERT_EQ_FMT(0, len(kEmptyString), "%d");
+
+  PASS();
+}
+
+TEST move_test() {
+  Str* s = nullptr;
+  List<Str*>* L = nullptr;
+  StackRoots _roots({&s, &L});
+
+  s = StrFromC("foo");
+  L = NewList<Str*>();
+  for (int i = 0; i < 100; ++i) {
+    L->append(StrFromC("bar"));
+  }
+  L->append(s);
+
+  Str* old_s = s;
+  gHeap.Collect();
+
+  // The roots were updated, and shared objects are copied once
+  ASSERT(s != old_s);
+  ASSERT(str_equals(s, StrFromC("foo")));
+  ASSERT_EQ(s, L->index_(100));
+  ASSERT_EQ_FMT(101, len(L), "%d");
+  ASSERT(str_equals(L->index_(0), StrFromC("bar")));
+
+  PASS();
+}
+
+TEST iter_root_test() {
+  List<Str*>* L = nullptr;
+  StackRoots _roots({&L});
+
+  L = NewList<Str*>({StrFromC("a"), StrFromC("b"), StrFromC("c")});
+
+  Str* joined = kEmptyString;
+  StackRoots _roots2({&joined});
+
+  // The iterator roots L_, so it follows the list when it moves
+  for (ListIter<Str*> it(L); !it.Done(); it.Next()) {
+    gHeap.Collect();
+    joined = str_concat(joined, it.Value());
+  }
+  ASSERT(str_equals(joined, StrFromC("abc")));
+
+  Str* s = StrFromC("xyz");
+  StackRoots _roots3({&s});
+
+  int n = 0;
+  for (StrIter it(s); !it.Done(); it.Next()) {
+    gHeap.Collect();
+    ASSERT_EQ(s->data_[n], it.Value()->data_[0]);
+    n++;
+  }
+  ASSERT_EQ(3, n);
+
+  PASS();
+}
+
+class Base {
+ public:
+  Base() : GC_CLASS_FIXED(header_, field_mask(), sizeof(Base)), name(nullptr) {
+  }
+  virtual int Size() {
+    return 1;
+  }
+
+  GC_OBJ(header_);
+  Str* name;
+
+  static constexpr uint16_t field_mask() {
+    return maskbit_v(offsetof(Base, name));
+  }
+};
+
+class Derived : public Base {
+ public:
+  Derived() : Base(), x(0), y(0), z(0) {
+  }
+  int Size() override {
+    return 4;
+  }
+  int x;
+  int y;
+  int z;
+};
+
+TEST vtable_test() {
+  Base* b = nullptr;
+  Derived* d = nullptr;
+  StackRoots _roots({&b, &d});
+
+  b = Alloc<Base>();
+  b->name = StrFromC("base");
+
+  // Alloc<T> sets obj_len for the subclass, since the header was initialized
+  // by Base()
+  d = Alloc<Derived>();
+  d->name = StrFromC("derived");
+  d->z = 42;
+  ASSERT_EQ_FMT(static_cast<int>(sizeof(Derived)),
+                static_cast<int>(FindObjHeader(
+                                     reinterpret_cast<RawObject*>(d))
+                                     ->obj_len),
+                "%d");
+
+  gHeap.Collect();
+
+  ASSERT_EQ(1, b->Size());
+  ASSERT_EQ(4, d->Size());
+  ASSERT_EQ(42, d->z);
+  ASSERT(str_equals(b->name, StrFromC("base")));
+  ASSERT(str_equals(d->name, StrFromC("derived")));
+
+  PASS();
+}
+
+TEST chunk_test() {
+  Str* big = nullptr;
+  StackRoots _roots({&big});
+
+  int before = gHeap.num_chunks_;
+
+  // Bigger than the space, so Allocate() continues in a new chunk rather than
+  // collecting
+  int n = gHeap.space_size_ * 2;
+  big = NewStr(n);
+  big->data_[0] = 'x';
+  ASSERT(gHeap.num_chunks_ > before);
+  ASSERT(gHeap.full_chunks_.size() > 0);
+
+  gHeap.Collect();
+
+  // Everything was copied into one space
+  ASSERT_EQ_FMT(0, static_cast<int>(gHeap.full_chunks_.size()), "%d");
+  ASSERT_EQ('x', big->data_[0]);
+  ASSERT_EQ(n, len(big));
+
+  // The space grew to hold what survived
+  ASSERT(gHeap.from_space_.size_ > n);
+  ASSERT(gHeap.space_size_ > n);
+
+  big = nullptr;
+  gHeap.Collect();
+
+  PASS();
+}
+
+TEST growth_test() {
+  List<Str*>* L = nullptr;
+  StackRoots _roots({&L});
+
+  int threshold = gHeap.gc_threshold_;
+  L = NewList<Str*>();
+  for (int i = 0; i < threshold * 2; ++i) {
+    L->append(StrFromC("x"));
+    gHeap.MaybeCollect();
+  }
+
+  // Most objects survive, so the threshold grows rather than collecting
+  // futilely
+  ASSERT(gHeap.gc_threshold_ > threshold);
+  ASSERT(gHeap.num_growths_ > 0);
+
+  PASS();
+}
+
+Str* gGlobal = nullptr;
+
+TEST global_root_test() {
+  gGlobal = StrFromC("global");
+  gHeap.RootGlobalVar(reinterpret_cast<RawObject**>(&gGlobal));
+
+  Str* old = gGlobal;
+  gHeap.Collect();
+  ASSERT(gGlobal != old);
+  ASSERT(str_equals(gGlobal, StrFromC("global")));
+
+  PASS();
+}
+
+TEST stats_test() {
+  gHeap.PrintStats(STDERR_FILENO);
+  ASSERT(gHeap.num_collections_ > 0);
+  ASSERT(gHeap.max_survived_ > 0);
+  ASSERT(gHeap.bytes_allocated_ > 0);
 
   PASS();
 }
@@ -17,13 +210,20 @@ TEST header_test() {
 GREATEST_MAIN_DEFS();
 
 int main(int argc, char** argv) {
-  // gHeap.Init();
+  gHeap.Init();
 
   GREATEST_MAIN_BEGIN();
 
   RUN_TEST(header_test);
+  RUN_TEST(move_test);
+  RUN_TEST(iter_root_test);
+  RUN_TEST(vtable_test);
+  RUN_TEST(chunk_test);
+  RUN_TEST(growth_test);
+  RUN_TEST(global_root_test);
+  RUN_TEST(stats_test);
 
-  // gHeap.CleanProcessExit();
+  gHeap.CleanProcessExit();
 
   GREATEST_MAIN_END();
   return 0;
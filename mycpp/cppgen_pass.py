@@ -6,9 +6,10 @@ import json  # for "C escaping"
 import os
 import sys
 
-from typing import overload, Union, Optional, Any, Dict
+from typing import overload, Union, Optional, Any, Dict, List, Set
 
 from mypy.visitor import ExpressionVisitor, StatementVisitor
+from mypy.traverser import TraverserVisitor
 from mypy.types import (
     Type, AnyType, NoneTyp, TupleType, Instance, NoneType, Overloaded, CallableType,
     UnionType, UninhabitedType, PartialType, TypeAliasType)
@@ -16,7 +17,8 @@ from mypy.nodes import (
     Expression, Statement, Block, NameExpr, IndexExpr, MemberExpr, TupleExpr,
     ExpressionStmt, AssignmentStmt, IfStmt, StrExpr, SliceExpr, FuncDef,
     UnaryExpr, ComparisonExpr, CallExpr, IntExpr, ListExpr, DictExpr,
-    ListComprehension)
+    ListComprehension, YieldExpr, ForStmt, TryStmt, WithStmt, ReturnStmt,
+    Node, OpExpr)
 
 from mycpp import format_strings
 from mycpp.crash import catch_errors
@@ -202,6 +204,13 @@ def GetCType(t, param=False, local=False):
       c_type = 'List<%s>' % inner_c_type
       is_pointer = True
 
+    elif type_name == 'collections.deque':
+      assert len(t.args) == 1, t.args
+      type_param = t.args[0]
+      inner_c_type = GetCType(type_param)
+      c_type = 'Deque<%s>' % inner_c_type
+      is_pointer = True
+
     elif type_name == 'builtins.dict':
       params = []
       for type_param in t.args:
@@ -217,7 +226,8 @@ def GetCType(t, param=False, local=False):
       assert len(t.args) == 1, t.args
       type_param = t.args[0]
       inner_c_type = GetCType(type_param)
-      c_type = 'ListIter<%s>' % inner_c_type
+      c_type = 'Generator<%s>' % inner_c_type
+      is_pointer = True
 
     else:
       # note: fullname => 'parse.Lexer'; name => 'Lexer'
@@ -291,10 +301,9 @@ def GetCType(t, param=False, local=False):
   return c_type
 
 
-def GetCReturnType(t) -> Tuple[str, bool, Optional[str]]:
+def GetCReturnType(t) -> Tuple[str, bool]:
   """
-  Returns a C string, whether the tuple-by-value optimization was applied, and
-  the C type of an extra output param if the function is a generator.
+  Returns a C string, and whether the tuple-by-value optimization was applied.
   """
 
   c_ret_type = GetCType(t)
@@ -302,13 +311,200 @@ def GetCReturnType(t) -> Tuple[str, bool, Optional[str]]:
   # Optimization: Return tupels BY VALUE
   if isinstance(t, TupleType):
     assert c_ret_type.endswith('*')
-    return c_ret_type[:-1], True, None
-  elif c_ret_type.startswith('ListIter<'):
-    assert len(t.args) == 1, t.args
-    inner_c_type = GetCType(t.args[0])
-    return 'void', False, 'List<%s>*' % inner_c_type
+    return c_ret_type[:-1], True
   else:
-    return c_ret_type, False, None
+    return c_ret_type, False
+
+
+class YieldPoints(TraverserVisitor):
+  """Find the yields in a generator function.
+
+  A generator is translated to a class with a Next() method that jumps back to
+  where the last yield left off.  So we number each yield, and remember which
+  loops and try blocks we have to jump into.
+  """
+
+  def __init__(self) -> None:
+    TraverserVisitor.__init__(self)
+    self.states: Dict[YieldExpr, int] = {}  # starts at 1
+    self.try_chains: Dict[YieldExpr, List[TryStmt]] = {}
+    self.try_ids: Dict[TryStmt, int] = {}
+    self.loops: Set[ForStmt] = set()  # loops containing a yield
+    self.returns_value = False
+    self.errors: List[Tuple[Node, str]] = []
+
+    self.try_stack: List[TryStmt] = []
+    self.loop_stack: List[ForStmt] = []
+    self.with_depth = 0
+    self.handler_depth = 0
+
+  def IsGenerator(self, func_node: FuncDef) -> bool:
+    # 'def Matches(self): pass' is an empty generator, e.g. a base class
+    # method.  But a function can also return another function's Iterator[T].
+    if self.states:
+      return True
+    ret_type = func_node.type.ret_type
+    return (isinstance(ret_type, Instance) and
+            ret_type.type.fullname == 'typing.Iterator' and
+            not self.returns_value)
+
+  def Targets(self, try_node: Optional[TryStmt]) -> List[Tuple[int, str]]:
+    """Where to jump on resume, at the top of a try block or of Next()."""
+    targets = []
+    for y, state in sorted(self.states.items(), key=lambda pair: pair[1]):
+      chain = self.try_chains[y]
+      if try_node is None:
+        i = 0
+      elif try_node in chain:
+        i = chain.index(try_node) + 1
+      else:
+        continue
+
+      if i < len(chain):  # jump to the next try block, which dispatches again
+        label = '_try%d' % self.try_ids[chain[i]]
+      else:
+        label = '_resume%d' % state
+      targets.append((state, label))
+    return targets
+
+  def visit_func_def(self, o: FuncDef) -> None:
+    pass  # no nested functions
+
+  def visit_yield_expr(self, o: YieldExpr) -> None:
+    if self.with_depth:
+      self.errors.append((o, "yield isn't allowed in a with block"))
+    if self.handler_depth:
+      self.errors.append(
+          (o, "yield isn't allowed in except, else, or finally blocks"))
+
+    self.states[o] = len(self.states) + 1
+    self.try_chains[o] = list(self.try_stack)
+    for t in self.try_stack:
+      if t not in self.try_ids:
+        self.try_ids[t] = len(self.try_ids)
+    self.loops.update(self.loop_stack)
+
+  def visit_return_stmt(self, o: ReturnStmt) -> None:
+    if o.expr and not (isinstance(o.expr, NameExpr) and o.expr.name == 'None'):
+      self.returns_value = True
+
+  def visit_for_stmt(self, o: ForStmt) -> None:
+    self.loop_stack.append(o)
+    o.body.accept(self)
+    self.loop_stack.pop()
+
+  def visit_with_stmt(self, o: WithStmt) -> None:
+    self.with_depth += 1
+    o.body.accept(self)
+    self.with_depth -= 1
+
+  def visit_try_stmt(self, o: TryStmt) -> None:
+    self.try_stack.append(o)
+    o.body.accept(self)
+    self.try_stack.pop()
+
+    self.handler_depth += 1
+    for handler in o.handlers:
+      handler.accept(self)
+    if o.else_body:
+      o.else_body.accept(self)
+    if o.finally_body:
+      o.finally_body.accept(self)
+    self.handler_depth -= 1
+
+
+class _LoopBreaks(TraverserVisitor):
+  """Find a break that exits the enclosing loop.
+
+  In C++ it would exit a switch statement instead.
+  """
+
+  def __init__(self) -> None:
+    TraverserVisitor.__init__(self)
+    self.found = False
+
+  def visit_break_stmt(self, o: 'mypy.nodes.BreakStmt') -> None:
+    self.found = True
+
+  def visit_while_stmt(self, o: 'mypy.nodes.WhileStmt') -> None:
+    pass  # a break in here exits the inner loop
+
+  def visit_for_stmt(self, o: ForStmt) -> None:
+    pass
+
+  def visit_func_def(self, o: FuncDef) -> None:
+    pass
+
+
+def _TagComparison(cond: Expression) -> Optional[Tuple[NameExpr, MemberExpr]]:
+  """For 'x.tag_() == value_e.Str', return (x, value_e.Str)."""
+  if not (isinstance(cond, ComparisonExpr) and cond.operators == ['==']):
+    return None
+  left, right = cond.operands
+  if not (isinstance(left, CallExpr) and isinstance(left.callee, MemberExpr) and
+          left.callee.name == 'tag_' and not left.args):
+    return None
+  subject = left.callee.expr
+  if not isinstance(subject, NameExpr):
+    return None
+  if not (isinstance(right, MemberExpr) and isinstance(right.expr, NameExpr) and
+          right.expr.name.endswith('_e')):
+    return None
+  return subject, right
+
+
+def _TagCascade(o: IfStmt):
+  """Flatten an if/elif chain that compares one variable's tag_().
+
+  Returns (x, [(tag, body), ...], else_body) when there are at least 3 tags,
+  so it can be written as a switch like tagswitch().  Otherwise None.
+  """
+  subject = None
+  branches = []
+  seen = set()
+  node = o
+  else_body = None
+  while True:
+    if len(node.expr) != 1:
+      return None
+    pair = _TagComparison(node.expr[0])
+    if pair is None:
+      if node is o:
+        return None
+      else_body = Block([node])  # if (...) inside default:
+      break
+    x, tag = pair
+    if subject is None:
+      subject = x
+    elif x.name != subject.name:
+      return None
+    key = (tag.expr.name, tag.name)
+    if key in seen:
+      return None  # duplicate case label
+    seen.add(key)
+    branches.append((tag, node.body[0]))
+
+    rest = node.else_body
+    if rest is None:
+      break
+    if len(rest.body) == 1 and isinstance(rest.body[0], IfStmt):
+      node = rest.body[0]  # elif
+    else:
+      else_body = rest
+      break
+
+  if len(branches) < 3:
+    return None
+
+  finder = _LoopBreaks()
+  for _, body in branches:
+    body.accept(finder)
+  if else_body:
+    else_body.accept(finder)
+  if finder.found:
+    return None
+
+  return subject, branches, else_body
 
 
 def PythonStringLiteral(s: str) -> str:
@@ -348,9 +544,12 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
       self.local_var_list = []  # Collected at assignment
       self.prepend_to_block = None  # For writing vars after {
       self.current_func_node = None
-      self.current_stmt_node = None
-      # Temporary lists to use as output params for generators
-      self.yield_accumulators = {}  # type: Dict[Union[Statement, FuncDef], Tuple[str, str]]
+      # Set while writing the body of a generator.  Its locals become members
+      # of a class, which we collect in gen_members.
+      self.yield_points: Optional[YieldPoints] = None
+      self.gen_members: Dict[str, str] = {}
+      self.gen_renames: Dict[str, str] = {}
+      self.gen_dispatch = None  # For writing a jump table after {
 
       # This is cleared when we start visiting a class.  Then we visit all the
       # methods, and accumulate the types of everything that looks like
@@ -550,10 +749,11 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
           self.write('false')
           return
         if o.name == 'self':
-          self.write('this')
+          # In a generator, 'this' is the generator object
+          self.write('self_' if self.yield_points else 'this')
           return
 
-        self.write(o.name)
+        self.write(self.gen_renames.get(o.name, o.name))
 
     def visit_member_expr(self, o: 'mypy.nodes.MemberExpr') -> T:
         t = self.types[o]
@@ -588,10 +788,8 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
         pass
 
     def visit_yield_expr(self, o: 'mypy.nodes.YieldExpr') -> T:
-        assert self.current_func_node in self.yield_accumulators
-        self.write_ind('%s->append(', self.yield_accumulators[self.current_func_node][0])
-        self.accept(o.expr)
-        self.write(');\n')
+        # Handled by visit_expression_stmt
+        raise AssertionError("yield can't be used as an expression")
 
     def _WriteArgList(self, o):
       self.write('(')
@@ -599,17 +797,6 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
         if i != 0:
           self.write(', ')
         self.accept(arg)
-
-      # Will be set if we're:
-      # a) accumulating the output of an iterator
-      # b) constructing an iterator with the result of (a)
-      if self.current_stmt_node in self.yield_accumulators:
-        if len(o.args) > 0:
-          self.write(', ')
-
-        arg_name, _ = self.yield_accumulators[self.current_stmt_node]
-        self.write('&%s', arg_name)
-
       self.write(')')
 
     def _IsInstantiation(self, o):
@@ -700,11 +887,31 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
           self.write('))')
           return
 
+        # ''.join([a, b, c]) => str_concat_n({a, b, c}) without the temporary
+        # List.  A literal separator goes between the parts.
+        if (o.callee.name == 'join' and isinstance(o.callee, MemberExpr) and
+            isinstance(o.callee.expr, StrExpr) and len(o.args) == 1 and
+            isinstance(o.args[0], ListExpr) and len(o.args[0].items) > 1):
+          parts = []  # type: List[Expression]
+          for i, item in enumerate(o.args[0].items):
+            if i != 0 and o.callee.expr.value:
+              parts.append(o.callee.expr)
+            parts.append(item)
+          self._WriteStrConcatN(parts)
+          return
+
         callee_name = o.callee.name
 
         if isinstance(o.callee, MemberExpr) and callee_name == 'next':
           self.accept(o.callee.expr)
-          self.write('.iterNext')
+          self.write('->iterNext')
+          self._WriteArgList(o)
+          return
+
+        # deque() or deque(L) => NewDeque<T>()
+        if callee_name == 'deque':
+          c_type = GetCType(self.types[o])
+          self.write('New%s' % c_type[:-1])  # remove *
           self._WriteArgList(o)
           return
 
@@ -731,6 +938,22 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
         #self.log('  arg_kinds %s', o.arg_kinds)
         #self.log('  arg_names %s', o.arg_names)
 
+    def _StrConcatParts(self, o: 'mypy.nodes.Expression') -> List[Expression]:
+        """Flatten a + b + c into [a, b, c], so we allocate only once."""
+        if (isinstance(o, OpExpr) and o.op == '+' and
+            GetCType(self.types[o.left]) == 'Str*' and
+            GetCType(self.types[o.right]) == 'Str*'):
+          return self._StrConcatParts(o.left) + self._StrConcatParts(o.right)
+        return [o]
+
+    def _WriteStrConcatN(self, parts: List[Expression]) -> None:
+        self.write('str_concat_n({')
+        for i, part in enumerate(parts):
+          if i != 0:
+            self.write(', ')
+          self.accept(part)
+        self.write('})')
+
     def visit_op_expr(self, o: 'mypy.nodes.OpExpr') -> T:
         # a + b when a and b are strings.  (Can't use operator overloading
         # because they're pointers.)
@@ -749,11 +972,15 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
 
         # 'abc' + 'def'
         if left_ctype == right_ctype == 'Str*' and c_op == '+':
-          self.write('str_concat(')
-          self.accept(o.left)
-          self.write(', ')
-          self.accept(o.right)
-          self.write(')')
+          parts = self._StrConcatParts(o)
+          if len(parts) == 2:
+            self.write('str_concat(')
+            self.accept(o.left)
+            self.write(', ')
+            self.accept(o.right)
+            self.write(')')
+          else:
+            self._WriteStrConcatN(parts)
           return
 
         # 'abc' * 3
@@ -1266,6 +1493,13 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
             key_c_type = GetCType(key_type)
             val_c_type = GetCType(val_type)
 
+            if self.yield_points:
+              self._AddGenMember(lval.name,
+                                 'Dict<%s, %s>*' % (key_c_type, val_c_type))
+              self.write_ind('%s = NewDict<%s, %s>();\n',
+                             lval.name, key_c_type, val_c_type)
+              return
+
             self.write_ind('auto* %s = NewDict<%s, %s>();\n',
                            lval.name, key_c_type, val_c_type)
             # Doesn't take elememnts
@@ -1291,6 +1525,10 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
                 self.local_var_list.append((lval.name, subtype_name))
               self.write_ind(
                   '%s = %s<%s>(', lval.name, cast_kind, subtype_name)
+            elif self.yield_points:
+              self._AddGenMember(lval.name, subtype_name, node=o)
+              self.write_ind(
+                  '%s = %s<%s>(', lval.name, cast_kind, subtype_name)
             else:
               self.write_ind(
                   '%s %s = %s<%s>(', subtype_name, lval.name, cast_kind,
@@ -1300,26 +1538,6 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
             self.write(');\n')
             return
 
-          rval_type = self.types[o.rvalue]
-          if isinstance(rval_type, Instance) and rval_type.type.fullname == 'typing.Iterator':
-            # We're calling a generator. Create a temporary List<T> on the stack
-            # to accumulate the results in one big batch, then wrap it in
-            # ListIter<T>.
-            assert len(rval_type.args) == 1, rval_type.args
-            c_type = GetCType(rval_type)
-            type_param = rval_type.args[0]
-            inner_c_type = GetCType(type_param)
-            iter_buf = ('_iter_buf_%s' % lval.name, 'List<%s>*' % inner_c_type)
-            self.write_ind('List<%s> %s;\n', inner_c_type, iter_buf[0])
-            self.current_stmt_node = o
-            self.yield_accumulators[o] = iter_buf
-            self.write_ind('')
-            self.accept(o.rvalue)
-            self.current_stmt_node = None
-            self.write(';\n')
-            self.write_ind('%s %s(&%s);\n', c_type, lval.name, iter_buf[0])
-            return
-
         if isinstance(lval, NameExpr):
           if _SkipAssignment(lval.name):
             return
@@ -1485,6 +1703,13 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
 
           temp_name = 'tup%d' % self.unique_id
           self.unique_id += 1
+
+          # A generator may jump past this statement, so the temporary must
+          # be in its own scope.
+          if self.yield_points:
+            self.write_ind('{\n')
+            self.indent += 1
+
           self.write_ind('%s %s = ', c_type, temp_name)
 
           self.accept(o.rvalue)
@@ -1493,6 +1718,10 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
           self._write_tuple_unpacking(temp_name, lval.items, rvalue_type.items,
                                       is_return=is_return)
 
+          if self.yield_points:
+            self.indent -= 1
+            self.write_ind('}\n')
+
         else:
           raise AssertionError(lval)
 
@@ -1507,6 +1736,12 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
             self.accept(stmt)
 
     def visit_for_stmt(self, o: 'mypy.nodes.ForStmt') -> T:
+        # In C++, the loop variable goes out of scope after the loop
+        saved_renames = dict(self.gen_renames)
+        self._write_for(o)
+        self.gen_renames = saved_renames
+
+    def _write_for(self, o: 'mypy.nodes.ForStmt') -> None:
         if 0:
           self.log('ForStmt')
           self.log('  index_type %s', o.index_type)
@@ -1523,13 +1758,20 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
           args = o.expr.args
           num_args = len(args)
 
+          # A generator may jump into the loop, so it can't declare anything
+          if self.yield_points:
+            index_name = self._AddGenMember(index_name, 'int')
+            index_decl = index_name
+          else:
+            index_decl = 'int %s' % index_name
+
           if num_args == 1:  # xrange(end)
-            self.write_ind('for (int %s = 0; %s < ', index_name, index_name)
+            self.write_ind('for (%s = 0; %s < ', index_decl, index_name)
             self.accept(args[0])
             self.write('; ++%s) ', index_name)
 
           elif num_args == 2:  # xrange(being, end)
-            self.write_ind('for (int %s = ', index_name)
+            self.write_ind('for (%s = ', index_decl)
             self.accept(args[0])
             self.write('; %s < ', index_name)
             self.accept(args[1])
@@ -1545,7 +1787,7 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
             else:
               comparison_op = '<'
 
-            self.write_ind('for (int %s = ', index_name)
+            self.write_ind('for (%s = ', index_decl)
             self.accept(args[0])
             self.write('; %s %s ', index_name, comparison_op)
             self.accept(args[1])
@@ -1613,7 +1855,7 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
         #self.log('  iterating over type %s', over_type.type.fullname)
 
         over_dict = False
-        yield_acc = None
+        over_gen = False
 
         if over_type.type.fullname == 'builtins.list':
           c_type = GetCType(over_type)
@@ -1634,25 +1876,26 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
 
           assert not reverse
 
+        elif over_type.type.fullname == 'collections.deque':
+          c_type = GetCType(over_type)
+          assert c_type.endswith('*'), c_type
+          c_iter_type = c_type.replace('Deque', 'DequeIter', 1)[:-1]
+
+          assert not reverse
+
         elif over_type.type.fullname == 'builtins.str':
           c_iter_type = 'StrIter'
           assert not reverse  # can't reverse iterate over string yet
 
         elif over_type.type.fullname == 'typing.Iterator':
-          # We're iterating over a generator. Create a temporary List<T> on the stack
-          # to accumulate the results in one big batch.
-          c_iter_type = GetCType(over_type)
-          assert len(over_type.args) == 1, over_type.args
-          inner_c_type = GetCType(over_type.args[0])
-          yield_acc = ('_for_yield_acc%d' % self.unique_id, 'List<%s>*' % inner_c_type)
-          self.unique_id += 1
-          self.write_ind('List<%s> %s;\n', inner_c_type, yield_acc[0])
-          self.write_ind('')
-          self.yield_accumulators[o] = yield_acc
-          self.current_stmt_node = o
-          self.accept(iterated_over)
-          self.current_stmt_node = None
-          self.write(';\n')
+          # We're iterating over a generator, which is resumed for each item.
+          c_type = GetCType(over_type)
+          assert c_type.endswith('*'), c_type
+          c_iter_type = c_type.replace('Generator', 'GenIter', 1)[:-1]
+
+          over_gen = True
+
+          assert not reverse
 
         else:  # assume it's like d.iteritems()?  Iterator type
           assert False, over_type
@@ -1666,30 +1909,71 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
         else:
           index_update = ''
 
-        self.write_ind('for (%s it(', c_iter_type)
-        if yield_acc:
-          self.write('&%s', yield_acc[0])
+        # A generator can jump into the middle of a loop that contains a
+        # yield, so the loop state has to be in members rather than an
+        # iterator on the stack.
+        if self.yield_points and o in self.yield_points.loops:
+          if over_gen:
+            it_name = self._AddGenMember('_for_gen%d' % self.unique_id, c_type)
+            self.unique_id += 1
+
+            self.write_ind('for (%s = ', it_name)
+            self.accept(iterated_over)
+            self.write('; %s->Next(); %s) {\n', it_name, index_update[2:])
+            value_expr = '%s->Value()' % it_name
+
+          elif over_type.type.fullname == 'builtins.list':
+            list_name = self._AddGenMember('_for_list%d' % self.unique_id, c_type)
+            i_name = self._AddGenMember('_for_i%d' % self.unique_id, 'int')
+            self.unique_id += 1
+
+            self.write_ind('for (%s = ', list_name)
+            self.accept(iterated_over)
+            if reverse:
+              self.write(', %s = len(%s) - 1; %s >= 0; --%s%s) {\n',
+                         i_name, list_name, i_name, i_name, index_update)
+            else:
+              self.write(', %s = 0; %s < len(%s); ++%s%s) {\n',
+                         i_name, i_name, list_name, i_name, index_update)
+            value_expr = '%s->index_(%s)' % (list_name, i_name)
+
+          else:
+            self.report_error(o, "Can't yield in a loop over %s" % over_type)
+            return
+
+          key_expr = None
+
         else:
+          self.write_ind('for (%s it(', c_iter_type)
           self.accept(iterated_over)  # the thing being iterated over
-        self.write('); !it.Done(); it.Next()%s) {\n', index_update)
+          self.write('); !it.Done(); it.Next()%s) {\n', index_update)
+
+          value_expr = 'it.Value()'
+          key_expr = 'it.Key()'
 
         # for x in it: ...
         # for i, x in enumerate(pairs): ...
 
         if isinstance(item_type, Instance) or index0_name:
           c_item_type = GetCType(item_type)
-          self.write_ind('  %s ', c_item_type)
-          self.accept(index_expr)
-          if over_dict:
-            self.write(' = it.Key();\n')
-          else: 
-            self.write(' = it.Value();\n')
-
-          # Register loop variable as a stack root.
-          if CTypeIsManaged(c_item_type):
-            self.write_ind('  StackRoots _for({&');
+          if self.yield_points:
+            # Locals of a generator are members, which are traced by the GC
+            self.write_ind('  %s = %s;\n',
+                self._AddGenMember(index_expr.name, c_item_type),
+                key_expr if over_dict else value_expr)
+          else:
+            self.write_ind('  %s ', c_item_type)
             self.accept(index_expr)
-            self.write_ind('});\n')
+            if over_dict:
+              self.write(' = %s;\n', key_expr)
+            else:
+              self.write(' = %s;\n', value_expr)
+
+            # Register loop variable as a stack root.
+            if CTypeIsManaged(c_item_type):
+              self.write_ind('  StackRoots _for({&');
+              self.accept(index_expr)
+              self.write_ind('});\n')
 
         elif isinstance(item_type, TupleType):  # for x, y in pairs
           if over_dict:
@@ -1701,9 +1985,17 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
             key_type = GetCType(item_type.items[0])
             val_type = GetCType(item_type.items[1])
 
-            # TODO(StackRoots): k, v
-            self.write_ind('  %s %s = it.Key();\n', key_type, index_items[0].name)
-            self.write_ind('  %s %s = it.Value();\n', val_type, index_items[1].name)
+            if self.yield_points:
+              self.write_ind('  %s = %s;\n',
+                  self._AddGenMember(index_items[0].name, key_type), key_expr)
+              self.write_ind('  %s = %s;\n',
+                  self._AddGenMember(index_items[1].name, val_type), value_expr)
+            else:
+              # TODO(StackRoots): k, v
+              self.write_ind('  %s %s = %s;\n', key_type, index_items[0].name,
+                             key_expr)
+              self.write_ind('  %s %s = %s;\n', val_type, index_items[1].name,
+                             value_expr)
 
           else:
             # Example:
@@ -1720,7 +2012,12 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
               # TODO(StackRoots)
               temp_name = 'tup%d' % self.unique_id
               self.unique_id += 1
-              self.write_ind('  %s %s = it.Value();\n', c_item_type, temp_name)
+              if self.yield_points:
+                temp_name = self._AddGenMember(temp_name, c_item_type)
+                self.write_ind('  %s = %s;\n', temp_name, value_expr)
+              else:
+                self.write_ind('  %s %s = %s;\n', c_item_type, temp_name,
+                               value_expr)
 
               self.indent += 1
 
@@ -1728,8 +2025,12 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
                   temp_name, o.index.items, item_type.items)
 
               self.indent -= 1
+            elif self.yield_points:
+              self.write_ind('  %s = %s;\n',
+                  self._AddGenMember(o.index.name, c_item_type), value_expr)
             else:
-              self.write_ind('  %s %s = it.Value();\n', c_item_type, o.index.name)
+              self.write_ind('  %s %s = %s;\n', c_item_type, o.index.name,
+                             value_expr)
               #self.write_ind('  StackRoots _for(&%s)\n;', o.index.name)
 
         else:
@@ -2002,15 +2303,6 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
             self.log('  initializer %s', arg.initializer)
             self.log('  kind %s', arg.kind)
 
-        # Will be set if we're declaring or defining a function that returns
-        # Iterator[T].
-        if self.current_func_node in self.yield_accumulators:
-          if not first:
-            self.decl_write(', ')
-
-          arg_name, c_type = self.yield_accumulators[self.current_func_node]
-          self.decl_write('%s %s', c_type, arg_name)
-
     def visit_func_def(self, o: 'mypy.nodes.FuncDef') -> T:
         if o.name == '__repr__':  # Don't translate
           return
@@ -2041,11 +2333,17 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
 
         self.write('\n')
 
-        c_ret_type, _, c_iter_list_type = GetCReturnType(o.type.ret_type)
-        if c_iter_list_type is not None:
-          # The function is a generator. Add an output param that references an
-          # accumulator for the results.
-          self.yield_accumulators[o] = ('_out_yield_acc', c_iter_list_type)
+        c_ret_type, _ = GetCReturnType(o.type.ret_type)
+
+        # A generator is a class.  The function just allocates an instance.
+        frame_name = None
+        if not self.decl:
+          yield_points = YieldPoints()
+          o.body.accept(yield_points)
+          if yield_points.IsGenerator(o):
+            for node, msg in yield_points.errors:
+              self.report_error(node, msg)
+            frame_name = self._WriteGenerator(o, yield_points)
 
         # Avoid ++ warnings by prepending [[noreturn]]
         noreturn = ''
@@ -2069,6 +2367,25 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
 
         self.write(') ')
 
+        if frame_name:
+          self.write('{\n')
+          args = ['this'] if self.current_class_name else []
+          roots = []
+          for arg_type, arg in zip(o.type.arg_types, o.arguments):
+            arg_name = arg.variable.name
+            if arg_name == 'self':
+              continue
+            args.append(arg_name)
+            if CTypeIsManaged(GetCType(arg_type)):
+              roots.append('&%s' % arg_name)
+          if roots:
+            self.write('  StackRoots _roots({%s});\n', ', '.join(roots))
+          self.write('  return Alloc<%s>(%s);\n', frame_name, ', '.join(args))
+          self.write('}\n')
+
+          self.current_func_node = None
+          return
+
         # Write local vars we collected in the 'decl' phase
         if not self.forward_decl and not self.decl:
           arg_names = [arg.variable.name for arg in o.arguments]
@@ -2082,6 +2399,135 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
         self.accept(o.body)
         self.current_func_node = None
 
+    def _AddGenMember(self, name: str, c_type: str, node=None) -> str:
+        """Make a local of a generator a member.  Returns its C++ name."""
+        existing = self.gen_members.get(name)
+        if existing is None or existing == c_type:
+          self.gen_members[name] = c_type
+          return name
+
+        # A downcast like val = cast(value__Str, UP_val) declares a new C++
+        # variable in an inner scope.  In a generator, it gets its own member.
+        new_name = '%s_%d' % (name, self.unique_id)
+        self.unique_id += 1
+        self.gen_members[new_name] = c_type
+        self.gen_renames[name] = new_name
+        return new_name
+
+    def _WriteGenDispatch(self, targets, top_level=False):
+        """Jump to where a generator left off."""
+        self.write_ind('switch (state_) {\n')
+        if top_level:
+          self.write_ind('case 0:\n')
+          self.write_ind('  state_ = -1;  // done, unless we yield\n')
+          self.write_ind('  break;\n')
+        for state, label in targets:
+          self.write_ind('case %d:\n', state)
+          self.write_ind('  goto %s;\n', label)
+        if top_level:
+          self.write_ind('default:\n')
+          self.write_ind('  return false;\n')
+        self.write_ind('}\n')
+        self.write('\n')
+
+    def _WriteGenerator(self, o: 'mypy.nodes.FuncDef',
+                        yield_points: YieldPoints) -> str:
+        """
+        Write a subclass of Generator<T> for a function containing 'yield'.
+
+        Params and locals become members, and the body becomes a Next() method
+        that jumps to the label after the last yield.
+        """
+        class_name = self.current_class_name
+        if class_name:
+          frame_name = '%s_%s_gen' % (class_name, o.name)
+        else:
+          frame_name = '%s_gen' % o.name
+
+        ret_type = o.type.ret_type
+        assert ret_type.type.fullname == 'typing.Iterator', ret_type
+        value_c_type = GetCType(ret_type.args[0])
+
+        params = []
+        if class_name:
+          params.append(('self_', '%s*' % class_name))
+        for arg_type, arg in zip(o.type.arg_types, o.arguments):
+          if arg.variable.name != 'self':
+            params.append((arg.variable.name, GetCType(arg_type)))
+
+        self.gen_members = {}
+        for name, c_type in params:
+          self.gen_members[name] = c_type
+        for name, c_type in self.local_vars[o]:
+          self.gen_members.setdefault(name, c_type)
+        self.gen_members['value_'] = value_c_type
+
+        # Write the body first, since it can add members
+        saved_f = self.f
+        self.f = io.StringIO()
+        self.yield_points = yield_points
+        self.gen_renames = {}
+        self.current_func_node = o
+
+        self.indent += 1
+        self._WriteGenDispatch(yield_points.Targets(None), top_level=True)
+        self._write_body(o.body.body)
+        self.write_ind('state_ = -1;\n')
+        self.write_ind('return false;\n')
+        self.indent -= 1
+
+        body = self.f.getvalue()
+        self.f = saved_f
+        self.yield_points = None
+        self.gen_renames = {}
+
+        # Pointers first, for HeapTag::Scanned
+        pointer_members = []
+        other_members = []
+        for name, c_type in self.gen_members.items():
+          if CTypeIsManaged(c_type):
+            pointer_members.append((name, c_type))
+          else:
+            other_members.append((name, c_type))
+        other_members.append(('state_', 'int'))
+        members = pointer_members + other_members
+
+        param_names = [name for name, _ in params]
+
+        self.write('class %s : public Generator<%s> {\n', frame_name,
+                   value_c_type)
+        self.write(' public:\n')
+        self.write('  %s(%s)\n', frame_name, ', '.join(
+            '%s %s' % (c_type, 'self' if name == 'self_' else name)
+            for name, c_type in params))
+        self.write('      : Generator<%s>(%d)', value_c_type,
+                   len(pointer_members))
+        for name, _ in members:
+          if name == 'self_':
+            self.write(',\n        self_(self)')
+          elif name in param_names:
+            self.write(',\n        %s(%s)', name, name)
+          else:
+            self.write(',\n        %s()', name)
+        self.write(' {\n')
+        self.write('  }\n')
+        self.write('  bool Next();\n')
+        self.write('  %s Value() {\n', value_c_type)
+        self.write('    return value_;\n')
+        self.write('  }\n')
+        self.write('\n')
+        for name, c_type in members:
+          self.write('  %s %s;\n', c_type, name)
+        self.write('};\n')
+        self.write('\n')
+
+        self.write('bool %s::Next() {\n', frame_name)
+        self.write(body)
+        self.write('}\n')
+        self.write('\n')
+
+        return frame_name
+
     def visit_overloaded_func_def(self, o: 'mypy.nodes.OverloadedFuncDef') -> T:
         pass
 
@@ -2458,6 +2904,14 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
 
         self.indent += 1
 
+        if self.gen_dispatch is not None:
+          self._WriteGenDispatch(self.gen_dispatch)
+          self.gen_dispatch = None
+
+        # Like C++ scopes, a downcast in a generator only renames a variable
+        # until the end of the block
+        saved_renames = dict(self.gen_renames)
+
         if self.prepend_to_block:
           done = set()
           for lval_name, c_type, is_param in self.prepend_to_block:
@@ -2487,6 +2941,7 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
           self.prepend_to_block = None
 
         self._write_body(block.body)
+        self.gen_renames = saved_renames
 
         self.indent -= 1
         self.write_ind('}\n')
@@ -2495,6 +2950,22 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
         # TODO: Avoid writing docstrings.
         # If it's just a string, then we don't need it.
 
+        if isinstance(o.expr, YieldExpr):
+          if self.decl:
+            return
+
+          # Save the value and state, and resume at the label next time
+          state = self.yield_points.states[o.expr]
+          if o.expr.expr:
+            self.write_ind('value_ = ')
+            self.accept(o.expr.expr)
+            self.write(';\n')
+          self.write_ind('state_ = %d;\n', state)
+          self.write_ind('return true;\n')
+          self.write_ind('_resume%d:\n', state)
+          self.write_ind('state_ = -1;  // done, unless we yield again\n')
+          return
+
         self.write_ind('')
         self.accept(o.expr)
         self.write(';\n')
@@ -2517,6 +2988,11 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
         # return
         # return None
         # return my_int + 3;
+        if self.yield_points:
+          self.write_ind('state_ = -1;\n')
+          self.write_ind('return false;\n')
+          return
+
         self.write_ind('return ')
         if o.expr:
           if not (isinstance(o.expr, NameExpr) and o.expr.name == 'None'):
@@ -2526,7 +3002,7 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
             # latter.
             ret_type = self.current_func_node.type.ret_type
 
-            c_ret_type, returning_tuple, _ = GetCReturnType(ret_type)
+            c_ret_type, returning_tuple = GetCReturnType(ret_type)
 
             # return '', None  # tuple literal
             #   but NOT
@@ -2601,6 +3077,28 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
             self.write_ind('// endif MYCPP\n')
           return
 
+        # if x.tag_() == a_e.A: ... elif x.tag_() == a_e.B: ... is written
+        # as a switch, which compiles to a jump table
+        cascade = None if self.yield_points else _TagCascade(o)
+        if cascade:
+          subject, branches, else_body = cascade
+          self.write_ind('switch (')
+          self.accept(subject)
+          self.write('->tag_()) {\n')
+          self.indent += 1
+          for tag, body in branches:
+            self.write_ind('case ')
+            self.accept(tag)
+            self.write(': ')
+            self.accept(body)
+            self.write_ind('  break;\n')
+          if else_body:
+            self.write_ind('default: ')
+            self.accept(else_body)
+          self.indent -= 1
+          self.write_ind('}\n')
+          return
+
         self.write_ind('if (')
         for e in o.expr:
           self.accept(e)
@@ -2631,6 +3129,12 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
           if o.expr.callee.name == 'NotImplementedError':
             self.write_ind('FAIL(kNotImplemented);  // Python NotImplementedError\n')
             return
+          # Exceptions without fields are global instances, so throwing them
+          # doesn't allocate.  See mycpp/gc_builtins.h.
+          if (o.expr.callee.name in ('IndexError', 'KeyError', 'StopIteration')
+              and not o.expr.args):
+            self.write_ind('throw k%s;\n', o.expr.callee.name)
+            return
 
         self.write_ind('throw ')
         # it could be raise -> throw ; .  OSH uses that.
@@ -2639,6 +3143,13 @@ class Generate(ExpressionVisitor[T], StatementVisitor[None]):
         self.write(';\n')
 
     def visit_try_stmt(self, o: 'mypy.nodes.TryStmt') -> T:
+        # C++ doesn't allow jumping into a try block from outside.  So a
+        # generator jumps to just before it, and then to the yield from the
+        # inside.
+        if self.yield_points and o in self.yield_points.try_ids:
+          self.write_ind('_try%d:\n', self.yield_points.try_ids[o])
+          self.gen_dispatch = self.yield_points.Targets(o)
+
         self.write_ind('try ')
         self.accept(o.body)
         caught = False
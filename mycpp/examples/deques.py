@@ -0,0 +1,92 @@
+#!/usr/bin/env python2
+"""
+deques.py: collections.deque is translated to Deque<T>
+"""
+from __future__ import print_function
+
+import os
+from collections import deque
+
+from mycpp.mylib import log
+
+from typing import List, TYPE_CHECKING
+if TYPE_CHECKING:
+  from typing import Deque  # not in Python 2's typing module
+
+
+class Lookahead(object):
+  """Like a parser that consumes tokens from the front."""
+
+  def __init__(self, words):
+    # type: (List[str]) -> None
+    self.pending = deque(words)  # type: Deque[str]
+
+  def Peek(self):
+    # type: () -> str
+    if len(self.pending) == 0:
+      return ''
+    return self.pending[0]
+
+  def Next(self):
+    # type: () -> str
+    return self.pending.popleft()
+
+  def PushBack(self, w):
+    # type: (str) -> None
+    self.pending.appendleft(w)
+
+
+def run_tests():
+  # type: () -> None
+  q = deque()  # type: Deque[int]
+  q.append(1)
+  q.append(2)
+  q.appendleft(0)
+  log('len %d', len(q))
+  log('q[0] %d q[-1] %d', q[0], q[-1])
+
+  for i in q:
+    log('i %d', i)
+
+  log('popleft %d', q.popleft())
+  log('pop %d', q.pop())
+  log('len %d', len(q))
+
+  try:
+    q.pop()
+    q.pop()
+  except IndexError:
+    log('IndexError')
+
+  lex = Lookahead(['echo', 'hi', ';', 'ls'])
+  while len(lex.Peek()):
+    w = lex.Next()
+    if w == ';':
+      lex.PushBack('newline')
+      w = lex.Next()
+    log('word %s', w)
+
+
+def run_benchmarks():
+  # type: () -> None
+  # Consume a long list from the front, like the args of a big command, or
+  # the lines of a long here doc.
+  words = []  # type: List[str]
+  for i in xrange(100000):
+    words.append('w%d' % i)
+
+  n = 0
+  for j in xrange(10):
+    q = deque(words)  # type: Deque[str]
+    while len(q):
+      w = q.popleft()
+      n += len(w)
+  log('n = %d', n)
+
+
+if __name__ == '__main__':
+  if os.getenv('BENCHMARK'):
+    log('Benchmarking...')
+    run_benchmarks()
+  else:
+    run_tests()
@@ -0,0 +1,146 @@
+#!/usr/bin/env python2
+"""
+generators.py: Generators are lazy, so the caller can stop early
+"""
+from __future__ import print_function
+
+import os
+
+from mycpp.mylib import log
+
+from typing import List, Iterator, Tuple
+
+
+class Action(object):
+
+  def __init__(self):
+    # type: () -> None
+    pass
+
+  def Matches(self, prefix):
+    # type: (str) -> Iterator[str]
+    pass
+
+
+class WordsAction(Action):
+  """Like a FileSystemAction, with the directory listing in memory."""
+
+  def __init__(self, words):
+    # type: (List[str]) -> None
+    Action.__init__(self)
+    self.words = words
+
+  def Matches(self, prefix):
+    # type: (str) -> Iterator[str]
+    for w in self.words:
+      if w.startswith(prefix):
+        yield w
+
+
+class LimitAction(Action):
+
+  def __init__(self, action, limit):
+    # type: (Action, int) -> None
+    Action.__init__(self)
+    self.action = action
+    self.limit = limit
+
+  def Matches(self, prefix):
+    # type: (str) -> Iterator[str]
+    n = 0
+    for m in self.action.Matches(prefix):
+      if n == self.limit:
+        return
+      yield m
+      n += 1
+
+
+def Pairs(words):
+  # type: (List[str]) -> Iterator[Tuple[int, str]]
+  for i, w in enumerate(words):
+    yield i, w
+  for w in reversed(words):
+    yield -1, w
+
+
+def Unpack(words):
+  # type: (List[str]) -> Iterator[str]
+  for i, w in Pairs(words):
+    if i == 1:
+      continue
+    yield '%d %s' % (i, w)
+
+
+def Retry(words, num_tries):
+  # type: (List[str], int) -> Iterator[str]
+  """yield inside try, with an exception from a nested generator."""
+  tries = 0
+  done = False
+  while not done:
+    done = True
+    try:
+      for w in words:
+        if w == 'bad' and tries < num_tries:
+          raise ValueError()
+        yield w
+    except ValueError:
+      log('retrying')
+      tries += 1
+      done = False
+
+
+def MakeWords(n):
+  # type: (int) -> List[str]
+  words = []  # type: List[str]
+  for i in xrange(n):
+    words.append('file%05d' % i)
+  return words
+
+
+def run_tests():
+  # type: () -> None
+  action = WordsAction(['foo', 'bar', 'baz', 'food'])
+  for m in action.Matches('f'):
+    log('match %s', m)
+
+  limit = LimitAction(action, 2)
+  for m in limit.Matches(''):
+    log('limit %s', m)
+
+  for s in Unpack(['a', 'b', 'c']):
+    log('unpack %s', s)
+
+  for w in Retry(['ok', 'bad', 'end'], 2):
+    log('retry %s', w)
+
+  it = action.Matches('ba')
+  log('next %s', it.next())
+  rest = list(it)
+  log('rest %d %s', len(rest), rest[0])
+
+
+def run_benchmarks():
+  # type: () -> None
+  # A 50K entry directory, and readline displays the first page of matches.
+  # Since the generator is lazy, that doesn't depend on the size of the
+  # directory.
+  action = WordsAction(MakeWords(50000))
+  page_size = 20
+
+  n = 0
+  for i in xrange(1000):
+    page = []  # type: List[str]
+    for m in action.Matches('file'):
+      page.append(m)
+      if len(page) == page_size:
+        break
+    n += len(page)
+  log('n = %d', n)
+
+
+if __name__ == '__main__':
+  if os.getenv('BENCHMARK'):
+    log('Benchmarking...')
+    run_benchmarks()
+  else:
+    run_tests()
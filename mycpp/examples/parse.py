@@ -150,6 +150,21 @@ class Parser(object):
     return self.ParseExpr()
 
 
+def NumLeaves(node):
+  # type: (expr_t) -> int
+  """An if / elif chain on tag_() is translated to a switch."""
+  UP_node = node
+  if UP_node.tag_() == expr_e.Const:
+    return 1
+  elif UP_node.tag_() == expr_e.Var:
+    return 1
+  elif UP_node.tag_() == expr_e.Binary:
+    node = cast(expr__Binary, UP_node)
+    return NumLeaves(node.left) + NumLeaves(node.right)
+  else:
+    raise AssertionError()
+
+
 def run_tests():
   # type: () -> None
   lex = Lexer('abc')
@@ -206,6 +221,8 @@ def run_tests():
       else:
         log('Other')
 
+    log('leaves = %d', NumLeaves(node))
+
 
 def run_benchmarks():
   # type: () -> None
@@ -0,0 +1,80 @@
+#!/usr/bin/env python2
+"""
+str_dicts.py: Dict[str, T] is the shell's most common container
+"""
+from __future__ import print_function
+
+import os
+
+from mycpp import mylib
+from mycpp.mylib import log
+
+from typing import List, Dict
+
+
+def run_tests():
+  # type: () -> None
+
+  d = {}  # type: Dict[str, int]
+  d['PATH'] = 1
+  d['HOME'] = 2
+  d['long_name_1'] = 3
+  d['long_name_2'] = 4
+
+  # Same contents, different object
+  key = 'PA' + 'TH'
+  log('PATH = %d', d[key])
+  log('long_name_2 = %d', d['long_name_2'])
+  log('contains long_name_3 = %d', 'long_name_3' in d)
+
+  for i in xrange(100):
+    d['x%d' % i] = i
+  log('len = %d', len(d))
+  log('x99 = %d', d['x99'])
+
+  mylib.dict_erase(d, 'HOME')
+  d['IFS'] = 5
+  log('len = %d', len(d))
+  log('PATH = %d, IFS = %d', d['PATH'], d['IFS'])
+
+
+def run_benchmarks():
+  # type: () -> None
+
+  # Like the shell's variable map: 10K names, looked up much more often than
+  # they're set, plus lookups that miss, like checking for unset variables.
+  n = 10000
+  names = []  # type: List[str]
+  misses = []  # type: List[str]
+  for i in xrange(n):
+    names.append('var%d' % i)
+    misses.append('unset%d' % i)
+
+  d = {}  # type: Dict[str, int]
+  for name in names:
+    d[name] = 0
+
+  total = 0
+  num_missing = 0
+  for j in xrange(20):
+    for name in names:
+      d[name] = d[name] + 1
+      total += d[name]
+    for name in misses:
+      if name not in d:
+        num_missing += 1
+    # Global string keys, like $PATH and $IFS
+    if 'PATH' in d:
+      total += 1
+    d['IFS'] = j
+
+  log('total = %d', total)
+  log('num_missing = %d', num_missing)
+
+
+if __name__ == '__main__':
+  if os.getenv('BENCHMARK'):
+    log('Benchmarking...')
+    run_benchmarks()
+  else:
+    run_tests()
@@ -75,10 +75,25 @@ def run_tests():
 
   print("%r" % "tab\tline\nline\r\n")
 
+  # Chains are fused into one str_concat_n() call
+  a = 'a'
+  print(a + '/' + obj.s + '/' + a)
+  print(a + ('b' + a) + 'c')
+  print(''.join([a, obj.s, 'z']))
+  print(', '.join([a, obj.s, 'z']))
+  print(''.join([a]))
+
 
 def run_benchmarks():
   # type: () -> None
-  pass
+  # Like building paths and error messages in a hot loop
+  n = 0
+  for i in xrange(1000000):
+    d = 'dir%d' % (i % 10)
+    path = '/home/' + d + '/' + 'src' + '/' + 'file.txt'
+    msg = ''.join(['Error: ', path, " doesn't exist"])
+    n += len(msg)
+  log('n = %d', n)
 
 
 if __name__ == '__main__':
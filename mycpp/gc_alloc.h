@@ -8,8 +8,9 @@
 #include <new>      // placement new
 #include <utility>  // std::forward
 
-#include "mycpp/gc_slab.h"  // for NewSlab()
-#include "mycpp/gc_str.h"   // for NewStr()
+#include "mycpp/alloc_log.h"  // gAllocLog
+#include "mycpp/gc_slab.h"   // for NewSlab()
+#include "mycpp/gc_str.h"    // for NewStr()
 
 #if defined(BUMP_LEAK)
   #include "mycpp/bump_leak_heap.h"
@@ -100,6 +101,16 @@ T* Alloc(Args&&... args) {
   // Hack for now: find the header
   ObjHeader* header = FindObjHeader(reinterpret_cast<RawObject*>(obj));
   header->obj_id = obj_id;
+#elif defined(CHENEY_GC)
+  // The constructor may be a base class's, so set the number of bytes to copy
+  ObjHeader* header = FindObjHeader(reinterpret_cast<RawObject*>(obj));
+  header->obj_len = sizeof(T);
+#endif
+
+#ifdef ALLOC_LOG
+  gAllocLog.Record(TypeName<T>(),
+                   FindObjHeader(reinterpret_cast<RawObject*>(obj))->type_tag,
+                   sizeof(T));
 #endif
   return obj;
 }
@@ -127,6 +138,10 @@ inline Str* NewStr(int len) {
 #if MARK_SWEEP
   s->header_.obj_id = gHeap.UnusedObjectId();
 #endif
+
+#ifdef ALLOC_LOG
+  gAllocLog.Record(TypeName<Str>(), s->header_.type_tag, obj_len);
+#endif
   return s;
 }
 
@@ -139,6 +154,12 @@ inline Str* OverAllocatedStr(int len) {
   auto s = new (place) Str();
 #if MARK_SWEEP
   s->header_.obj_id = gHeap.UnusedObjectId();
+#elif defined(CHENEY_GC)
+  s->header_.obj_len = obj_len;  // until MaybeShrink()
+#endif
+
+#ifdef ALLOC_LOG
+  gAllocLog.Record(TypeName<Str>(), s->header_.type_tag, obj_len);
 #endif
   return s;
 }
@@ -170,6 +191,12 @@ inline Slab<T>* NewSlab(int len) {
   auto slab = new (place) Slab<T>(len);  // placement new
 #if MARK_SWEEP
   slab->header_.obj_id = gHeap.UnusedObjectId();
+#elif defined(CHENEY_GC)
+  slab->header_.obj_len = obj_len;
+#endif
+
+#ifdef ALLOC_LOG
+  gAllocLog.Record(TypeName<Slab<T>>(), slab->header_.type_tag, obj_len);
 #endif
   return slab;
 }
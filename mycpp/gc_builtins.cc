@@ -3,6 +3,15 @@
 
 #include "mycpp/runtime.h"
 
+// Constant initialized, like GLOBAL_STR
+IndexError gIndexError(HeapTag::Global);
+KeyError gKeyError(HeapTag::Global);
+StopIteration gStopIteration(HeapTag::Global);
+
+IndexError* kIndexError = &gIndexError;
+KeyError* kKeyError = &gKeyError;
+StopIteration* kStopIteration = &gStopIteration;
+
 // Translation of Python's print().
 void print(Str* s) {
   fputs(s->data_, stdout);  // print until first NUL
@@ -153,28 +162,7 @@ double to_float(Str* s) {
 
 // e.g. ('a' in 'abc')
 bool str_contains(Str* haystack, Str* needle) {
-  // Common case
-  if (len(needle) == 1) {
-    return memchr(haystack->data_, needle->data_[0], len(haystack));
-  }
-
-  if (len(needle) > len(haystack)) {
-    return false;
-  }
-
-  // General case. TODO: We could use a smarter substring algorithm.
-
-  const char* end = haystack->data_ + len(haystack);
-  const char* last_possible = end - len(needle);
-  const char* p = haystack->data_;
-
-  while (p <= last_possible) {
-    if (memcmp(p, needle->data_, len(needle)) == 0) {
-      return true;
-    }
-    p++;
-  }
-  return false;
+  return haystack->find(needle) != -1;  // see SearchForward() in gc_str.cc
 }
 
 Str* str_repeat(Str* s, int times) {
@@ -218,6 +206,27 @@ Str* str_concat3(Str* a, Str* b, Str* c) {
   return result;
 }
 
+// a + b + c ... and ''.join([a, b, c]).  mycpp flattens the chain so we sum
+// the lengths once and allocate once, instead of once per +.
+Str* str_concat_n(std::initializer_list<Str*> parts) {
+  int new_len = 0;
+  for (Str* part : parts) {
+    new_len += len(part);
+  }
+
+  Str* result = NewStr(new_len);
+  char* pos = result->data_;
+
+  for (Str* part : parts) {
+    int part_len = len(part);
+    memcpy(pos, part->data_, part_len);
+    pos += part_len;
+  }
+  assert(pos == result->data_ + new_len);
+
+  return result;
+}
+
 Str* str_concat(Str* a, Str* b) {
   int a_len = len(a);
   int b_len = len(b);
@@ -236,13 +245,19 @@ Str* str_concat(Str* a, Str* b) {
 //
 
 bool str_equals(Str* left, Str* right) {
-  // Fast path for identical strings.  String deduplication during GC could
-  // make this more likely.  String interning could guarantee it, allowing us
-  // to remove memcmp().
+  // Fast path for identical strings.  Names from the lexer are interned with
+  // mylib::Intern(), so they're usually the same object.
   if (left == right) {
     return true;
   }
 
+  // Fast path for different strings whose hashes are cached, e.g. interned
+  // names, and Dict keys
+  if (left->hash_value_ >= 0 && right->hash_value_ >= 0 &&
+      left->hash_value_ != right->hash_value_) {
+    return false;
+  }
+
   // obj_len equal implies string lengths are equal
 
   if (STR_LEN(left->header_) == STR_LEN(right->header_)) {
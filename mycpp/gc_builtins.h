@@ -7,6 +7,8 @@
 #ifndef GC_BUILTINS_H
 #define GC_BUILTINS_H
 
+#include <initializer_list>
+
 #include "mycpp/common.h"
 #include "mycpp/gc_obj.h"
 
@@ -17,21 +19,42 @@ class _ExceptionOpaque {
   _ExceptionOpaque()
       : GC_CLASS_FIXED(header_, kZeroMask, sizeof(_ExceptionOpaque)) {
   }
+  // For the global instances below, with HeapTag::Global
+  constexpr explicit _ExceptionOpaque(unsigned heap_tag)
+      : GC_CLASS(header_, heap_tag, kZeroMask, sizeof(_ExceptionOpaque)) {
+  }
   GC_OBJ(header_);
 };
 
 // mycpp removes constructor arguments
 class Exception : public _ExceptionOpaque {};
 
-class IndexError : public _ExceptionOpaque {};
+class IndexError : public _ExceptionOpaque {
+ public:
+  using _ExceptionOpaque::_ExceptionOpaque;
+};
 
-class KeyError : public _ExceptionOpaque {};
+class KeyError : public _ExceptionOpaque {
+ public:
+  using _ExceptionOpaque::_ExceptionOpaque;
+};
 
 class EOFError : public _ExceptionOpaque {};
 
 class KeyboardInterrupt : public _ExceptionOpaque {};
 
-class StopIteration : public _ExceptionOpaque {};
+class StopIteration : public _ExceptionOpaque {
+ public:
+  using _ExceptionOpaque::_ExceptionOpaque;
+};
+
+// These exceptions are thrown in ordinary control flow, e.g. StopIteration
+// from ListIter::iterNext() and KeyError from Dict::index_().  They have no
+// fields, so we throw a global instance rather than allocating one each time.
+// mycpp translates 'raise StopIteration()' and friends to these too.
+extern IndexError* kIndexError;
+extern KeyError* kKeyError;
+extern StopIteration* kStopIteration;
 
 class ValueError {
  public:
@@ -145,6 +168,7 @@ bool str_equals0(const char* c_string, Str* s);
 
 Str* str_concat(Str* a, Str* b);           // a + b when a and b are strings
 Str* str_concat3(Str* a, Str* b, Str* c);  // for os_path::join()
+Str* str_concat_n(std::initializer_list<Str*> parts);  // a + b + c ...
 Str* str_repeat(Str* s, int times);        // e.g. ' ' * 3
 
 extern Str* kEmptyString;
@@ -247,6 +247,19 @@ TEST exceptions_test() {
   }
   ASSERT(caught);
 
+  // Global instances are never collected
+  ASSERT_EQ(HeapTag::Global, kStopIteration->header_.heap_tag);
+  ASSERT_EQ(HeapTag::Global, kKeyError->header_.heap_tag);
+
+  caught = false;
+  try {
+    throw kStopIteration;
+  } catch (StopIteration* e) {
+    ASSERT_EQ(kStopIteration, e);
+    caught = true;
+  }
+  ASSERT(caught);
+
   // TODO: Make this work with return value rooting
   RuntimeError* r = nullptr;
   Str* message = nullptr;
@@ -0,0 +1,219 @@
+#ifndef MYCPP_GC_DEQUE_H
+#define MYCPP_GC_DEQUE_H
+
+#include <string.h>  // memcpy
+
+#include "mycpp/common.h"       // DCHECK
+#include "mycpp/gc_alloc.h"     // Alloc
+#include "mycpp/gc_builtins.h"  // IndexError
+#include "mycpp/gc_slab.h"
+
+// collections.deque in Python.  A ring buffer over a Slab, so that append(),
+// appendleft(), pop() and popleft() are all O(1).  List<T>::pop(0) has to
+// shift every item, which is quadratic when a list is consumed from the front.
+//
+// Items are at slab_->items_[start_] up to len_ of them, wrapping around at
+// capacity_.  Unused slots are zero for the GC scan.
+
+template <typename T>
+class Deque {
+  static const int kCapacityAdjust = kSlabHeaderSize / sizeof(T);
+  static_assert(kSlabHeaderSize % sizeof(T) == 0,
+                "Slab header size should be multiple of item size");
+
+ public:
+  Deque()
+      : GC_CLASS_FIXED(header_, field_mask(), sizeof(Deque<T>)),
+        len_(0),
+        capacity_(0),
+        start_(0),
+        slab_(nullptr) {
+  }
+
+  // Implements q[i]
+  T index_(int i);
+
+  // Implements q[i] = item
+  void set(int i, T item);
+
+  void append(T item);
+  void appendleft(T item);
+
+  T pop();
+  T popleft();
+
+  void clear();
+
+  // Ensure that there's space for a number of items
+  void reserve(int n);
+
+  GC_OBJ(header_);
+
+  int len_;       // number of entries
+  int capacity_;  // max entries before resizing
+  int start_;     // position of the first entry in the slab
+
+  Slab<T>* slab_;
+
+  static constexpr uint16_t field_mask() {
+    return maskbit(offsetof(Deque, slab_));
+  }
+
+  DISALLOW_COPY_AND_ASSIGN(Deque)
+
+ private:
+  // Position in the slab of the i'th entry, 0 <= i < capacity_
+  int Pos(int i) {
+    int pos = start_ + i;
+    return pos >= capacity_ ? pos - capacity_ : pos;
+  }
+};
+
+template <typename T>
+Deque<T>* NewDeque() {
+  return Alloc<Deque<T>>();
+}
+
+// deque(L)
+template <typename T>
+Deque<T>* NewDeque(List<T>* other) {
+  auto self = Alloc<Deque<T>>();
+
+  int n = len(other);
+  self->reserve(n);
+  for (int i = 0; i < n; ++i) {
+    self->slab_->items_[i] = other->index_(i);
+  }
+  self->len_ = n;
+  return self;
+}
+
+template <typename T>
+int len(const Deque<T>* q) {
+  return q->len_;
+}
+
+template <typename T>
+void Deque<T>::reserve(int n) {
+  if (capacity_ >= n) {
+    return;
+  }
+
+  int new_capacity = RoundUp(n + kCapacityAdjust) - kCapacityAdjust;
+  auto new_slab = NewSlab<T>(new_capacity);
+
+  // Unwrap the items into the new slab, so start_ is 0 again
+  if (len_ > 0) {
+    int first = capacity_ - start_;  // items before the wraparound
+    if (first >= len_) {
+      memcpy(new_slab->items_, slab_->items_ + start_, len_ * sizeof(T));
+    } else {
+      memcpy(new_slab->items_, slab_->items_ + start_, first * sizeof(T));
+      memcpy(new_slab->items_ + first, slab_->items_,
+             (len_ - first) * sizeof(T));
+    }
+  }
+  capacity_ = new_capacity;
+  start_ = 0;
+  slab_ = new_slab;
+}
+
+template <typename T>
+T Deque<T>::index_(int i) {
+  if (i < 0) {
+    i = len_ + i;
+  }
+  if (i < 0 || i >= len_) {
+    throw kIndexError;
+  }
+  return slab_->items_[Pos(i)];
+}
+
+template <typename T>
+void Deque<T>::set(int i, T item) {
+  if (i < 0) {
+    i = len_ + i;
+  }
+  if (i < 0 || i >= len_) {
+    throw kIndexError;
+  }
+  slab_->items_[Pos(i)] = item;
+}
+
+template <typename T>
+void Deque<T>::append(T item) {
+  reserve(len_ + 1);
+  slab_->items_[Pos(len_)] = item;
+  ++len_;
+}
+
+template <typename T>
+void Deque<T>::appendleft(T item) {
+  reserve(len_ + 1);
+  start_ = start_ == 0 ? capacity_ - 1 : start_ - 1;
+  slab_->items_[start_] = item;
+  ++len_;
+}
+
+template <typename T>
+T Deque<T>::pop() {
+  if (len_ == 0) {
+    throw kIndexError;
+  }
+  len_--;
+  int pos = Pos(len_);
+  T result = slab_->items_[pos];
+  slab_->items_[pos] = 0;  // zero for GC scan
+  return result;
+}
+
+template <typename T>
+T Deque<T>::popleft() {
+  if (len_ == 0) {
+    throw kIndexError;
+  }
+  T result = slab_->items_[start_];
+  slab_->items_[start_] = 0;  // zero for GC scan
+  len_--;
+  start_ = len_ == 0 ? 0 : Pos(1);
+  return result;
+}
+
+template <typename T>
+void Deque<T>::clear() {
+  if (slab_) {
+    memset(slab_->items_, 0, capacity_ * sizeof(T));  // zero for GC scan
+  }
+  len_ = 0;
+  start_ = 0;
+}
+
+template <class T>
+class DequeIter {
+ public:
+  explicit DequeIter(Deque<T>* q) : q_(q), i_(0) {
+#ifdef CHENEY_GC
+    gHeap.PushRoot(reinterpret_cast<RawObject**>(&q_));
+#endif
+  }
+#ifdef CHENEY_GC
+  ~DequeIter() {
+    gHeap.PopRoot();
+  }
+#endif
+  void Next() {
+    i_++;
+  }
+  bool Done() {
+    return i_ >= q_->len_;
+  }
+  T Value() {
+    return q_->index_(i_);
+  }
+
+ private:
+  Deque<T>* q_;
+  int i_;
+};
+
+#endif  // MYCPP_GC_DEQUE_H
@@ -0,0 +1,105 @@
+#include "mycpp/runtime.h"
+#include "vendor/greatest.h"
+
+TEST deque_test() {
+  Deque<int>* q = nullptr;
+  StackRoots _roots({&q});
+
+  q = NewDeque<int>();
+  ASSERT_EQ(0, len(q));
+
+  q->append(1);
+  q->append(2);
+  q->appendleft(0);
+  ASSERT_EQ(3, len(q));
+  ASSERT_EQ(0, q->index_(0));
+  ASSERT_EQ(2, q->index_(-1));
+
+  ASSERT_EQ(0, q->popleft());
+  ASSERT_EQ(2, q->pop());
+  ASSERT_EQ(1, q->popleft());
+  ASSERT_EQ(0, len(q));
+
+  bool caught = false;
+  try {
+    q->popleft();
+  } catch (IndexError* e) {
+    caught = true;
+  }
+  ASSERT(caught);
+
+  PASS();
+}
+
+TEST deque_wraparound_test() {
+  Deque<Str*>* q = nullptr;
+  Str* s = nullptr;
+  StackRoots _roots({&q, &s});
+
+  q = NewDeque<Str*>();
+
+  // Use it as a FIFO, so the items wrap around the slab many times
+  int expected = 0;
+  for (int i = 0; i < 1000; ++i) {
+    s = str(i);
+    q->append(s);
+    if (len(q) > 5) {
+      s = q->popleft();
+      ASSERT(str_equals(str(expected), s));
+      expected++;
+    }
+    gHeap.Collect();
+  }
+  ASSERT_EQ(5, len(q));
+  // Still in the first slab
+  ASSERT(q->capacity_ < 16);
+
+  // Grow while wrapped
+  for (int i = 0; i < 100; ++i) {
+    q->appendleft(StrFromC("x"));
+  }
+  ASSERT_EQ(105, len(q));
+  ASSERT(str_equals0("x", q->index_(0)));
+  ASSERT(str_equals0("995", q->index_(100)));
+  ASSERT(str_equals0("999", q->index_(-1)));
+
+  int n = 0;
+  for (DequeIter<Str*> it(q); !it.Done(); it.Next()) {
+    n++;
+  }
+  ASSERT_EQ(105, n);
+
+  q->clear();
+  ASSERT_EQ(0, len(q));
+  q->append(StrFromC("y"));
+  ASSERT(str_equals0("y", q->index_(0)));
+
+  PASS();
+}
+
+TEST deque_from_list_test() {
+  auto L = NewList<int>({5, 6, 7});
+  auto q = NewDeque<int>(L);
+  ASSERT_EQ(3, len(q));
+  ASSERT_EQ(5, q->popleft());
+  ASSERT_EQ(7, q->pop());
+
+  PASS();
+}
+
+GREATEST_MAIN_DEFS();
+
+int main(int argc, char** argv) {
+  gHeap.Init();
+
+  GREATEST_MAIN_BEGIN();
+
+  RUN_TEST(deque_test);
+  RUN_TEST(deque_wraparound_test);
+  RUN_TEST(deque_from_list_test);
+
+  gHeap.CleanProcessExit();
+
+  GREATEST_MAIN_END();
+  return 0;
+}
@@ -15,6 +15,16 @@ const int kDeletedEntry = -1;
 // entry_.
 const int kEmptyEntry = -2;
 
+// Dict<Str*, V> also has a hash index, table_.  It's open addressing with
+// linear probing, and each slot stores the key's cached hash and its first 8
+// bytes, so most probes that don't match are rejected without dereferencing
+// the key.  Other key types still use the linear search.
+struct StrDictSlot {
+  uint64_t prefix;  // first 8 bytes of the key, zero padded
+  int hash;         // str_hash() of the key
+  int pos;          // index into keys_ and values_, or kEmptyEntry
+};
+
 // Helper for keys() and values()
 template <typename T>
 List<T>* ListFromDictSlab(Slab<int>* index, Slab<T>* slab, int n) {
@@ -44,7 +54,8 @@ class Dict {
         capacity_(0),
         entry_(nullptr),
         keys_(nullptr),
-        values_(nullptr) {
+        values_(nullptr),
+        table_(nullptr) {
   }
 
   Dict(std::initializer_list<K> keys, std::initializer_list<V> values)
@@ -53,7 +64,8 @@ class Dict {
         capacity_(0),
         entry_(nullptr),
         keys_(nullptr),
-        values_(nullptr) {
+        values_(nullptr),
+        table_(nullptr) {
   }
 
   // This relies on the fact that containers of 4-byte ints are reduced by 2
@@ -88,14 +100,21 @@ class Dict {
 
   void clear();
 
+  // Moves the live entries to the front, dropping deleted ones, and rebuilds
+  // the index.  set() calls this instead of growing when most of the slabs
+  // are tombstones left by dict_erase().
+  void compact();
+
+  // The position after the last used or deleted entry.  Empty entries all
+  // come after it.
+  int end_of_entries();
+
   // Returns the position in the array.  Used by dict_contains(), index(),
   // get(), and set().
   //
-  // For now this does a linear search.
+  // Str* keys are looked up in table_.  Other keys use a linear search.
   // TODO:
-  // - hash functions, and linear probing.
-  // - resizing based on load factor
-  //   - which requires rehashing (re-insert all items)
+  // - hash other key types
   // - Special case to intern Str* when it's hashed?  How?
   //   - Should we have wrappers like:
   //   - V GetAndIntern<V>(D, &string_key)
@@ -114,15 +133,38 @@ class Dict {
   Slab<K>* keys_;     // Dict<int, V>
   Slab<V>* values_;   // Dict<K, int>
 
-  // A dict has 3 pointers the GC needs to follow.
+  // Hash index for Dict<Str*, V>, with (capacity_ + kCapacityAdjust) * 2
+  // slots.  nullptr for other key types.
+  Slab<StrDictSlot>* table_;
+
+  // A dict has 4 pointers the GC needs to follow.
   static constexpr uint16_t field_mask() {
     return maskbit(offsetof(Dict, entry_)) | maskbit(offsetof(Dict, keys_)) |
-           maskbit(offsetof(Dict, values_));
+           maskbit(offsetof(Dict, values_)) | maskbit(offsetof(Dict, table_));
   }
 
   DISALLOW_COPY_AND_ASSIGN(Dict)
 };
 
+// Overloads that give Dict<Str*, V> its hash index.  The generic versions do
+// a linear search and keep no index.
+template <typename K, typename V>
+int dict_find(Dict<K, V>* d, K key);
+template <typename V>
+int dict_find(Dict<Str*, V>* d, Str* key);
+
+template <typename K, typename V>
+inline void dict_index_insert(Dict<K, V>* d, K key, int pos) {
+}
+template <typename V>
+void dict_index_insert(Dict<Str*, V>* d, Str* key, int pos);
+
+template <typename K, typename V>
+inline void dict_index_rebuild(Dict<K, V>* d) {
+}
+template <typename V>
+void dict_index_rebuild(Dict<Str*, V>* d);
+
 template <typename K, typename V>
 inline bool dict_contains(Dict<K, V>* haystack, K needle) {
   return haystack->position_of_key(needle) != -1;
@@ -156,6 +198,7 @@ void Dict<K, V>::reserve(int n) {
   // log("--- reserve %d", capacity_);
   //
   if (capacity_ < n) {  // TODO: use load factor, not exact fit
+    int old_capacity = capacity_;
     // calculate the number of keys and values we should have
     capacity_ = RoundUp(n + kCapacityAdjust) - kCapacityAdjust;
 
@@ -174,16 +217,19 @@ void Dict<K, V>::reserve(int n) {
     new_v = NewSlab<V>(capacity_);
 
     if (keys_ != nullptr) {
-      // Right now the index is the same size as keys and values.
-      memcpy(new_i->items_, entry_->items_, len_ * sizeof(int));
+      // Right now the index is the same size as keys and values.  Copy all
+      // old positions, since deleted entries leave holes before len_.
+      memcpy(new_i->items_, entry_->items_, old_capacity * sizeof(int));
 
-      memcpy(new_k->items_, keys_->items_, len_ * sizeof(K));
-      memcpy(new_v->items_, values_->items_, len_ * sizeof(V));
+      memcpy(new_k->items_, keys_->items_, old_capacity * sizeof(K));
+      memcpy(new_v->items_, values_->items_, old_capacity * sizeof(V));
     }
 
     entry_ = new_i;
     keys_ = new_k;
     values_ = new_v;
+
+    dict_index_rebuild(this);
   }
 }
 
@@ -192,7 +238,7 @@ template <typename K, typename V>
 V Dict<K, V>::index_(K key) {
   int pos = position_of_key(key);
   if (pos == -1) {
-    throw Alloc<KeyError>();
+    throw kKeyError;
   } else {
     return values_->items_[pos];
   }
@@ -240,50 +286,175 @@ void Dict<K, V>::clear() {
     entry_->items_[i] = kEmptyEntry;
   }
 
-  memset(keys_->items_, 0, len_ * sizeof(K));    // zero for GC scan
-  memset(values_->items_, 0, len_ * sizeof(V));  // zero for GC scan
+  memset(keys_->items_, 0, capacity_ * sizeof(K));    // zero for GC scan
+  memset(values_->items_, 0, capacity_ * sizeof(V));  // zero for GC scan
   len_ = 0;
+
+  dict_index_rebuild(this);
+}
+
+template <typename K, typename V>
+void Dict<K, V>::compact() {
+  int end = end_of_entries();
+  int n = 0;
+  for (int pos = 0; pos < end; ++pos) {
+    if (entry_->items_[pos] == kDeletedEntry) {
+      continue;
+    }
+    keys_->items_[n] = keys_->items_[pos];
+    values_->items_[n] = values_->items_[pos];
+    entry_->items_[n] = 0;
+    ++n;
+  }
+  DCHECK(n == len_);
+  for (int pos = n; pos < end; ++pos) {
+    entry_->items_[pos] = kEmptyEntry;
+    keys_->items_[pos] = 0;    // zero for GC scan
+    values_->items_[pos] = 0;  // zero for GC scan
+  }
+
+  dict_index_rebuild(this);
+}
+
+template <typename K, typename V>
+int Dict<K, V>::end_of_entries() {
+  // Binary search, since there are at least len_ entries before it
+  int lo = len_;
+  int hi = capacity_;
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (entry_->items_[mid] == kEmptyEntry) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+  return lo;
+}
+
+template <typename K, typename V>
+int Dict<K, V>::position_of_key(K key) {
+  return dict_find(this, key);
 }
 
-// Returns the position in the array.  Used by dict_contains(), index(),
-// get(), and set().
-//
-// For now this does a linear search.
+// Linear search, for keys other than Str*.
 // TODO:
 // - hash functions, and linear probing.
 // - resizing based on load factor
 //   - which requires rehashing (re-insert all items)
-// - Special case to intern Str* when it's hashed?  How?
-//   - Should we have wrappers like:
-//   - V GetAndIntern<V>(D, &string_key)
-//   - SetAndIntern<V>(D, &string_key, value)
-//   This will enable duplicate copies of the string to be garbage collected
 template <typename K, typename V>
-int Dict<K, V>::position_of_key(K key) {
-  for (int i = 0; i < capacity_; ++i) {
-    int special = entry_->items_[i];  // NOT an index now
+int dict_find(Dict<K, V>* d, K key) {
+  for (int i = 0; i < d->capacity_; ++i) {
+    int special = d->entry_->items_[i];  // NOT an index now
     if (special == kDeletedEntry) {
       continue;  // keep searching
     }
     if (special == kEmptyEntry) {
       return -1;  // not found
     }
-    if (keys_equal(keys_->items_[i], key)) {
+    if (keys_equal(d->keys_->items_[i], key)) {
       return i;
     }
   }
   return -1;  // table is completely full?  Does this happen?
 }
 
+// The first 8 bytes of a Str, zero padded.  Strings that differ only in NUL
+// padding have the same prefix, so a match still has to compare the keys.
+inline uint64_t str_prefix(Str* s) {
+  uint64_t prefix = 0;
+  int n = len(s);
+  memcpy(&prefix, s->data_, n < 8 ? n : 8);
+  return prefix;
+}
+
+template <typename V>
+int dict_find(Dict<Str*, V>* d, Str* key) {
+  if (d->table_ == nullptr) {
+    return -1;
+  }
+  int hash = str_hash(key);
+  uint64_t prefix = str_prefix(key);
+
+  int mask = (d->capacity_ + Dict<Str*, V>::kCapacityAdjust) * 2 - 1;
+  for (int i = hash & mask;; i = (i + 1) & mask) {
+    StrDictSlot* slot = d->table_->items_ + i;
+    if (slot->pos == kEmptyEntry) {
+      return -1;
+    }
+    if (slot->hash != hash || slot->prefix != prefix) {
+      continue;  // most misses end here, without touching the key
+    }
+    int pos = slot->pos;
+    if (d->entry_->items_[pos] == kDeletedEntry) {
+      continue;  // removed by dict_erase()
+    }
+    Str* candidate = d->keys_->items_[pos];
+    // Fast path for GLOBAL_STR and other shared key objects
+    if (candidate == key || keys_equal(candidate, key)) {
+      return pos;
+    }
+  }
+}
+
+template <typename V>
+void dict_index_insert(Dict<Str*, V>* d, Str* key, int pos) {
+  int hash = str_hash(key);
+  int mask = (d->capacity_ + Dict<Str*, V>::kCapacityAdjust) * 2 - 1;
+  int i = hash & mask;
+  while (d->table_->items_[i].pos != kEmptyEntry) {
+    i = (i + 1) & mask;
+  }
+  StrDictSlot* slot = d->table_->items_ + i;
+  slot->prefix = str_prefix(key);
+  slot->hash = hash;
+  slot->pos = pos;
+}
+
+// Called when the slabs are reallocated, and on clear().  Deleted entries
+// are dropped from the index.
+template <typename V>
+void dict_index_rebuild(Dict<Str*, V>* d) {
+  if (d->capacity_ == 0) {
+    return;
+  }
+  int table_len = (d->capacity_ + Dict<Str*, V>::kCapacityAdjust) * 2;
+  d->table_ = NewSlab<StrDictSlot>(table_len);
+  for (int i = 0; i < table_len; ++i) {
+    d->table_->items_[i].pos = kEmptyEntry;
+  }
+  for (int pos = 0; pos < d->capacity_; ++pos) {
+    int special = d->entry_->items_[pos];
+    if (special == kDeletedEntry) {
+      continue;
+    }
+    if (special == kEmptyEntry) {
+      break;
+    }
+    dict_index_insert(d, d->keys_->items_[pos], pos);
+  }
+}
+
 template <typename K, typename V>
 void Dict<K, V>::set(K key, V val) {
   int pos = position_of_key(key);
   if (pos == -1) {  // new pair
-    reserve(len_ + 1);
-    keys_->items_[len_] = key;
-    values_->items_[len_] = val;
+    // New entries go after every used position.  That's len_ unless
+    // dict_erase() left holes.
+    int end = end_of_entries();
+    // If the slabs are full and mostly holes, reuse them rather than growing.
+    // Otherwise set() and dict_erase() in a loop grow the dict without
+    // bound.
+    if (end == capacity_ && capacity_ - len_ > len_) {
+      compact();
+      end = len_;
+    }
+    reserve(end + 1);
+    keys_->items_[end] = key;
+    values_->items_[end] = val;
 
-    entry_->items_[len_] = 0;  // new special value
+    entry_->items_[end] = 0;  // new special value
+    dict_index_insert(this, key, end);
 
     ++len_;
   } else {
@@ -307,7 +478,15 @@ template <class K, class V>
 class DictIter {
  public:
   explicit DictIter(Dict<K, V>* D) : D_(D), pos_(ValidPosAfter(0)) {
+#ifdef CHENEY_GC
+    gHeap.PushRoot(reinterpret_cast<RawObject**>(&D_));
+#endif
+  }
+#ifdef CHENEY_GC
+  ~DictIter() {
+    gHeap.PopRoot();
   }
+#endif
   void Next() {
     pos_ = ValidPosAfter(pos_ + 1);
   }
@@ -145,8 +145,8 @@ TEST test_dict_internals() {
 #ifndef MARK_SWEEP
   int diff1 = reinterpret_cast<char*>(dict1) - gHeap.from_space_.begin_;
   int diff2 = reinterpret_cast<char*>(dict2) - gHeap.from_space_.begin_;
-  ASSERT(diff1 < 1024);
-  ASSERT(diff2 < 1024);
+  ASSERT(0 <= diff1 && diff1 < gHeap.from_space_.size_);
+  ASSERT(0 <= diff2 && diff2 < gHeap.from_space_.size_);
 #endif
 
   dict1->set(42, 5);
@@ -453,6 +453,139 @@ TEST test_tuple_key() {
   PASS();
 }
 
+GLOBAL_STR(kStrLongName1, "long_name_1");
+GLOBAL_STR(kStrLongName2, "long_name_2");
+
+TEST str_key_index_test() {
+  auto d = NewDict<Str*, int>();
+  StackRoots _roots({&d});
+
+  // Missing key in a dict without a table
+  ASSERT(!dict_contains(d, kStrFoo));
+
+  // Resizing rebuilds the index
+  for (int i = 0; i < 1000; ++i) {
+    d->set(StrFormat("var%d", i), i);
+  }
+  ASSERT_EQ_FMT(1000, len(d), "%d");
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ_FMT(i, d->index_(StrFormat("var%d", i)), "%d");
+  }
+  ASSERT(!dict_contains(d, StrFromC("var1000")));
+
+  // Keys with the same 8 byte prefix
+  d->set(kStrLongName1, 1);
+  d->set(kStrLongName2, 2);
+  ASSERT_EQ(1, d->index_(kStrLongName1));
+  ASSERT_EQ(2, d->index_(StrFromC("long_name_2")));
+  ASSERT(!dict_contains(d, StrFromC("long_name_3")));
+
+  // The prefix is zero padded, so these differ only in length
+  d->set(StrFromC("a\0", 2), 10);
+  d->set(StrFromC("a"), 11);
+  ASSERT_EQ(10, d->index_(StrFromC("a\0", 2)));
+  ASSERT_EQ(11, d->index_(StrFromC("a")));
+
+  // Empty string
+  d->set(kEmptyString, 12);
+  ASSERT_EQ(12, d->index_(StrFromC("")));
+
+  PASS();
+}
+
+TEST str_key_erase_test() {
+  auto d = NewDict<Str*, int>();
+  StackRoots _roots({&d});
+
+  d->set(StrFromC("a"), 1);
+  d->set(StrFromC("b"), 2);
+  d->set(StrFromC("c"), 3);
+
+  // Setting a new key after an erase must not overwrite "c"
+  mylib::dict_erase(d, StrFromC("a"));
+  d->set(StrFromC("d"), 4);
+  ASSERT_EQ_FMT(3, len(d), "%d");
+  ASSERT(!dict_contains(d, StrFromC("a")));
+  ASSERT_EQ(2, d->index_(StrFromC("b")));
+  ASSERT_EQ(3, d->index_(StrFromC("c")));
+  ASSERT_EQ(4, d->index_(StrFromC("d")));
+
+  // Re-insert an erased key, then grow past the holes
+  d->set(StrFromC("a"), 5);
+  ASSERT_EQ(5, d->index_(StrFromC("a")));
+  for (int i = 0; i < 100; ++i) {
+    mylib::dict_erase(d, StrFromC("d"));
+    d->set(StrFromC("d"), i);
+  }
+  ASSERT_EQ_FMT(4, len(d), "%d");
+  ASSERT_EQ(99, d->index_(StrFromC("d")));
+  ASSERT_EQ(3, d->index_(StrFromC("c")));
+
+  List<Str*>* keys = d->keys();
+  ASSERT_EQ_FMT(4, len(keys), "%d");
+
+  d->clear();
+  ASSERT(!dict_contains(d, StrFromC("b")));
+  d->set(StrFromC("b"), 6);
+  ASSERT_EQ(6, d->index_(StrFromC("b")));
+
+  PASS();
+}
+
+TEST int_key_erase_test() {
+  auto d = NewDict<int, int>();
+  StackRoots _roots({&d});
+
+  for (int i = 0; i < 3; ++i) {
+    d->set(i, i * 10);
+  }
+  mylib::dict_erase(d, 0);
+  d->set(3, 30);
+  ASSERT_EQ_FMT(3, len(d), "%d");
+  ASSERT_EQ(20, d->index_(2));
+  ASSERT_EQ(30, d->index_(3));
+
+  PASS();
+}
+
+TEST erase_churn_test() {
+  auto d = NewDict<Str*, int>();
+  auto d2 = NewDict<int, int>();
+  Str* key = nullptr;
+  StackRoots _roots({&d, &d2, &key});
+
+  d->set(StrFromC("first"), 1);
+  d->set(StrFromC("second"), 2);
+
+  // Like unset and reassign of shell variables.  Deleted slots have to be
+  // reused, or the dict grows on every set().
+  for (int i = 0; i < 50000; ++i) {
+    key = str_concat(StrFromC("k"), str(i));
+    d->set(key, i);
+    mylib::dict_erase(d, key);
+
+    d2->set(i, i);
+    mylib::dict_erase(d2, i);
+  }
+  ASSERT_EQ_FMT(2, len(d), "%d");
+  ASSERT_EQ_FMT(0, len(d2), "%d");
+  log("capacity after churn: %d %d", d->capacity_, d2->capacity_);
+  ASSERT(d->capacity_ < 16);
+  ASSERT(d2->capacity_ < 16);
+
+  // Compaction keeps insertion order
+  d->set(StrFromC("third"), 3);
+  List<Str*>* keys = d->keys();
+  ASSERT_EQ_FMT(3, len(keys), "%d");
+  ASSERT(str_equals0("first", keys->index_(0)));
+  ASSERT(str_equals0("second", keys->index_(1)));
+  ASSERT(str_equals0("third", keys->index_(2)));
+  ASSERT_EQ(1, d->index_(StrFromC("first")));
+  ASSERT_EQ(3, d->index_(StrFromC("third")));
+
+  PASS();
+}
+
 GREATEST_MAIN_DEFS();
 
 int main(int argc, char** argv) {
@@ -471,6 +604,11 @@ int main(int argc, char** argv) {
   RUN_TEST(dict_methods_test);
   RUN_TEST(dict_iters_test);
 
+  RUN_TEST(str_key_index_test);
+  RUN_TEST(str_key_erase_test);
+  RUN_TEST(int_key_erase_test);
+  RUN_TEST(erase_churn_test);
+
   gHeap.CleanProcessExit();
 
   GREATEST_MAIN_END();
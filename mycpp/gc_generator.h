@@ -0,0 +1,75 @@
+#ifndef MYCPP_GC_GENERATOR_H
+#define MYCPP_GC_GENERATOR_H
+
+// Python generators are translated to a subclass of Generator<T>.  mycpp turns
+// the locals of the function into members, and the body into a Next() method
+// that resumes after the last yield.
+//
+// The subclass puts pointer members first, so it can use HeapTag::Scanned.
+// That means Generator<T> can't have any members besides the header.
+
+template <class T>
+class Generator {
+ public:
+  explicit Generator(unsigned num_pointers)
+      : GC_CLASS_SCANNED(header_, num_pointers, kNoObjLen) {
+  }
+
+  // Run until the next yield.  Returns false when the generator is exhausted.
+  virtual bool Next() = 0;
+
+  // The value of the last yield.
+  virtual T Value() = 0;
+
+  // it.next() in Python
+  T iterNext() {
+    if (!Next()) {
+      throw kStopIteration;
+    }
+    return Value();
+  }
+
+  GC_OBJ(header_);
+};
+
+// For loops over generators.  Unlike ListIter, this roots what it iterates
+// over, since a generator is usually referenced by nothing else.
+template <class T>
+class GenIter {
+ public:
+  explicit GenIter(Generator<T>* g) : g_(g) {
+    gHeap.PushRoot(reinterpret_cast<RawObject**>(&g_));
+    done_ = !g_->Next();
+  }
+  ~GenIter() {
+    gHeap.PopRoot();
+  }
+  void Next() {
+    done_ = !g_->Next();
+  }
+  bool Done() {
+    return done_;
+  }
+  T Value() {
+    return g_->Value();
+  }
+
+ private:
+  Generator<T>* g_;
+  bool done_;
+};
+
+// list(it) runs the generator to completion
+template <typename T>
+List<T>* list(Generator<T>* it) {
+  List<T>* result = nullptr;
+  StackRoots _roots({&it, &result});
+
+  result = NewList<T>();
+  while (it->Next()) {
+    result->append(it->Value());
+  }
+  return result;
+}
+
+#endif  // MYCPP_GC_GENERATOR_H
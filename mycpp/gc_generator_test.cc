@@ -0,0 +1,112 @@
+#include "mycpp/runtime.h"
+#include "vendor/greatest.h"
+
+// What mycpp generates for
+//
+//   def Count(n):
+//     for i in xrange(n):
+//       yield i
+class Count_gen : public Generator<int> {
+ public:
+  explicit Count_gen(int n) : Generator<int>(0), n(n), i(0), value_(0) {
+    state_ = 0;
+  }
+  bool Next() override {
+    switch (state_) {
+    case 0:
+      break;
+    case 1:
+      goto _resume1;
+    default:
+      return false;
+    }
+    for (i = 0; i < n; ++i) {
+      value_ = i;
+      state_ = 1;
+      return true;
+    _resume1:
+      state_ = -1;
+    }
+    state_ = -1;
+    return false;
+  }
+  int Value() override {
+    return value_;
+  }
+
+  int n;
+  int i;
+  int value_;
+  int state_;
+};
+
+TEST generator_test() {
+  Generator<int>* g = nullptr;
+  StackRoots _roots({&g});
+
+  g = Alloc<Count_gen>(3);
+  ASSERT_EQ_FMT(0, g->iterNext(), "%d");
+  ASSERT_EQ_FMT(1, g->iterNext(), "%d");
+  ASSERT_EQ_FMT(2, g->iterNext(), "%d");
+
+  bool caught = false;
+  try {
+    g->iterNext();
+  } catch (StopIteration* e) {
+    caught = true;
+  }
+  ASSERT(caught);
+
+  // Exhausted generators stay exhausted
+  ASSERT(!g->Next());
+
+  PASS();
+}
+
+TEST gen_iter_test() {
+  int sum = 0;
+  int n = 0;
+  for (GenIter<int> it(static_cast<Generator<int>*>(Alloc<Count_gen>(5))); !it.Done(); it.Next()) {
+    sum += it.Value();
+    n++;
+    // The generator is rooted by the iterator
+    gHeap.Collect();
+  }
+  ASSERT_EQ_FMT(5, n, "%d");
+  ASSERT_EQ_FMT(10, sum, "%d");
+
+  // Empty
+  n = 0;
+  for (GenIter<int> it(static_cast<Generator<int>*>(Alloc<Count_gen>(0))); !it.Done(); it.Next()) {
+    n++;
+  }
+  ASSERT_EQ_FMT(0, n, "%d");
+
+  PASS();
+}
+
+TEST list_test() {
+  Generator<int>* g = Alloc<Count_gen>(4);
+  List<int>* L = list(g);
+  ASSERT_EQ_FMT(4, len(L), "%d");
+  ASSERT_EQ_FMT(3, L->index_(3), "%d");
+
+  PASS();
+}
+
+GREATEST_MAIN_DEFS();
+
+int main(int argc, char** argv) {
+  gHeap.Init();
+
+  GREATEST_MAIN_BEGIN();
+
+  RUN_TEST(generator_test);
+  RUN_TEST(gen_iter_test);
+  RUN_TEST(list_test);
+
+  gHeap.CleanProcessExit();
+
+  GREATEST_MAIN_END();
+  return 0;
+}
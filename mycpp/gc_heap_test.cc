@@ -92,9 +92,9 @@ TEST offsets_test() {
   unsigned list_mask = List<int>::field_mask();
   ASSERT_EQ_FMT(0x0002, list_mask, "0x%x");
 
-  // in binary: 0b 0000 0000 0000 01110
+  // in binary: 0b 0000 0000 0001 1110
   unsigned dict_mask = Dict<int COMMA int>::field_mask();
-  ASSERT_EQ_FMT(0x000E, dict_mask, "0x%x");
+  ASSERT_EQ_FMT(0x001E, dict_mask, "0x%x");
 
   PASS();
 }
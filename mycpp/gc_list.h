@@ -408,13 +408,22 @@ template <class T>
 class ListIter {
  public:
   explicit ListIter(List<T>* L) : L_(L), i_(0) {
-    // Cheney only: L_ could be moved during iteration.
-    // gHeap.PushRoot(reinterpret_cast<RawObject**>(&L_));
+#ifdef CHENEY_GC
+    // L_ could be moved during iteration.
+    gHeap.PushRoot(reinterpret_cast<RawObject**>(&L_));
+#endif
+  }
+
+#ifdef CHENEY_GC
+  // list(ListIter<T> it) takes a copy, which roots its own L_
+  ListIter(const ListIter& other) : L_(other.L_), i_(other.i_) {
+    gHeap.PushRoot(reinterpret_cast<RawObject**>(&L_));
   }
 
   ~ListIter() {
-    // gHeap.PopRoot();
+    gHeap.PopRoot();
   }
+#endif
   void Next() {
     i_++;
   }
@@ -427,7 +436,7 @@ class ListIter {
   }
   T iterNext() {
     if (Done()) {
-      throw Alloc<StopIteration>();
+      throw kStopIteration;
     }
     T ret = L_->slab_->items_[i_];
     Next();
@@ -453,7 +462,15 @@ template <class T>
 class ReverseListIter {
  public:
   explicit ReverseListIter(List<T>* L) : L_(L), i_(L_->len_ - 1) {
+#ifdef CHENEY_GC
+    gHeap.PushRoot(reinterpret_cast<RawObject**>(&L_));
+#endif
+  }
+#ifdef CHENEY_GC
+  ~ReverseListIter() {
+    gHeap.PopRoot();
   }
+#endif
   void Next() {
     i_--;
   }
@@ -1,8 +1,13 @@
 #include "mycpp/gc_mylib.h"
 
 #include <errno.h>
+#include <stdint.h>  // uint64_t
 #include <stdio.h>
+#include <string.h>  // memcpy()
 #include <unistd.h>  // isatty
+#ifdef __SSE2__
+  #include <emmintrin.h>  // CountChars()
+#endif
 
 namespace mylib {
 
@@ -10,8 +15,9 @@ void InitCppOnly() {
   // We don't seem need this now that we have ctx_FlushStdout().
   // setvbuf(stdout, 0, _IONBF, 0);
 
-  // Arbitrary threshold of 50K objects based on eyeballing
-  // benchmarks/osh-runtime 10K or 100K aren't too bad either.
+  // Arbitrary minimum of 50K objects based on eyeballing
+  // benchmarks/osh-runtime 10K or 100K aren't too bad either.  The pacer
+  // raises the trigger as the heap grows.
   gHeap.Init(50000);
 }
 
@@ -34,6 +40,189 @@ void writeln(Str* s, int fd) {
 }
 #endif
 
+// Rooted on first use
+Dict<Str*, Str*>* gInterned = nullptr;
+
+Str* Intern(Str* s) {
+  StackRoots _roots({&s});
+
+  if (gInterned == nullptr) {
+    gInterned = NewDict<Str*, Str*>();
+    gHeap.RootGlobalVar(reinterpret_cast<RawObject**>(&gInterned));
+  }
+  Str* existing = gInterned->get(s, nullptr);
+  if (existing != nullptr) {
+    return existing;
+  }
+  // Interned strings are never freed, so e.g. names made up by 'eval' in a
+  // loop can't grow the table without bound.
+  if (len(gInterned) >= kMaxInterned) {
+    return s;
+  }
+  gInterned->set(s, s);
+  return s;
+}
+
+//
+// UTF-8 character counts and offsets
+//
+
+// Returns the length of the UTF-8 char that starts with byte b, or 0 if b
+// can't start one.  Same rules as _Utf8CharLen() in osh/string_ops.py.
+static inline int Utf8CharLen(unsigned char b) {
+  if (b < 0x80) {
+    return 1;
+  }
+  if ((b >> 5) == 0x6) {
+    return 2;
+  }
+  if ((b >> 4) == 0xE) {
+    return 3;
+  }
+  if ((b >> 3) == 0x1E) {
+    return 4;
+  }
+  return 0;
+}
+
+// Returns the number of chars in p[0, n), or -1 if it isn't valid UTF-8.
+static int CountChars(const unsigned char* p, int n) {
+  int count = 0;
+  int i = 0;
+  while (i < n) {
+    // Skip runs of ASCII, where each byte is a char
+    int run_start = i;
+#ifdef __SSE2__
+    while (i + 16 <= n) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+      if (_mm_movemask_epi8(v) != 0) {
+        break;
+      }
+      i += 16;
+    }
+#endif
+    while (i + 8 <= n) {
+      uint64_t word;
+      memcpy(&word, p + i, sizeof(word));
+      if (word & 0x8080808080808080ULL) {
+        break;
+      }
+      i += 8;
+    }
+    count += i - run_start;
+    if (i == n) {
+      break;
+    }
+
+    int char_len = Utf8CharLen(p[i]);
+    if (char_len == 0 || i + char_len > n) {
+      return -1;
+    }
+    for (int j = 1; j < char_len; ++j) {
+      if ((p[i + j] & 0xC0) != 0x80) {
+        return -1;  // not a continuation byte
+      }
+    }
+    i += char_len;
+    count++;
+  }
+  return count;
+}
+
+// Returns the position after num_chars chars, starting at 'pos'.  The string
+// must be valid.
+static int SkipChars(const unsigned char* p, int pos, int num_chars) {
+  for (int k = 0; k < num_chars; ++k) {
+    pos += Utf8CharLen(p[pos]);
+  }
+  return pos;
+}
+
+const int kUtf8IndexStride = 16;    // offsets of every 16th char
+const int kUtf8MinCachedLen = 256;  // shorter strings are just scanned
+const int kUtf8CacheSize = 4;
+
+struct Utf8Index {
+  Str* s;  // rooted, so the Str can't be freed and its address reused
+  int num_chars;
+  // offsets[k] is the position of char k * kUtf8IndexStride.  nullptr until
+  // it's needed, and for ASCII strings.
+  int* offsets;
+};
+
+Utf8Index gUtf8Cache[kUtf8CacheSize];
+int gUtf8Next = 0;  // evicted next
+bool gUtf8Rooted = false;
+
+// Returns the cache entry for s, with num_chars set.
+static Utf8Index* LookupUtf8(Str* s) {
+  for (int i = 0; i < kUtf8CacheSize; ++i) {
+    if (gUtf8Cache[i].s == s) {
+      return &gUtf8Cache[i];
+    }
+  }
+
+  if (!gUtf8Rooted) {
+    for (int i = 0; i < kUtf8CacheSize; ++i) {
+      gHeap.RootGlobalVar(reinterpret_cast<RawObject**>(&gUtf8Cache[i].s));
+    }
+    gUtf8Rooted = true;
+  }
+
+  Utf8Index* entry = &gUtf8Cache[gUtf8Next];
+  gUtf8Next = (gUtf8Next + 1) % kUtf8CacheSize;
+
+  free(entry->offsets);
+  entry->s = s;
+  entry->num_chars =
+      CountChars(reinterpret_cast<unsigned char*>(s->data_), len(s));
+  entry->offsets = nullptr;
+  return entry;
+}
+
+int Utf8CharCount(Str* s) {
+  int n = len(s);
+  if (n < kUtf8MinCachedLen) {
+    return CountChars(reinterpret_cast<unsigned char*>(s->data_), n);
+  }
+  return LookupUtf8(s)->num_chars;
+}
+
+int Utf8CharOffset(Str* s, int i) {
+  const unsigned char* p = reinterpret_cast<unsigned char*>(s->data_);
+  int n = len(s);
+  if (n < kUtf8MinCachedLen) {
+    int pos = 0;
+    for (int k = 0; k < i && pos < n; ++k) {
+      pos += Utf8CharLen(p[pos]);
+    }
+    return pos;
+  }
+
+  Utf8Index* entry = LookupUtf8(s);
+  DCHECK(entry->num_chars != -1);
+  if (i >= entry->num_chars) {
+    return n;
+  }
+  if (entry->num_chars == n) {
+    return i;  // ASCII
+  }
+
+  if (entry->offsets == nullptr) {
+    int num_offsets = (entry->num_chars - 1) / kUtf8IndexStride + 1;
+    entry->offsets = static_cast<int*>(malloc(sizeof(int) * num_offsets));
+    int pos = 0;
+    for (int k = 0; k < num_offsets; ++k) {
+      entry->offsets[k] = pos;
+      if (k + 1 < num_offsets) {
+        pos = SkipChars(p, pos, kUtf8IndexStride);
+      }
+    }
+  }
+  int pos = entry->offsets[i / kUtf8IndexStride];
+  return SkipChars(p, pos, i % kUtf8IndexStride);
+}
+
 class MutableStr : public Str {};
 
 MutableStr* NewMutableStr(int cap) {
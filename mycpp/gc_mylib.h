@@ -30,6 +30,10 @@ inline void MaybeCollect() {
   gHeap.MaybeCollect();
 }
 
+inline void IdleCollect() {
+  gHeap.IdleCollect();
+}
+
 // Used by generated _build/cpp/osh_eval.cc
 inline Str* StrFromC(const char* s) {
   return ::StrFromC(s);
@@ -44,6 +48,29 @@ void print_stderr(Str* s);
 
 Tuple2<Str*, Str*> split_once(Str* s, Str* delim);
 
+// Returns the canonical Str that's equal to s, so equal names share one
+// object.  Used for identifiers from the lexer: str_equals() and Dict lookups
+// then succeed on pointer equality, and the hash is computed once.  Interned
+// strings are never collected.  After kMaxInterned distinct strings, Intern()
+// returns its argument.
+const int kMaxInterned = 1 << 16;
+
+Str* Intern(Str* s);
+
+// For ${#s} and ${s:i:n}, which count UTF-8 characters.
+//
+// Returns the number of characters in s, or -1 if it isn't valid UTF-8.  Like
+// _NextUtf8Char() in osh/string_ops.py, this checks lengths and continuation
+// bytes, but not overlong encodings or surrogates.
+int Utf8CharCount(Str* s);
+
+// Returns the byte offset of character i of s, or len(s) if s has i or fewer
+// characters.  s must be valid UTF-8.
+//
+// The count and an index of every 16th character are cached for the last few
+// long strings, so a loop over ${s:i:1} takes constant time per iteration.
+int Utf8CharOffset(Str* s, int i);
+
 template <typename K, typename V>
 void dict_erase(Dict<K, V>* haystack, K needle) {
   int pos = haystack->position_of_key(needle);
@@ -207,7 +234,7 @@ extern Writer* gStdout;
 inline Writer* Stdout() {
   if (gStdout == nullptr) {
     gStdout = Alloc<CFileWriter>(stdout);
-    gHeap.RootGlobalVar(gStdout);
+    gHeap.RootGlobalVar(reinterpret_cast<RawObject**>(&gStdout));
   }
   return gStdout;
 }
@@ -217,7 +244,7 @@ extern Writer* gStderr;
 inline Writer* Stderr() {
   if (gStderr == nullptr) {
     gStderr = Alloc<CFileWriter>(stderr);
-    gHeap.RootGlobalVar(gStderr);
+    gHeap.RootGlobalVar(reinterpret_cast<RawObject**>(&gStderr));
   }
   return gStderr;
 }
@@ -1,5 +1,8 @@
 #include "mycpp/gc_mylib.h"
 
+#include <string>
+#include <vector>
+
 #include "mycpp/gc_alloc.h"  // gHeap
 #include "mycpp/gc_str.h"
 #include "vendor/greatest.h"
@@ -186,6 +189,95 @@ TEST BufLineReader_test() {
   PASS();
 }
 
+TEST Intern_test() {
+  Str* a = nullptr;
+  Str* b = nullptr;
+  Str* c = nullptr;
+  StackRoots _roots({&a, &b, &c});
+
+  a = StrFromC("foo");
+  b = StrFromC("foo");
+  c = StrFromC("bar");
+  ASSERT(a != b);
+
+  ASSERT_EQ(a, mylib::Intern(a));
+  ASSERT_EQ(a, mylib::Intern(b));
+  ASSERT_EQ(c, mylib::Intern(c));
+
+  // Survives a collection
+  gHeap.Collect();
+  ASSERT_EQ(mylib::Intern(a), mylib::Intern(StrFromC("foo")));
+  ASSERT(str_equals0("foo", mylib::Intern(StrFromC("foo"))));
+
+  // Hashes are cached, so different strings compare without memcmp()
+  ASSERT(!str_equals(mylib::Intern(StrFromC("baz")), mylib::Intern(c)));
+
+  // The table is capped
+  for (int i = 0; i < mylib::kMaxInterned; ++i) {
+    mylib::Intern(str(i));
+  }
+  a = StrFromC("not interned");
+  ASSERT_EQ(a, mylib::Intern(a));
+  ASSERT(mylib::Intern(StrFromC("not interned")) != a);
+  ASSERT_EQ(mylib::Intern(c), mylib::Intern(StrFromC("bar")));
+
+  PASS();
+}
+
+TEST Utf8_test() {
+  Str* s = nullptr;
+  Str* t = nullptr;
+  StackRoots _roots({&s, &t});
+
+  // mu is 2 bytes, and U+20000 is 4 bytes
+  s = StrFromC("a\xce\xbc\xf0\xa0\x80\x80z");
+  ASSERT_EQ_FMT(4, mylib::Utf8CharCount(s), "%d");
+  ASSERT_EQ_FMT(0, mylib::Utf8CharOffset(s, 0), "%d");
+  ASSERT_EQ_FMT(1, mylib::Utf8CharOffset(s, 1), "%d");
+  ASSERT_EQ_FMT(3, mylib::Utf8CharOffset(s, 2), "%d");
+  ASSERT_EQ_FMT(7, mylib::Utf8CharOffset(s, 3), "%d");
+  ASSERT_EQ_FMT(8, mylib::Utf8CharOffset(s, 4), "%d");
+  ASSERT_EQ_FMT(8, mylib::Utf8CharOffset(s, 99), "%d");
+
+  ASSERT_EQ_FMT(0, mylib::Utf8CharCount(kEmptyString), "%d");
+  ASSERT_EQ_FMT(-1, mylib::Utf8CharCount(StrFromC("\xff")), "%d");
+  ASSERT_EQ_FMT(-1, mylib::Utf8CharCount(StrFromC("a\xce")), "%d");
+  ASSERT_EQ_FMT(-1, mylib::Utf8CharCount(StrFromC("\xce\xce")), "%d");
+
+  // Long strings are indexed.  Alternate runs of ASCII and 3-byte chars.
+  std::string expected;
+  std::vector<int> offsets;
+  for (int i = 0; i < 1000; ++i) {
+    offsets.push_back(expected.size());
+    if ((i / 20) % 2 == 0) {
+      expected += 'x';
+    } else {
+      expected += "\xe2\x82\xac";  // euro sign
+    }
+  }
+  s = StrFromC(expected.c_str(), expected.size());
+  ASSERT_EQ_FMT(1000, mylib::Utf8CharCount(s), "%d");
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ_FMT(offsets[i], mylib::Utf8CharOffset(s, i), "%d");
+  }
+  ASSERT_EQ_FMT(len(s), mylib::Utf8CharOffset(s, 1000), "%d");
+
+  // The cached count survives a collection, which may move s
+  gHeap.Collect();
+  ASSERT_EQ_FMT(offsets[777], mylib::Utf8CharOffset(s, 777), "%d");
+
+  // An invalid byte at the end of a long string
+  t = StrFromC((expected + "\x80").c_str(), expected.size() + 1);
+  ASSERT_EQ_FMT(-1, mylib::Utf8CharCount(t), "%d");
+
+  // ASCII
+  t = StrFromC(std::string(300, 'y').c_str());
+  ASSERT_EQ_FMT(300, mylib::Utf8CharCount(t), "%d");
+  ASSERT_EQ_FMT(123, mylib::Utf8CharOffset(t, 123), "%d");
+
+  PASS();
+}
+
 TEST files_test() {
   mylib::Writer* stdout_ = mylib::Stdout();
   log("stdout isatty() = %d", stdout_->isatty());
@@ -267,6 +359,8 @@ int main(int argc, char** argv) {
   // RUN_TEST(writeln_test);
   RUN_TEST(BufWriter_test);
   RUN_TEST(BufLineReader_test);
+  RUN_TEST(Intern_test);
+  RUN_TEST(Utf8_test);
   RUN_TEST(files_test);
   RUN_TEST(for_test_coverage);
 
@@ -65,8 +65,8 @@ const int kFieldMaskBits = 16;
 
 #else
   #define FIELD_MASK(header) (header).field_mask
-                             // TODO: derive from obj_len
-  #define STR_LEN(header) -1
+  // Derived from obj_len, which is kStrHeaderSize + len + 1 (NUL terminator)
+  #define STR_LEN(header) ((header).obj_len - kStrHeaderSize - 1)
   #define NUM_POINTERS(header) \
     ((header.obj_len - kSlabHeaderSize) / sizeof(void*))
 #endif
@@ -81,29 +81,73 @@ struct RawObject {
 // TODO: ./configure could detect endian-ness, and reorder the fields in
 // ObjHeader.  See mycpp/demo/gc_header.cc.
 
-// Used by hand-written and generated classes
-#define GC_CLASS_FIXED(header_, field_mask, obj_len)                         \
-  header_ {                                                                  \
-    kIsHeader, TypeTag::OtherClass, kNoObjId, HeapTag::FixedSize, field_mask \
-  }
+#if defined(MARK_SWEEP) || defined(BUMP_LEAK)
 
-// Classes with no inheritance (e.g. used by mycpp)
-#define GC_CLASS_SCANNED(header_, num_pointers, obj_len)                     \
-  header_ {                                                                  \
-    kIsHeader, TypeTag::OtherClass, kNoObjId, HeapTag::Scanned, num_pointers \
-  }
+  // Used by hand-written and generated classes
+  #define GC_CLASS_FIXED(header_, field_mask, obj_len)                         \
+    header_ {                                                                  \
+      kIsHeader, TypeTag::OtherClass, kNoObjId, HeapTag::FixedSize, field_mask \
+    }
+
+  // Classes with no inheritance (e.g. used by mycpp)
+  #define GC_CLASS_SCANNED(header_, num_pointers, obj_len)                     \
+    header_ {                                                                  \
+      kIsHeader, TypeTag::OtherClass, kNoObjId, HeapTag::Scanned, num_pointers \
+    }
+
+  // Used by frontend/flag_gen.py.  TODO: Sort fields and use GC_CLASS_SCANNED
+  #define GC_CLASS(header_, heap_tag, field_mask, obj_len)           \
+    header_ {                                                        \
+      kIsHeader, TypeTag::OtherClass, kNoObjId, heap_tag, field_mask \
+    }
+
+  // Used by ASDL.  TODO: Sort fields and use GC_CLASS_SCANNED
+  #define GC_ASDL_CLASS(header_, type_tag, field_mask, obj_len)     \
+    header_ {                                                       \
+      kIsHeader, type_tag, kNoObjId, HeapTag::FixedSize, field_mask \
+    }
+
+  #define GC_TUPLE(header_, field_mask, obj_len)                          \
+    header_ {                                                             \
+      kIsHeader, TypeTag::Tuple, kNoObjId, HeapTag::FixedSize, field_mask \
+    }
 
-// Used by frontend/flag_gen.py.  TODO: Sort fields and use GC_CLASS_SCANNED
-#define GC_CLASS(header_, heap_tag, field_mask, obj_len)           \
-  header_ {                                                        \
-    kIsHeader, TypeTag::OtherClass, kNoObjId, heap_tag, field_mask \
-  }
+#else
 
-// Used by ASDL.  TODO: Sort fields and use GC_CLASS_SCANNED
-#define GC_ASDL_CLASS(header_, type_tag, field_mask, obj_len)     \
-  header_ {                                                       \
-    kIsHeader, type_tag, kNoObjId, HeapTag::FixedSize, field_mask \
-  }
+  // Cheney: the header has both field_mask and obj_len, the number of bytes
+  // to copy.  Alloc<T>() overwrites obj_len with sizeof(T), which accounts
+  // for subclasses, and NewStr() / NewSlab() set it for variable length
+  // objects.
+
+  #define GC_CLASS_FIXED(header_, field_mask, obj_len)                \
+    header_ {                                                         \
+      kIsHeader, TypeTag::OtherClass, field_mask, HeapTag::FixedSize, \
+          obj_len                                                     \
+    }
+
+  // field_mask holds the number of pointers, which may be followed by other
+  // members.  A Slab<T*> is all pointers, up to obj_len.
+  #define GC_CLASS_SCANNED(header_, num_pointers, obj_len)                    \
+    header_ {                                                                 \
+      kIsHeader, TypeTag::OtherClass, num_pointers, HeapTag::Scanned, obj_len \
+    }
+
+  #define GC_CLASS(header_, heap_tag, field_mask, obj_len)          \
+    header_ {                                                       \
+      kIsHeader, TypeTag::OtherClass, field_mask, heap_tag, obj_len \
+    }
+
+  #define GC_ASDL_CLASS(header_, type_tag, field_mask, obj_len)    \
+    header_ {                                                      \
+      kIsHeader, type_tag, field_mask, HeapTag::FixedSize, obj_len \
+    }
+
+  #define GC_TUPLE(header_, field_mask, obj_len)                         \
+    header_ {                                                            \
+      kIsHeader, TypeTag::Tuple, field_mask, HeapTag::FixedSize, obj_len \
+    }
+
+#endif
 
 #define GC_STR(header_)                                            \
   header_ {                                                        \
@@ -115,11 +159,6 @@ struct RawObject {
     kIsHeader, TypeTag::Slab, kZeroMask, heap_tag, num_pointers \
   }
 
-#define GC_TUPLE(header_, field_mask, obj_len)                          \
-  header_ {                                                             \
-    kIsHeader, TypeTag::Tuple, kNoObjId, HeapTag::FixedSize, field_mask \
-  }
-
 // TODO: could omit this in BUMP_LEAK mode
 #define GC_OBJ(var_name) ObjHeader var_name
 
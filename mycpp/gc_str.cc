@@ -2,6 +2,9 @@
 
 #include <ctype.h>  // isalpha(), isdigit()
 #include <stdarg.h>
+#ifdef __SSE2__
+  #include <emmintrin.h>  // SearchForward()
+#endif
 
 #include <regex>
 
@@ -15,28 +18,106 @@ GLOBAL_STR(kEmptyString, "");
 static const std::regex gStrFmtRegex("([^%]*)(?:%([0-9]*)(.))?");
 static const int kMaxFmtWidth = 256;  // arbitrary...
 
+// Returns a pointer to the first occurrence of needle in haystack, or nullptr.
+//
+// Like glibc's memmem(), but tuned for the short needles and haystacks of
+// shell words: there's no setup, and a candidate position needs both the first
+// and the last byte of the needle to match before it's compared with memcmp().
+// With SSE2, 16 candidates are filtered at once.
+static const char* SearchForward(const char* haystack, int h_len,
+                                 const char* needle, int n_len) {
+  if (n_len == 0) {
+    return haystack;
+  }
+  if (n_len > h_len) {
+    return nullptr;
+  }
+  if (n_len == 1) {
+    return static_cast<const char*>(memchr(haystack, needle[0], h_len));
+  }
+
+  int last_start = h_len - n_len;  // last position the needle can start at
+  int i = 0;
+
+#ifdef __SSE2__
+  __m128i first = _mm_set1_epi8(needle[0]);
+  __m128i last = _mm_set1_epi8(needle[n_len - 1]);
+  // The second load ends at i + n_len + 14 <= h_len - 1
+  for (; i + 15 <= last_start; i += 16) {
+    __m128i block_first =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + i));
+    __m128i block_last = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(haystack + i + n_len - 1));
+    unsigned mask = _mm_movemask_epi8(_mm_and_si128(
+        _mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last)));
+    while (mask) {
+      int j = i + __builtin_ctz(mask);
+      if (memcmp(haystack + j + 1, needle + 1, n_len - 2) == 0) {
+        return haystack + j;
+      }
+      mask &= mask - 1;  // clear lowest bit
+    }
+  }
+#endif
+
+  char first_byte = needle[0];
+  char last_byte = needle[n_len - 1];
+  while (i <= last_start) {
+    const char* p = static_cast<const char*>(
+        memchr(haystack + i, first_byte, last_start - i + 1));
+    if (p == nullptr) {
+      return nullptr;
+    }
+    i = p - haystack;
+    if (p[n_len - 1] == last_byte &&
+        memcmp(p + 1, needle + 1, n_len - 2) == 0) {
+      return p;
+    }
+    i++;
+  }
+  return nullptr;
+}
+
+// Returns a pointer to the last occurrence of needle in haystack, or nullptr.
+static const char* SearchBackward(const char* haystack, int h_len,
+                                  const char* needle, int n_len) {
+  if (n_len > h_len) {
+    return nullptr;
+  }
+  if (n_len == 0) {
+    return haystack + h_len;
+  }
+  char first_byte = needle[0];
+  char last_byte = needle[n_len - 1];
+  for (int i = h_len - n_len; i >= 0; --i) {
+    const char* p = haystack + i;
+    if (p[0] == first_byte && p[n_len - 1] == last_byte &&
+        memcmp(p, needle, n_len) == 0) {
+      return p;
+    }
+  }
+  return nullptr;
+}
+
 int Str::find(Str* needle, int pos) {
   int len_ = len(this);
-  assert(len(needle) == 1);  // Oil's usage
-  char c = needle->data_[0];
-  for (int i = pos; i < len_; ++i) {
-    if (data_[i] == c) {
-      return i;
-    }
+  if (pos > len_) {
+    return -1;
   }
-  return -1;
+  const char* p =
+      SearchForward(data_ + pos, len_ - pos, needle->data_, len(needle));
+  if (p == nullptr) {
+    return -1;
+  }
+  return p - data_;
 }
 
 int Str::rfind(Str* needle) {
-  int len_ = len(this);
-  assert(len(needle) == 1);  // Oil's usage
-  char c = needle->data_[0];
-  for (int i = len_ - 1; i >= 0; --i) {
-    if (data_[i] == c) {
-      return i;
-    }
+  const char* p = SearchBackward(data_, len(this), needle->data_, len(needle));
+  if (p == nullptr) {
+    return -1;
   }
-  return -1;
+  return p - data_;
 }
 
 bool Str::isdigit() {
@@ -238,20 +319,20 @@ Str* Str::replace(Str* old, Str* new_str) {
 
   int this_len = len(this);
   int old_len = len(old);
+  DCHECK(old_len > 0);  // Python inserts new_str between every char
 
-  const char* last_possible = data_ + this_len - old_len;
-
-  const char* p_this = data_;  // advances through 'this'
+  const char* end = data_ + this_len;
 
   // First pass: Calculate number of replacements, and hence new length
   int replace_count = 0;
-  while (p_this <= last_possible) {
-    if (memcmp(p_this, old_data, old_len) == 0) {  // equal
-      replace_count++;
-      p_this += old_len;
-    } else {
-      p_this++;
+  const char* p_this = data_;  // advances through 'this'
+  while (true) {
+    const char* match = SearchForward(p_this, end - p_this, old_data, old_len);
+    if (match == nullptr) {
+      break;
     }
+    replace_count++;
+    p_this = match + old_len;
   }
 
   // log("replacements %d", replace_count);
@@ -269,23 +350,19 @@ Str* Str::replace(Str* old, Str* new_str) {
   const char* new_data = new_str->data_;
   const size_t new_len = new_str_len;
 
-  // Second pass: Copy pieces into 'result'
+  // Second pass: Copy the pieces between matches, and new_str, into 'result'
   p_this = data_;                  // back to beginning
   char* p_result = result->data_;  // advances through 'result'
 
-  while (p_this <= last_possible) {
-    // Note: would be more efficient if we remembered the match positions
-    if (memcmp(p_this, old_data, old_len) == 0) {  // equal
-      memcpy(p_result, new_data, new_len);         // Copy from new_str
-      p_result += new_len;
-      p_this += old_len;
-    } else {  // copy 1 byte
-      *p_result = *p_this;
-      p_result++;
-      p_this++;
-    }
+  for (int i = 0; i < replace_count; ++i) {
+    const char* match = SearchForward(p_this, end - p_this, old_data, old_len);
+    memcpy(p_result, p_this, match - p_this);
+    p_result += match - p_this;
+    memcpy(p_result, new_data, new_len);  // Copy from new_str
+    p_result += new_len;
+    p_this = match + old_len;
   }
-  memcpy(p_result, p_this, data_ + this_len - p_this);  // last part of string
+  memcpy(p_result, p_this, end - p_this);  // last part of string
   return result;
 }
 
@@ -424,8 +501,8 @@ static void AppendPart(List<Str*>* result, Str* s, int left, int right) {
 // The code structure is taken from CPython's Objects/stringlib/split.h.
 List<Str*>* Str::split(Str* sep, int max_split) {
   DCHECK(sep != nullptr);
-  DCHECK(len(sep) == 1);  // we can only split one char
-  char sep_char = sep->data_[0];
+  int sep_len = len(sep);
+  DCHECK(sep_len > 0);  // Python raises ValueError: empty separator
 
   int str_len = len(this);
   if (str_len == 0) {
@@ -435,20 +512,19 @@ List<Str*>* Str::split(Str* sep, int max_split) {
 
   List<Str*>* result = NewList<Str*>({});
   int left = 0;
-  int right = 0;
   int num_parts = 0;  // 3 splits results in 4 parts
 
-  while (right < str_len && num_parts < max_split) {
+  while (num_parts < max_split) {
     // search for separator
-    for (; right < str_len; right++) {
-      if (data_[right] == sep_char) {
-        AppendPart(result, this, left, right);
-        right++;
-        left = right;
-        num_parts++;
-        break;
-      }
+    const char* p =
+        SearchForward(data_ + left, str_len - left, sep->data_, sep_len);
+    if (p == nullptr) {
+      break;
     }
+    int right = p - data_;
+    AppendPart(result, this, left, right);
+    left = right + sep_len;
+    num_parts++;
   }
   if (num_parts == 0) {  // Optimization when there is no split
     result->append(this);
@@ -549,6 +625,18 @@ static inline Str* _StrFormat(const char* fmt, int fmt_len, va_list args) {
   return StrFromC(buf.c_str(), buf.size());
 }
 
+StrIter::StrIter(Str* s) : s_(s), i_(0), len_(len(s)) {
+#ifdef CHENEY_GC
+  gHeap.PushRoot(reinterpret_cast<RawObject**>(&s_));
+#endif
+}
+
+StrIter::~StrIter() {
+#ifdef CHENEY_GC
+  gHeap.PopRoot();
+#endif
+}
+
 Str* StrIter::Value() {  // similar to index_()
   Str* result = NewStr(1);
   result->data_[0] = s_->data_[i_];
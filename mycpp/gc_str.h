@@ -10,7 +10,7 @@ class List;
 class Str {
  public:
   // Don't call this directly.  Call NewStr() instead, which calls this.
-  Str() : GC_STR(header_) {
+  Str() : GC_STR(header_), hash_value_(-1) {
   }
 
   char* data() {
@@ -101,19 +101,30 @@ inline int len(const Str* s) {
 #endif
 }
 
+// Hash for Dict<Str*, V> keys.  FNV-1a, computed once and cached in
+// hash_value_, which is -1 until then (see GLOBAL_STR).  Strings are immutable
+// after they're constructed, so the cached value never goes stale.
+inline int str_hash(Str* s) {
+  if (s->hash_value_ < 0) {
+    unsigned h = 2166136261u;  // 32-bit FNV offset basis
+    int n = len(s);
+    for (int i = 0; i < n; ++i) {
+      h ^= static_cast<unsigned char>(s->data_[i]);
+      h *= 16777619u;  // 32-bit FNV prime
+    }
+    s->hash_value_ = h & 0x7fffffff;  // non-negative
+  }
+  return s->hash_value_;
+}
+
 Str* StrFormat(const char* fmt, ...);
 Str* StrFormat(Str* fmt, ...);
 
 // NOTE: This iterates over bytes.
 class StrIter {
  public:
-  explicit StrIter(Str* s) : s_(s), i_(0), len_(len(s)) {
-    // Cheney only: s_ could be moved during iteration.
-    // gHeap.PushRoot(reinterpret_cast<RawObject**>(&s_));
-  }
-  ~StrIter() {
-    // gHeap.PopRoot();
-  }
+  explicit StrIter(Str* s);  // Cheney roots s_, which could move
+  ~StrIter();
   void Next() {
     i_++;
   }
@@ -159,9 +170,17 @@ class GlobalStr {
 // https://old.reddit.com/r/cpp_questions/comments/j0khh6/how_to_constexpr_initialize_class_member_thats/
 // https://stackoverflow.com/questions/10422487/how-can-i-initialize-char-arrays-in-a-constructor
 
+#if defined(MARK_SWEEP) || defined(BUMP_LEAK)
+  #define GLOBAL_STR_LEN(val) (sizeof(val) - 1)
+#else
+  // Cheney derives the length from obj_len; sizeof(val) includes the NUL
+  #define GLOBAL_STR_LEN(val) (kStrHeaderSize + sizeof(val))
+#endif
+
 #define GLOBAL_STR(name, val)                                                 \
   GlobalStr<sizeof(val)> _##name = {                                          \
-      {kIsHeader, TypeTag::Str, kZeroMask, HeapTag::Global, sizeof(val) - 1}, \
+      {kIsHeader, TypeTag::Str, kZeroMask, HeapTag::Global,                   \
+       GLOBAL_STR_LEN(val)},                                                  \
       -1,                                                                     \
       val};                                                                   \
   Str* name = reinterpret_cast<Str*>(&_##name);
@@ -2,6 +2,8 @@
 
 #include <limits.h>  // INT_MAX
 
+#include <string>  // test_str_find_long()
+
 #include "mycpp/comparators.h"  // str_equals
 #include "mycpp/gc_alloc.h"     // gHeap
 #include "mycpp/gc_builtins.h"  // print()
@@ -48,12 +50,11 @@ TEST test_str_gc_header() {
   // ASSERT_EQ_FMT(kStrHeaderSize + 1, str1->header_.obj_len, "%d");
   // ASSERT_EQ_FMT(kStrHeaderSize + 7 + 1, str2->header_.obj_len, "%d");
 
-  // Make sure they're on the heap
+  // Make sure str2 is on the heap.  str1 is the global kEmptyString.
 #ifndef MARK_SWEEP
-  int diff1 = reinterpret_cast<char*>(str1) - gHeap.from_space_.begin_;
+  ASSERT_EQ(kEmptyString, str1);
   int diff2 = reinterpret_cast<char*>(str2) - gHeap.from_space_.begin_;
-  ASSERT(diff1 < 1024);
-  ASSERT(diff2 < 1024);
+  ASSERT(0 <= diff2 && diff2 < gHeap.from_space_.size_);
 #endif
 
   ASSERT_EQ(0, len(str1));
@@ -119,6 +120,65 @@ TEST test_str_find() {
   ASSERT_EQ(4, s->rfind(StrFromC("a")));
   ASSERT_EQ(6, s->rfind(StrFromC("c")));
 
+  // Starting position
+  ASSERT_EQ(4, s->find(StrFromC("a"), 1));
+  ASSERT_EQ(-1, s->find(StrFromC("a"), 5));
+  ASSERT_EQ(-1, s->find(StrFromC("a"), 8));
+
+  // Multi-byte needles
+  ASSERT_EQ(1, s->find(StrFromC("bc")));
+  ASSERT_EQ(5, s->find(StrFromC("bc"), 2));
+  ASSERT_EQ(5, s->rfind(StrFromC("bc")));
+  ASSERT_EQ(0, s->find(s));
+  ASSERT_EQ(0, s->rfind(s));
+  ASSERT_EQ(-1, s->find(StrFromC("abc-abc-")));
+  ASSERT_EQ(-1, s->find(StrFromC("ac")));
+  ASSERT_EQ(-1, s->rfind(StrFromC("ac")));
+
+  // Empty needle, like Python
+  ASSERT_EQ(0, s->find(kEmptyString));
+  ASSERT_EQ(7, s->find(kEmptyString, 7));
+  ASSERT_EQ(7, s->rfind(kEmptyString));
+
+  // NUL bytes
+  Str* n = StrFromC("a\0b\0c", 5);
+  ASSERT_EQ(1, n->find(StrFromC("\0b", 2)));
+  ASSERT_EQ(3, n->rfind(StrFromC("\0", 1)));
+
+  PASS();
+}
+
+// Compare with std::string::find() for haystacks that span several 16-byte
+// blocks, and matches near the block boundaries
+TEST test_str_find_long() {
+  std::string h;
+  for (int i = 0; i < 100; ++i) {
+    h += static_cast<char>('a' + (i * 7) % 5);  // a few repeated letters
+  }
+  Str* s = StrFromC(h.data(), h.size());
+
+  const char* needles[] = {"a", "ab", "ca", "dab", "bdace", "zz", "eb",
+                           "adbecad", "aa"};
+  for (const char* needle : needles) {
+    std::string nd(needle);
+    Str* n = StrFromC(needle);
+    for (int pos = 0; pos <= static_cast<int>(h.size()); ++pos) {
+      size_t expected = h.find(nd, pos);
+      int e = expected == std::string::npos ? -1 : expected;
+      ASSERT_EQ_FMT(e, s->find(n, pos), "%d");
+    }
+    size_t expected = h.rfind(nd);
+    int e = expected == std::string::npos ? -1 : expected;
+    ASSERT_EQ_FMT(e, s->rfind(n), "%d");
+  }
+
+  // The needle is at the very end
+  Str* t = StrFromC("0123456789abcdef0123456789abcdefXYZ");
+  ASSERT_EQ(32, t->find(StrFromC("XYZ")));
+  ASSERT_EQ(31, t->find(StrFromC("fXYZ")));
+  ASSERT(str_contains(t, StrFromC("9abcdefX")));
+  ASSERT(!str_contains(t, StrFromC("XYZ0")));
+
   PASS();
 }
 
@@ -799,6 +859,20 @@ TEST test_str_concat() {
     ASSERT(str_equals(result, StrFromC("aac")));
   }
 
+  printf("------- str_concat_n -------\n");
+
+  {
+    Str* result = str_concat_n({StrFromC(""), StrFromC("")});
+    ShowString(result);
+    ASSERT(str_equals(result, kEmptyString));
+  }
+  {
+    Str* result = str_concat_n(
+        {StrFromC("a"), StrFromC(""), StrFromC("bb"), StrFromC("c")});
+    ShowString(result);
+    ASSERT(str_equals(result, StrFromC("abbc")));
+  }
+
   printf("---------- Done ----------\n");
 
   PASS();
@@ -1029,6 +1103,20 @@ TEST test_str_split() {
     ASSERT(are_equal(parts->index_(2), StrFromC("#")));
   }
 
+  {
+    // Multi-byte separator
+    List<Str*>* parts = StrFromC("a::b:c::")->split(StrFromC("::"));
+    ShowList(parts);
+    ASSERT_EQ(3, len(parts));
+    ASSERT(are_equal(parts->index_(0), StrFromC("a")));
+    ASSERT(are_equal(parts->index_(1), StrFromC("b:c")));
+    ASSERT(are_equal(parts->index_(2), StrFromC("")));
+
+    parts = StrFromC("a--b--c")->split(StrFromC("--"), 1);
+    ASSERT_EQ(2, len(parts));
+    ASSERT(are_equal(parts->index_(1), StrFromC("b--c")));
+  }
+
   printf("---------- Done ----------\n");
 
   PASS();
@@ -1410,6 +1498,7 @@ int main(int argc, char** argv) {
 
   // Members
   RUN_TEST(test_str_find);
+  RUN_TEST(test_str_find_long);
   RUN_TEST(test_str_strip);
   RUN_TEST(test_str_upper_lower);
   RUN_TEST(test_str_replace);
@@ -1,6 +1,7 @@
 #include "mycpp/mark_sweep_heap.h"
 
 #include <inttypes.h>  // PRId64
+#include <malloc.h>    // malloc_trim()
 #include <stdlib.h>    // getenv()
 #include <string.h>    // strlen()
 #include <sys/time.h>  // gettimeofday()
@@ -8,6 +9,7 @@
 #include <unistd.h>    // STDERR_FILENO
 
 #include "_build/detected-cpp-config.h"  // for GC_TIMING
+#include "mycpp/alloc_log.h"             // gAllocLog
 #include "mycpp/gc_builtins.h"           // StringToInteger()
 #include "mycpp/gc_slab.h"
 
@@ -18,8 +20,37 @@ void MarkSweepHeap::Init() {
   Init(1000);  // collect at 1000 objects in tests
 }
 
+// Parse a number of bytes with an optional K, M, or G suffix, e.g. 512M
+static bool BytesFromEnv(const char* name, int64_t* result) {
+  char* e = getenv(name);
+  if (e == nullptr || *e == '\0') {
+    return false;
+  }
+  char* end;
+  int64_t n = strtoll(e, &end, 10);
+  switch (*end) {
+  case 'K':
+    n = KiB(n);
+    end++;
+    break;
+  case 'M':
+    n = MiB(n);
+    end++;
+    break;
+  case 'G':
+    n = GiB(n);
+    end++;
+    break;
+  }
+  if (*end != '\0' || n < 0) {
+    return false;
+  }
+  *result = n;
+  return true;
+}
+
 void MarkSweepHeap::Init(int gc_threshold) {
-  gc_threshold_ = gc_threshold;
+  min_threshold_ = gc_threshold;
 
   char* e;
   e = getenv("OIL_GC_THRESHOLD");
@@ -27,17 +58,40 @@ void MarkSweepHeap::Init(int gc_threshold) {
     int result;
     if (StringToInteger(e, strlen(e), 10, &result)) {
       // Override collection threshold
-      gc_threshold_ = result;
+      min_threshold_ = result;
+    }
+  }
+
+  e = getenv("OIL_GC_PERCENT");
+  if (e) {
+    int result;
+    if (StringToInteger(e, strlen(e), 10, &result) && result >= 0) {
+      gc_percent_ = result;
     }
   }
 
+  BytesFromEnv("OIL_GC_MIN_HEAP", &min_heap_bytes_);
+  BytesFromEnv("OIL_GC_MEMORY_LIMIT", &memory_limit_);
+
+  gc_threshold_ = min_threshold_;
+  bytes_threshold_ = min_heap_bytes_;
+  if (memory_limit_ && bytes_threshold_ > memory_limit_) {
+    bytes_threshold_ = memory_limit_;
+  }
+
   // only for developers
   e = getenv("_OIL_GC_VERBOSE");
   if (e && strcmp(e, "1") == 0) {
     gc_verbose_ = true;
   }
 
+  e = getenv("OIL_GC_IDLE");
+  if (e && strcmp(e, "0") == 0) {
+    idle_collect_ = false;
+  }
+
   live_objs_.reserve(KiB(10));
+  live_obj_sizes_.reserve(KiB(10));
   roots_.reserve(KiB(1));  // prevent resizing in common case
 }
 
@@ -47,7 +101,7 @@ int MarkSweepHeap::MaybeCollect() {
   int result = Collect();
   #else
   int result = -1;
-  if (num_live_ > gc_threshold_) {
+  if (num_live_ > gc_threshold_ || bytes_live_ > bytes_threshold_) {
     result = Collect();
   }
   #endif
@@ -60,11 +114,7 @@ int MarkSweepHeap::MaybeCollect() {
 void* MarkSweepHeap::Allocate(size_t num_bytes) {
   // log("Allocate %d", num_bytes);
 
-  if (to_free_.empty()) {
-    // Use higher object IDs
-    obj_id_after_allocate_ = greatest_obj_id_;
-    greatest_obj_id_++;
-  } else {
+  if (!to_free_.empty()) {
     RawObject* dead = to_free_.back();
     to_free_.pop_back();
 
@@ -72,14 +122,24 @@ void* MarkSweepHeap::Allocate(size_t num_bytes) {
     obj_id_after_allocate_ = header->obj_id;  // reuse the dead object's ID
 
     free(dead);
+  } else if (!free_ids_.empty()) {
+    // Reuse the ID of an object that EagerFree() already freed
+    obj_id_after_allocate_ = free_ids_.back();
+    free_ids_.pop_back();
+  } else {
+    // Use higher object IDs
+    obj_id_after_allocate_ = greatest_obj_id_;
+    greatest_obj_id_++;
   }
 
   void* result = calloc(num_bytes, 1);
   DCHECK(result != nullptr);
 
   live_objs_.push_back(reinterpret_cast<RawObject*>(result));
+  live_obj_sizes_.push_back(num_bytes);
 
   num_live_++;
+  bytes_live_ += num_bytes;
   num_allocated_++;
   bytes_allocated_ += num_bytes;
 
@@ -186,17 +246,47 @@ void MarkSweepHeap::Sweep() {
     // Compact live_objs_ and populate to_free_.  Note: doing the reverse could
     // be more efficient when many objects are dead.
     if (is_live) {
+      live_obj_sizes_[last_live_index] = live_obj_sizes_[i];
       live_objs_[last_live_index++] = obj;
     } else {
       to_free_.push_back(obj);
       // free(obj);
       num_live_--;
+      bytes_live_ -= live_obj_sizes_[i];
     }
   }
   live_objs_.resize(last_live_index);  // remove dangling objects
+  live_obj_sizes_.resize(last_live_index);
 
   num_collections_++;
   max_survived_ = std::max(max_survived_, num_live_);
+  max_bytes_survived_ = std::max(max_bytes_survived_, bytes_live_);
+}
+
+// The pacer.  Like Go's GOGC, let the heap grow by gc_percent_ of what
+// survived before collecting again.  This replaces an ad hoc rule that
+// doubled the object threshold when a collection found it 75% full, and it
+// also paces by bytes, since a 1 MB Slab and a 1 byte Str are both 1 object.
+void MarkSweepHeap::SetTriggers() {
+  int old_threshold = gc_threshold_;
+  int64_t old_bytes_threshold = bytes_threshold_;
+
+  int64_t objs = static_cast<int64_t>(num_live_) * (100 + gc_percent_) / 100;
+  gc_threshold_ = std::max(static_cast<int64_t>(min_threshold_),
+                           std::min(objs, static_cast<int64_t>(kMaxObjId)));
+
+  int64_t goal =
+      std::max(min_heap_bytes_, bytes_live_ * (100 + gc_percent_) / 100);
+  if (memory_limit_ && goal > memory_limit_) {
+    // The limit is soft.  If the live bytes alone are near it, still leave
+    // some headroom, rather than collecting at every GC point.
+    goal = std::max(memory_limit_, bytes_live_ + bytes_live_ / 8);
+  }
+  bytes_threshold_ = goal;
+
+  if (gc_threshold_ > old_threshold || bytes_threshold_ > old_bytes_threshold) {
+    num_growths_++;
+  }
 }
 
 int MarkSweepHeap::Collect() {
@@ -209,6 +299,7 @@ int MarkSweepHeap::Collect() {
 
   int num_roots = roots_.size();
   int num_globals = global_roots_.size();
+  bytes_allocated_at_gc_ = bytes_allocated_;
 
   if (gc_verbose_) {
     log("");
@@ -229,7 +320,7 @@ int MarkSweepHeap::Collect() {
   }
 
   for (int i = 0; i < num_globals; ++i) {
-    RawObject* root = global_roots_[i];
+    RawObject* root = *(global_roots_[i]);
     if (root) {
       MaybeMarkAndPush(root);
     }
@@ -240,23 +331,13 @@ int MarkSweepHeap::Collect() {
 
   Sweep();
 
-  if (gc_verbose_) {
-    log("    %d live after sweep", num_live_);
-  }
-
-  // We know how many are live.  If the number of objects is close to the
-  // threshold (above 75%), then set the threshold to 2 times the number of
-  // live objects.  This is an ad hoc policy that removes observed "thrashing"
-  // -- being at 99% of the threshold and doing FUTILE mark and sweep.
+  SetTriggers();
 
-  int water_mark = (gc_threshold_ * 3) / 4;
-  if (num_live_ > water_mark) {
-    gc_threshold_ = num_live_ * 2;
-    num_growths_++;
-    if (gc_verbose_) {
-      log("    exceeded %d live objects; gc_threshold set to %d", water_mark,
-          gc_threshold_);
-    }
+  if (gc_verbose_) {
+    log("    %d live objects (%" PRId64 " bytes) after sweep", num_live_,
+        bytes_live_);
+    log("    next GC at %d objects or %" PRId64 " bytes", gc_threshold_,
+        bytes_threshold_);
   }
 
   #ifdef GC_TIMING
@@ -281,18 +362,60 @@ int MarkSweepHeap::Collect() {
   return num_live_;  // for unit tests only
 }
 
+// Called at the prompt, after MaybeCollect(), before the interactive loop
+// blocks on the next line of input.  The user waits for this before the prompt
+// is drawn, so it only does anything after a burst of allocation: a quarter of
+// the bytes trigger since the last idle collection.  Then it:
+//
+// 1. Collects, unless MaybeCollect() just did.
+// 2. Frees the dead objects now rather than lazily in Allocate().
+// 3. Returns free pages to the OS.  In a long interactive session, malloc() can
+//    leave many of them stranded in the middle of the heap, and RSS only grows.
+//    glibc's malloc_trim() releases them with madvise(MADV_DONTNEED).
+//
+// This isn't a compacting collector.  Objects can't move, because the
+// generated code doesn't root 'this' or context managers on the C++ stack.
+// But freeing everything at once gives malloc() the most free space to
+// coalesce before trimming.
+int MarkSweepHeap::IdleCollect() {
+  int64_t allocated = bytes_allocated_ - bytes_allocated_at_idle_;
+  if (!idle_collect_ || allocated == 0 || allocated < bytes_threshold_ / 4) {
+    return -1;
+  }
+
+  int result = num_live_;
+  if (bytes_allocated_ != bytes_allocated_at_gc_) {
+    result = Collect();
+  }
+  EagerFree();
+#ifdef __GLIBC__
+  malloc_trim(0);
+#endif
+
+  bytes_allocated_at_idle_ = bytes_allocated_;
+  num_idle_collections_++;
+  return result;
+}
+
 void MarkSweepHeap::PrintStats(int fd) {
   dprintf(fd, "  num live        = %10d\n", num_live_);
+  dprintf(fd, "bytes live        = %10" PRId64 "\n", bytes_live_);
   // max survived_ can be less than num_live_, because leave off the last GC
   dprintf(fd, "  max survived    = %10d\n", max_survived_);
+  dprintf(fd, "  max live bytes  = %10" PRId64 "\n", max_bytes_survived_);
   dprintf(fd, "\n");
   dprintf(fd, "  num allocated   = %10d\n", num_allocated_);
   dprintf(fd, "bytes allocated   = %10" PRId64 "\n", bytes_allocated_);
   dprintf(fd, "\n");
   dprintf(fd, "  num gc points   = %10d\n", num_gc_points_);
   dprintf(fd, "  num collections = %10d\n", num_collections_);
+  dprintf(fd, "  num idle gcs    = %10d\n", num_idle_collections_);
   dprintf(fd, "\n");
+  dprintf(fd, "   gc percent     = %10d\n", gc_percent_);
   dprintf(fd, "   gc threshold   = %10d\n", gc_threshold_);
+  dprintf(fd, "bytes threshold   = %10" PRId64 "\n", bytes_threshold_);
+  dprintf(fd, "  min heap        = %10" PRId64 "\n", min_heap_bytes_);
+  dprintf(fd, "  memory limit    = %10" PRId64 "\n", memory_limit_);
   dprintf(fd, "  num growths     = %10d\n", num_growths_);
   dprintf(fd, "\n");
   dprintf(fd, "  max gc millis   = %10.1f\n", max_gc_millis_);
@@ -306,8 +429,10 @@ void MarkSweepHeap::PrintStats(int fd) {
 
 void MarkSweepHeap::EagerFree() {
   for (auto obj : to_free_) {
+    free_ids_.push_back(FindObjHeader(obj)->obj_id);
     free(obj);
   }
+  to_free_.clear();
 }
 
 // Cleanup at the end of main() to remain ASAN-safe
@@ -350,6 +475,10 @@ void MarkSweepHeap::DoProcessExit(bool fast_exit) {
   if (stats_fd != -1) {
     PrintStats(stats_fd);
   }
+
+#ifdef ALLOC_LOG
+  gAllocLog.Dump();
+#endif
 }
 
 void MarkSweepHeap::CleanProcessExit() {
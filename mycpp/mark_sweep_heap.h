@@ -84,8 +84,10 @@ class MarkSweepHeap {
     roots_.pop_back();
   }
 
-  void RootGlobalVar(void* root) {
-    global_roots_.push_back(reinterpret_cast<RawObject*>(root));
+  // Takes the address of the global, like PushRoot(), since a copying
+  // collector updates it
+  void RootGlobalVar(RawObject** root) {
+    global_roots_.push_back(root);
   }
 
   void* Allocate(size_t num_bytes);
@@ -100,6 +102,7 @@ class MarkSweepHeap {
 #endif
   int MaybeCollect();
   int Collect();
+  int IdleCollect();
 
   void MaybeMarkAndPush(RawObject* obj);
   void TraceChildren();
@@ -116,35 +119,55 @@ class MarkSweepHeap {
 
   // Runtime params
 
-  // Threshold is a number of live objects, since we aren't keeping track of
-  // total bytes
-  int gc_threshold_;
+  // The pacer sets the next trigger to (1 + gc_percent_ / 100) times what
+  // survived the last collection, like Go's GOGC.  We collect when either the
+  // number of live objects or the number of live bytes passes its trigger.
+
+  int gc_percent_ = 100;             // OIL_GC_PERCENT
+  int min_threshold_;                // OIL_GC_THRESHOLD, in objects
+  int64_t min_heap_bytes_ = MiB(4);  // OIL_GC_MIN_HEAP
+  // Soft limit: the bytes trigger is capped here, unless live bytes alone are
+  // close to it.  0 means no limit.
+  int64_t memory_limit_ = 0;  // OIL_GC_MEMORY_LIMIT
+
+  // Current triggers
+  int gc_threshold_;         // live objects
+  int64_t bytes_threshold_;  // live bytes
 
   // Show debug logging
   bool gc_verbose_ = false;
 
+  // OIL_GC_IDLE=0 turns IdleCollect() into a no-op.  The prompt still calls
+  // MaybeCollect().
+  bool idle_collect_ = true;
+
   // Current stats
   int num_live_ = 0;
-  // Should we keep track of sizes?
-  // int64_t bytes_live_ = 0;
+  int64_t bytes_live_ = 0;
 
   // Cumulative stats
   int max_survived_ = 0;  // max # live after a collection
+  int64_t max_bytes_survived_ = 0;
   int num_allocated_ = 0;
   int64_t bytes_allocated_ = 0;  // avoid overflow
   int num_gc_points_ = 0;        // manual collection points
   int num_collections_ = 0;
-  int num_growths_;
+  int num_growths_ = 0;  // times a trigger was raised
+  int num_idle_collections_ = 0;
   double max_gc_millis_ = 0.0;
   double total_gc_millis_ = 0.0;
 
   std::vector<RawObject**> roots_;
-  std::vector<RawObject*> global_roots_;
+  std::vector<RawObject**> global_roots_;
 
   // Allocate() appends live objects, and Sweep() compacts it
   std::vector<RawObject*> live_objs_;
+  // Parallel to live_objs_, so Sweep() can subtract from bytes_live_
+  std::vector<uint32_t> live_obj_sizes_;
   // Allocate lazily frees these, and Sweep() replenishes it
   std::vector<RawObject*> to_free_;
+  // IDs of objects that EagerFree() freed, for Allocate() to reuse
+  std::vector<int> free_ids_;
 
   std::vector<ObjHeader*> gray_stack_;
   MarkSet mark_set_;
@@ -152,7 +175,13 @@ class MarkSweepHeap {
   int greatest_obj_id_ = 0;
   int obj_id_after_allocate_ = 0;
 
+  // IdleCollect() waits for enough allocation since the last one
+  int64_t bytes_allocated_at_idle_ = 0;
+  // bytes_allocated_ at the last Collect()
+  int64_t bytes_allocated_at_gc_ = -1;
+
  private:
+  void SetTriggers();
   void DoProcessExit(bool fast_exit);
 
   DISALLOW_COPY_AND_ASSIGN(MarkSweepHeap);
@@ -1,5 +1,7 @@
 #include "mycpp/mark_sweep_heap.h"
 
+#include <inttypes.h>  // PRId64
+
 #include "mycpp/gc_alloc.h"  // gHeap
 #include "mycpp/gc_list.h"
 #include "vendor/greatest.h"
@@ -191,6 +193,110 @@ TEST cycle_collection_test() {
   PASS();
 }
 
+TEST idle_collect_test() {
+  Str* s = nullptr;
+  StackRoots _roots({&s});
+
+  s = StrFromC("live");
+  for (int i = 0; i < 100; ++i) {
+    StrFromC("garbage");
+  }
+
+  // Not enough was allocated since the last one
+  int num_idle = gHeap.num_idle_collections_;
+  gHeap.bytes_allocated_at_idle_ = gHeap.bytes_allocated_;
+  StrFromC("garbage");
+  ASSERT_EQ_FMT(-1, gHeap.IdleCollect(), "%d");
+  ASSERT_EQ(num_idle, gHeap.num_idle_collections_);
+
+  gHeap.bytes_allocated_at_idle_ -= gHeap.bytes_threshold_;
+  int num_live = gHeap.IdleCollect();
+  ASSERT(num_live >= 1);
+  ASSERT_EQ(num_idle + 1, gHeap.num_idle_collections_);
+
+  // Dead objects were freed eagerly, and their IDs are reused
+  ASSERT_EQ_FMT(0, static_cast<int>(gHeap.to_free_.size()), "%d");
+  ASSERT(gHeap.free_ids_.size() >= 100);
+
+  int greatest = gHeap.greatest_obj_id_;
+  Str* t = StrFromC("reused");
+  ASSERT(str_equals(t, StrFromC("reused")));
+  ASSERT_EQ(greatest, gHeap.greatest_obj_id_);
+  ASSERT(gHeap.UnusedObjectId() < greatest);
+
+  // Nothing to do if nothing was allocated
+  ASSERT_EQ_FMT(-1, gHeap.IdleCollect(), "%d");
+
+  // If MaybeCollect() just collected, only free and trim
+  gHeap.bytes_allocated_at_idle_ -= gHeap.bytes_threshold_;
+  gHeap.Collect();
+  int num_collections = gHeap.num_collections_;
+  ASSERT(gHeap.IdleCollect() >= 1);
+  ASSERT_EQ(num_collections, gHeap.num_collections_);
+  ASSERT_EQ(num_idle + 2, gHeap.num_idle_collections_);
+
+  ASSERT(str_equals(s, StrFromC("live")));
+
+  PASS();
+}
+
+TEST pacer_test() {
+  int saved_percent = gHeap.gc_percent_;
+  int64_t saved_min_heap = gHeap.min_heap_bytes_;
+
+  List<Str*>* L = nullptr;
+  StackRoots _roots({&L});
+
+  L = NewList<Str*>();
+  for (int i = 0; i < 2000; ++i) {
+    L->append(StrFromC("x"));
+  }
+
+  // The next trigger is proportional to what survived
+  gHeap.gc_percent_ = 50;
+  gHeap.min_heap_bytes_ = 0;
+  int num_live = gHeap.Collect();
+  ASSERT(num_live > 2000);
+  ASSERT_EQ_FMT(num_live * 3 / 2, gHeap.gc_threshold_, "%d");
+  ASSERT(gHeap.bytes_live_ > 2000);
+  ASSERT_EQ_FMT(gHeap.bytes_live_ * 3 / 2, gHeap.bytes_threshold_,
+                "%" PRId64);
+
+  // The minimum heap
+  gHeap.min_heap_bytes_ = MiB(1);
+  gHeap.Collect();
+  ASSERT_EQ_FMT(static_cast<int64_t>(MiB(1)), gHeap.bytes_threshold_,
+                "%" PRId64);
+
+  // The soft memory limit caps the trigger, but leaves headroom
+  gHeap.min_heap_bytes_ = 0;
+  gHeap.memory_limit_ = 100;
+  gHeap.Collect();
+  ASSERT_EQ_FMT(gHeap.bytes_live_ + gHeap.bytes_live_ / 8,
+                gHeap.bytes_threshold_, "%" PRId64);
+  gHeap.memory_limit_ = 0;
+
+  // Dead bytes are subtracted
+  int64_t bytes_before = gHeap.bytes_live_;
+  L = nullptr;
+  gHeap.Collect();
+  ASSERT(gHeap.bytes_live_ < bytes_before);
+  ASSERT(gHeap.max_bytes_survived_ >= bytes_before);
+
+  // One big object triggers a collection, even though there are few objects
+  gHeap.min_heap_bytes_ = KiB(64);
+  gHeap.Collect();
+  ASSERT(gHeap.num_live_ < gHeap.gc_threshold_);
+  NewStr(KiB(128));
+  ASSERT(gHeap.MaybeCollect() != -1);
+
+  gHeap.gc_percent_ = saved_percent;
+  gHeap.min_heap_bytes_ = saved_min_heap;
+  gHeap.Collect();
+
+  PASS();
+}
+
 GREATEST_MAIN_DEFS();
 
 int main(int argc, char **argv) {
@@ -204,6 +310,8 @@ int main(int argc, char **argv) {
   RUN_TEST(string_collection_test);
   RUN_TEST(list_collection_test);
   RUN_TEST(cycle_collection_test);
+  RUN_TEST(idle_collect_test);
+  RUN_TEST(pacer_test);
 
   gHeap.CleanProcessExit();
 
@@ -15,7 +15,7 @@ except ImportError:
   import os
   posix = os
 
-from typing import Tuple, Any
+from typing import Tuple, List, Optional, Any
 
 # For conditional translation
 CPP = False
@@ -30,6 +30,12 @@ def MaybeCollect():
   pass
 
 
+def IdleCollect():
+  # type: () -> None
+  """At the prompt, after MaybeCollect().  Returns memory to the OS."""
+  pass
+
+
 def StrFromC(s):
   """Hack to translate const char* s to Str * in C++."""
   return s
@@ -132,6 +138,89 @@ def split_once(s, delim):
     return parts[0], parts[1]
 
 
+def Intern(s):
+  # type: (str) -> str
+  """Returns the canonical string equal to s, so equal names share one object.
+
+  For identifiers from the lexer.  See Intern() in mycpp/gc_mylib.h.
+  """
+  return intern(s)
+
+
+# The last string passed to Utf8CharCount() or Utf8CharOffset(), its number of
+# chars, and the offset of each char (None for ASCII)
+_utf8_index = (None, 0, None)  # type: Tuple[Optional[str], int, Optional[List[int]]]
+
+
+def _Utf8Index(s):
+  # type: (str) -> Tuple[Optional[str], int, Optional[List[int]]]
+  global _utf8_index
+  if _utf8_index[0] is s:
+    return _utf8_index
+
+  try:
+    s.decode('ascii')
+    offsets = None  # type: Optional[List[int]]
+    num_chars = len(s)
+  except UnicodeDecodeError:
+    offsets = []
+    num_chars = 0
+    n = len(s)
+    i = 0
+    while i < n:
+      b = ord(s[i])
+      if b < 0x80:
+        char_len = 1
+      elif (b >> 5) == 0b110:
+        char_len = 2
+      elif (b >> 4) == 0b1110:
+        char_len = 3
+      elif (b >> 3) == 0b11110:
+        char_len = 4
+      else:
+        num_chars = -1
+        break
+      if i + char_len > n:
+        num_chars = -1
+        break
+      for j in xrange(i + 1, i + char_len):
+        if (ord(s[j]) >> 6) != 0b10:
+          num_chars = -1
+          break
+      if num_chars == -1:
+        break
+      offsets.append(i)
+      num_chars += 1
+      i += char_len
+
+  _utf8_index = (s, num_chars, offsets)
+  return _utf8_index
+
+
+def Utf8CharCount(s):
+  # type: (str) -> int
+  """Returns the number of UTF-8 chars in s, or -1 if it isn't valid.
+
+  See Utf8CharCount() in mycpp/gc_mylib.h.
+  """
+  return _Utf8Index(s)[1]
+
+
+def Utf8CharOffset(s, i):
+  # type: (str, int) -> int
+  """Returns the byte offset of char i of s, or len(s) if there are fewer.
+
+  s must be valid UTF-8.
+  """
+  _, num_chars, offsets = _Utf8Index(s)
+  assert num_chars != -1, s
+  if i >= num_chars:
+    return len(s)
+  if offsets is None:
+    return i  # ASCII
+  return offsets[i]
+
+
 def hex_lower(i):
   # type: (int) -> str
   return '%x' % i
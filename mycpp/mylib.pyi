@@ -75,6 +75,11 @@ def iteritems(d: Dict[K, V]) -> Iterator[Tuple[K, V]]: ...
 
 def split_once(s: str, delim: str) -> Tuple[str, str]: ...
 
+def Intern(s: str) -> str: ...
+
+def Utf8CharCount(s: str) -> int: ...
+def Utf8CharOffset(s: str, i: int) -> int: ...
+
 def hex_lower(i: int) -> str: ...
 def hex_upper(i: int) -> str: ...
 def octal(i: int) -> str: ...
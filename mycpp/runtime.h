@@ -11,7 +11,9 @@
 // Python-like compound data structures
 #include "mycpp/gc_tuple.h"
 #include "mycpp/gc_list.h"
+#include "mycpp/gc_deque.h"
 #include "mycpp/gc_dict.h"
+#include "mycpp/gc_generator.h"  // translated Python generators
 
 #include "mycpp/gc_mylib.h"  // Python-like file I/O, etc.
 
@@ -146,6 +146,29 @@ class ArithTest(unittest.TestCase):
     testEvalExpr('64#@', 62)
     testEvalExpr('64#_', 63)
 
+  def testFormatInt(self):
+    arena = test_lib.MakeArena('<arith_parse_test.py>')
+    mem = state.Mem('', [], arena, [])
+    parse_opts, exec_opts, mutable_opts = state.MakeOpts(mem, None)
+    arith_ev = sh_expr_eval.ArithEvaluator(mem, exec_opts, None, None)
+
+    s = arith_ev.FormatInt(42)
+    self.assertEqual('42', s)
+    # The same string is reused
+    self.assertTrue(s is arith_ev.FormatInt(42))
+    self.assertEqual(42, arith_ev._StringToInteger(s))
+
+    # An equal string converts to the same integer
+    self.assertEqual(42, arith_ev._StringToInteger(''.join(['4', '2'])))
+    # Octal
+    self.assertEqual(34, arith_ev._StringToInteger('042'))
+
+    # Older entries are evicted
+    for i in xrange(sh_expr_eval.INT_CACHE_SIZE):
+      arith_ev.FormatInt(-i - 1)
+    self.assertFalse(s is arith_ev.FormatInt(42))
+    self.assertEqual(42, arith_ev._StringToInteger(s))
+
   def testErrors(self):
     # Now try some bad ones
 
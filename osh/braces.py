@@ -25,9 +25,8 @@ from _devbuild.gen.syntax_asdl import (
 from core.pyerror import log, p_die
 from frontend import lexer
 from frontend import match
-from mycpp.mylib import tagswitch
 
-from typing import List, Optional, cast, TYPE_CHECKING
+from typing import List, Iterator, Optional, cast, TYPE_CHECKING
 if TYPE_CHECKING:
   from frontend.match import SimpleLexer
 
@@ -336,12 +335,11 @@ def _IntToString(i, width):
     return s
 
 
-def _RangeStrings(part):
-  # type: (word_part__BracedRange) -> List[str]
+def RangeIter(part):
+  # type: (word_part__BracedRange) -> Iterator[str]
+  """Yields the strings of a range like {1..10..2} or {a..z}, one at a time."""
 
   if part.kind == Id.Range_Int:
-    nums = []  # type: List[str]
-
     z1 = _LeadingZeros(part.start)
     z2 = _LeadingZeros(part.end)
 
@@ -358,145 +356,146 @@ def _RangeStrings(part):
     step = part.step
     if step > 0:
       while True:
-        nums.append(_IntToString(n, width))
+        yield _IntToString(n, width)
         n += step
         if n > end:
           break
     else:
       while True:
-        nums.append(_IntToString(n, width))
+        yield _IntToString(n, width)
         n += step
         if n < end:
           break
 
-    return nums
-
   else:  # Id.Range_Char
-    chars = []  # type: List[str]
-
     n = ord(part.start)
     ord_end = ord(part.end)
     step = part.step
     if step > 0:
       while True:
-        chars.append(chr(n))
+        yield chr(n)
         n += step
         if n > ord_end:
           break
     else:
       while True:
-        chars.append(chr(n))
+        yield chr(n)
         n += step
         if n < ord_end:
           break
 
-    return chars
 
-
-def _ExpandPart(parts,  # type: List[word_part_t]
-                first_alt_index,  # type: int
-                suffixes,  # type: List[List[word_part_t]]
-                ):
-  # type: (...) -> List[List[word_part_t]]
+def _ExpandPart(parts, first_alt_index):
+  # type: (List[word_part_t], int) -> Iterator[List[word_part_t]]
   """Mutually recursive with _BraceExpand.
 
   Args:
     parts: input parts
-    first_alt_index: index of the first BracedTuple
-    suffixes: List of suffixes to append.
+    first_alt_index: index of the first BracedTuple or BracedRange
   """
-  out = []  # type: List[List[word_part_t]]
-
   prefix = parts[ : first_alt_index]
   expand_part = parts[first_alt_index]
+  tail = parts[first_alt_index+1 : ]
 
+  # Not a tagswitch, since a generator can't yield inside a 'with' block
   UP_part = expand_part
-  with tagswitch(expand_part) as case:
-    if case(word_part_e.BracedTuple):
-      expand_part = cast(word_part__BracedTuple, UP_part)
-      # Call _BraceExpand on each of the inner words too!
-      expanded_alts = []  # type: List[List[word_part_t]]
-      for w in expand_part.words:
-        expanded_alts.extend(_BraceExpand(w.parts))
-
-      for alt_parts in expanded_alts:
-        for suffix in suffixes:
+  if expand_part.tag_() == word_part_e.BracedTuple:
+    tuple_part = cast(word_part__BracedTuple, UP_part)
+    # Call _BraceExpand on each of the inner words too!
+    for w in tuple_part.words:
+      for alt_parts in _BraceExpand(w.parts):
+        # The suffixes are expanded again for each alternative, rather than
+        # saved in a list.
+        for suffix in _BraceExpand(tail):
           out_parts = []  # type: List[word_part_t]
           out_parts.extend(prefix)
           out_parts.extend(alt_parts)
           out_parts.extend(suffix)
-          out.append(out_parts)
+          yield out_parts
+
+  elif expand_part.tag_() == word_part_e.BracedRange:
+    range_part = cast(word_part__BracedRange, UP_part)
+    # Not mutually recursive with _BraceExpand
+    for s in RangeIter(range_part):
+      # TODO: Does it help to preserve location info?
+      # t = Token(Id.Lit_Chars, expand_part.spids[0], s)
+      t = lexer.DummyToken(Id.Lit_Chars, s)
+
+      for suffix in _BraceExpand(tail):
+        out_parts_ = []  # type: List[word_part_t]
+        out_parts_.extend(prefix)
+        out_parts_.append(t)
+        out_parts_.extend(suffix)
+        yield out_parts_
 
-    elif case(word_part_e.BracedRange):
-      expand_part = cast(word_part__BracedRange, UP_part)
-      # Not mutually recursive with _BraceExpand
-      strs = _RangeStrings(expand_part)
-      for s in strs:
-        for suffix in suffixes:
-          out_parts_ = []  # type: List[word_part_t]
-          out_parts_.extend(prefix)
-
-          # TODO: Does it help to preserve location info?
-          # t = Token(Id.Lit_Chars, expand_part.spids[0], s)
-          t = lexer.DummyToken(Id.Lit_Chars, s)
-
-          out_parts_.append(t)
-          out_parts_.extend(suffix)
-          out.append(out_parts_)
-
-    else:
-      raise AssertionError()
-
-  return out
+  else:
+    raise AssertionError()
 
 
 def _BraceExpand(parts):
-  # type: (List[word_part_t]) -> List[List[word_part_t]]
-  """Mutually recursive with _ExpandPart."""
-  num_alts = 0
+  # type: (List[word_part_t]) -> Iterator[List[word_part_t]]
+  """Mutually recursive with _ExpandPart.
+
+  Yields the parts of each word, so {a..z}{a..z}{0..99} is expanded one word
+  at a time, rather than as a list of 67,600 words.
+  """
   first_alt_index = -1
   for i, part in enumerate(parts):
     tag = part.tag_()
     if tag in (word_part_e.BracedTuple, word_part_e.BracedRange):
-      num_alts += 1
-      if num_alts == 1:
-        first_alt_index = i
-      elif num_alts == 2:
-        break  # don't need to count anymore
+      first_alt_index = i
+      break
 
-  # NOTE: There are TWO recursive calls here, not just one -- one for
-  # nested {}, and one for adjacent {}.  This is hard to do iteratively.
-  if num_alts == 0:
-    return [parts]
+  # NOTE: There are TWO recursive calls, not just one -- one for nested {},
+  # and one for adjacent {}.  This is hard to do iteratively.
+  if first_alt_index == -1:
+    yield parts
+  else:
+    for out_parts in _ExpandPart(parts, first_alt_index):
+      yield out_parts
 
-  elif num_alts == 1:
-    suffix = parts[first_alt_index+1 : ]
-    return _ExpandPart(parts, first_alt_index, [suffix])
 
-  else:
-    # Now call it on the tail
-    tail_parts = parts[first_alt_index+1 : ]
-    suffixes = _BraceExpand(tail_parts)  # recursive call
-    return _ExpandPart(parts, first_alt_index, suffixes)
+def PureRange(words):
+  # type: (List[word_t]) -> Optional[word_part__BracedRange]
+  """If the words are a single range like {1..1000000}, return it.
 
+  A for loop over it doesn't need to expand it up front.
+  """
+  if len(words) != 1:
+    return None
 
-def BraceExpandWords(words):
-  # type: (List[word_t]) -> List[compound_word]
-  out = []  # type: List[compound_word]
+  w = words[0]
+  UP_w = w
+  if w.tag_() != word_e.BracedTree:
+    return None
+  w = cast(word__BracedTree, UP_w)
+
+  if len(w.parts) != 1:
+    return None
+
+  part = w.parts[0]
+  UP_part = part
+  if part.tag_() != word_part_e.BracedRange:
+    return None
+  return cast(word_part__BracedRange, UP_part)
+
+
+def BraceExpandIter(words):
+  # type: (List[word_t]) -> Iterator[compound_word]
   for w in words:
     UP_w = w
-    with tagswitch(w) as case:
-      if case(word_e.BracedTree):
-        w = cast(word__BracedTree, UP_w)
-        parts_list = _BraceExpand(w.parts)
-        tmp = [compound_word(p) for p in parts_list]
-        out.extend(tmp)
+    if w.tag_() == word_e.BracedTree:
+      tree = cast(word__BracedTree, UP_w)
+      for parts in _BraceExpand(tree.parts):
+        yield compound_word(parts)
 
-      elif case(word_e.Compound):
-        w = cast(compound_word, UP_w)
-        out.append(w)
+    elif w.tag_() == word_e.Compound:
+      yield cast(compound_word, UP_w)
 
-      else:
-        raise AssertionError(w.tag_())
+    else:
+      raise AssertionError(w.tag_())
 
-  return out
+
+def BraceExpandWords(words):
+  # type: (List[word_t]) -> List[compound_word]
+  return list(BraceExpandIter(words))
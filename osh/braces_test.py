@@ -143,7 +143,7 @@ class BracesTest(unittest.TestCase):
 
   def testBraceExpand(self):
     w = _assertReadWord(self, 'hi')
-    results = braces._BraceExpand(w.parts)
+    results = list(braces._BraceExpand(w.parts))
     self.assertEqual(1, len(results))
     for parts in results:
       _PrettyPrint(compound_word(parts))
@@ -154,7 +154,7 @@ class BracesTest(unittest.TestCase):
     self.assertEqual(3, len(tree.parts))
     _PrettyPrint(tree)
 
-    results = braces._BraceExpand(tree.parts)
+    results = list(braces._BraceExpand(tree.parts))
     self.assertEqual(2, len(results))
     for parts in results:
       _PrettyPrint(compound_word(parts))
@@ -165,7 +165,7 @@ class BracesTest(unittest.TestCase):
     self.assertEqual(3, len(tree.parts))
     _PrettyPrint(tree)
 
-    results = braces._BraceExpand(tree.parts)
+    results = list(braces._BraceExpand(tree.parts))
     self.assertEqual(5, len(results))
     for parts in results:
       _PrettyPrint(compound_word(parts))
@@ -176,12 +176,41 @@ class BracesTest(unittest.TestCase):
     self.assertEqual(5, len(tree.parts))
     _PrettyPrint(tree)
 
-    results = braces._BraceExpand(tree.parts)
+    results = list(braces._BraceExpand(tree.parts))
     self.assertEqual(4, len(results))
     for parts in results:
       _PrettyPrint(compound_word(parts))
       print('')
 
+  def testPureRange(self):
+    w = _assertReadWord(self, '{1..1000000}')
+    tree = braces._BraceDetect(w)
+    part = braces.PureRange([tree])
+    self.assertNotEqual(None, part)
+
+    # Iterating doesn't expand the whole range
+    it = braces.RangeIter(part)
+    self.assertEqual('1', it.next())
+    self.assertEqual('2', it.next())
+
+    w = _assertReadWord(self, '{08..12..2}')
+    tree = braces._BraceDetect(w)
+    part = braces.PureRange([tree])
+    self.assertEqual(['08', '10', '12'], list(braces.RangeIter(part)))
+
+    # Not a pure range
+    for s in ['x{1..3}', '{1..3}{a,b}', '{a,b}']:
+      w = _assertReadWord(self, s)
+      tree = braces._BraceDetect(w)
+      self.assertEqual(None, braces.PureRange([tree]))
+    self.assertEqual(None, braces.PureRange([w, w]))
+
+    # Adjacent ranges are expanded one word at a time
+    w = _assertReadWord(self, '{a..z}{a..z}{0..99}')
+    tree = braces._BraceDetect(w)
+    it = braces._BraceExpand(tree.parts)
+    self.assertEqual(3, len(it.next()))
+
 
 if __name__ == '__main__':
   unittest.main()
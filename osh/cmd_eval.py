@@ -39,6 +39,7 @@ from _devbuild.gen.syntax_asdl import (
     redir_param_e, redir_param__HereDoc, proc_sig,
     for_iter_e, for_iter__Words, for_iter__Oil,
     Token, loc,
+    word_part__BracedRange,
 )
 from _devbuild.gen.runtime_asdl import (
     lvalue, lvalue_e, lvalue__ObjIndex, lvalue__ObjAttr,
@@ -71,7 +72,7 @@ from mycpp.mylib import switch, tagswitch
 import posix_ as posix
 import libc  # for fnmatch
 
-from typing import List, Dict, Tuple, Any, cast, TYPE_CHECKING
+from typing import List, Dict, Tuple, Iterator, Any, cast, TYPE_CHECKING
 
 if TYPE_CHECKING:
   from _devbuild.gen.id_kind_asdl import Id_t
@@ -108,6 +109,21 @@ OIL_TYPE_NAMES = {
 }
 
 
+def _ForEachStrs(iter_list, iter_range):
+  # type: (List[str], word_part__BracedRange) -> Iterator[str]
+  """Yields the strings that a shell-style for loop iterates over.
+
+  'for i in {1..1000000}' produces each string as the loop gets to it, instead
+  of making a list of a million strings up front.
+  """
+  if iter_range is None:
+    for s in iter_list:
+      yield s
+  else:
+    for s in braces.RangeIter(iter_range):
+      yield s
+
+
 class Deps(object):
   def __init__(self):
     # type: () -> None
@@ -291,6 +307,16 @@ class CommandEvaluator(object):
     self.loop_level = 0  # for detecting bad top-level break/continue
     self.check_command_sub_status = False  # a hack.  Modified by ShellExecutor
 
+    # break, continue, and return don't raise vm.ControlFlow.  Executing one
+    # sets cflow_pending, and every compound command stops and returns until a
+    # loop or function consumes it.  Unwinding with C++ exceptions is slow, and
+    # shell functions commonly 'return' from inside loops.
+    #
+    # vm.ControlFlow is only raised across the eval and source builtins, and
+    # _Execute() turns it back into a pending one.
+    self.cflow = vm.ControlFlow(None, 0)  # preallocated, mutated
+    self.cflow_pending = False
+
   def CheckCircularDeps(self):
     # type: () -> None
     assert self.arith_ev is not None
@@ -551,7 +577,11 @@ class CommandEvaluator(object):
       if case(cmd_value_e.Argv):
         cmd_val = cast(cmd_value__Argv, UP_cmd_val)
         self.tracer.OnSimpleCommand(cmd_val.argv)
-        return self.shell_ex.RunSimpleCommand(cmd_val, cmd_st, do_fork)
+        span_id = self.tracer.ProfileBegin(cmd_val.argv)
+        with dev.ctx_Profile(self.tracer, span_id):
+          status = self.shell_ex.RunSimpleCommand(cmd_val, cmd_st, do_fork)
+          self.tracer.ProfileEnd(span_id, status)
+        return status
 
       elif case(cmd_value_e.Assign):
         cmd_val = cast(cmd_value__Assign, UP_cmd_val)
@@ -1040,7 +1070,10 @@ class CommandEvaluator(object):
           if tok.id == Id.ControlFlow_Exit:
             raise util.UserExit(arg)  # handled differently than other control flow
           else:
-            raise vm.ControlFlow(tok, arg)
+            self.cflow.token = tok
+            self.cflow.arg = arg
+            self.cflow_pending = True
+            status = 0  # ignored by the caller
         else:
           msg = 'Invalid control flow at top level'
           if self.exec_opts.strict_control_flow():
@@ -1083,6 +1116,9 @@ class CommandEvaluator(object):
         i = 1
         n = len(node.children)
         while i < n:
+          if self.cflow_pending:
+            break
+
           #log('i %d status %d', i, status)
           child = node.children[i]
           op_id = node.ops[i-1]
@@ -1114,22 +1150,19 @@ class CommandEvaluator(object):
 
         with ctx_LoopLevel(self):
           while True:
-            try:
-              # blame while/until spid
-              b = self._EvalCondition(node.cond, node.spids[0])
+            # blame while/until spid
+            b = self._EvalCondition(node.cond, node.spids[0])
+            if not self.cflow_pending:
               if node.keyword.id == Id.KW_Until:
                 b = not b
               if not b:
                 break
               status = self._Execute(node.body)  # last one wins
 
-            except vm.ControlFlow as e:
+            if self.cflow_pending:
               status = 0
-              action = e.HandleLoop()
-              if action == flow_e.Break:
+              if self._LoopFlow():
                 break
-              elif action == flow_e.Raise:
-                raise
 
       elif case(command_e.ForEach):
         node = cast(command__ForEach, UP_node)
@@ -1137,6 +1170,8 @@ class CommandEvaluator(object):
 
         # for the 2 kinds of shell loop
         iter_list = None  # type: List[str]  
+        # for i in {1..n}, which isn't expanded up front
+        iter_range = None  # type: word_part__BracedRange
 
         # for Oil loop
         iter_expr = None  # type: expr_t
@@ -1151,8 +1186,12 @@ class CommandEvaluator(object):
 
           elif case(for_iter_e.Words):
             iterable = cast(for_iter__Words, UP_iterable)
-            words = braces.BraceExpandWords(iterable.words)
-            iter_list = self.word_ev.EvalWordSequence(words)
+            # The strings of a range are literals, so they aren't split or
+            # globbed, and they can be produced lazily.
+            iter_range = braces.PureRange(iterable.words)
+            if iter_range is None:
+              words = braces.BraceExpandWords(iterable.words)
+              iter_list = self.word_ev.EvalWordSequence(words)
 
           elif case(for_iter_e.Oil):
             iterable = cast(for_iter__Oil, UP_iterable)
@@ -1161,7 +1200,7 @@ class CommandEvaluator(object):
 
         status = 0  # in case we don't loop
 
-        if iter_list is None:  # for_expr.Oil
+        if iter_list is None and iter_range is None:  # for_expr.Oil
           if mylib.PYTHON:
             obj = self.expr_ev.EvalExpr(iter_expr)
 
@@ -1191,15 +1230,11 @@ class CommandEvaluator(object):
                   self.mem.SetValue(val_name, value.Obj(item),
                                     scope_e.LocalOnly)
 
-                  try:
-                    status = self._Execute(node.body)  # last one wins
-                  except vm.ControlFlow as e:
+                  status = self._Execute(node.body)  # last one wins
+                  if self.cflow_pending:
                     status = 0
-                    action = e.HandleLoop()
-                    if action == flow_e.Break:
+                    if self._LoopFlow():
                       break
-                    elif action == flow_e.Raise:
-                      raise
                   index += 1
 
               elif isinstance(obj, dict):
@@ -1234,15 +1269,11 @@ class CommandEvaluator(object):
                     self.mem.SetValue(i_name, value.Obj(index),
                                       scope_e.LocalOnly)
 
-                  try:
-                    status = self._Execute(node.body)  # last one wins
-                  except vm.ControlFlow as e:
+                  status = self._Execute(node.body)  # last one wins
+                  if self.cflow_pending:
                     status = 0
-                    action = e.HandleLoop()
-                    if action == flow_e.Break:
+                    if self._LoopFlow():
                       break
-                    elif action == flow_e.Raise:
-                      raise
 
                   index += 1
 
@@ -1266,7 +1297,7 @@ class CommandEvaluator(object):
                            loc.Span(node.spids[0]))
 
             index = 0
-            for x in iter_list:
+            for x in _ForEachStrs(iter_list, iter_range):
               #log('> ForEach setting %r', x)
               if mylib.PYTHON:
                 # value.Obj not available in C++
@@ -1277,15 +1308,11 @@ class CommandEvaluator(object):
                                 scope_e.LocalOnly)
               #log('<')
 
-              try:
-                status = self._Execute(node.body)  # last one wins
-              except vm.ControlFlow as e:
+              status = self._Execute(node.body)  # last one wins
+              if self.cflow_pending:
                 status = 0
-                action = e.HandleLoop()
-                if action == flow_e.Break:
+                if self._LoopFlow():
                   break
-                elif action == flow_e.Raise:
-                  raise
               index += 1
 
       elif case(command_e.ForExpr):
@@ -1308,15 +1335,11 @@ class CommandEvaluator(object):
               if cond_int == 0:  # false
                 break
 
-            try:
-              status = self._Execute(body)
-            except vm.ControlFlow as e:
+            status = self._Execute(body)
+            if self.cflow_pending:
               status = 0
-              action = e.HandleLoop()
-              if action == flow_e.Break:
+              if self._LoopFlow():
                 break
-              elif action == flow_e.Raise:
-                raise
 
             if update:
               self.arith_ev.Eval(update)
@@ -1361,6 +1384,10 @@ class CommandEvaluator(object):
         done = False
         for if_arm in node.arms:
           b = self._EvalCondition(if_arm.cond, if_arm.spids[0])
+          if self.cflow_pending:
+            status = 0  # ignored by the caller
+            done = True
+            break
           if b:
             status = self._ExecuteList(if_arm.action)
             done = True
@@ -1433,6 +1460,8 @@ class CommandEvaluator(object):
             # Trace it.  TODO: Show the trap kind too
             with dev.ctx_Tracer(self.tracer, 'trap', None):
               self._Execute(trap_node)
+          if self.cflow_pending:
+            break
 
   def _Execute(self, node):
     # type: (command_t) -> int
@@ -1444,6 +1473,8 @@ class CommandEvaluator(object):
     # call self.DoTick()?  That will RunPendingTraps and check the Ctrl-C flag,
     # and maybe throw an exception.
     self.RunPendingTraps()
+    if self.cflow_pending:  # e.g. 'return' in a trap
+      return 0
 
     # Manual GC point before every statement
     mylib.MaybeCollect()
@@ -1482,6 +1513,16 @@ class CommandEvaluator(object):
               self.errfmt.PrettyPrintError(e, prefix='failglob: ')
               status = 1
               check_errexit = True
+            except vm.ControlFlow as e:
+              # From the eval and source builtins.  Make it pending again.
+              self.cflow.token = e.token
+              self.cflow.arg = e.arg
+              self.cflow_pending = True
+              status = 0  # ignored by the caller
+
+          # Control flow has no status, and isn't checked for errexit
+          if self.cflow_pending:
+            return status
 
           # Compute status from @PIPESTATUS
           codes = cmd_st.pipe_status
@@ -1527,7 +1568,7 @@ class CommandEvaluator(object):
     # - function def (however this always exits 0 anyway)
     # - assignment - its result should be the result of the RHS?
     #   - e.g. arith sub, command sub?  I don't want arith sub.
-    # - ControlFlow: always raises, it has no status.
+    # - ControlFlow: returned early above, it has no status.
     if check_errexit:
       #log('cmd_st %s', cmd_st)
       self._CheckStatus(status, cmd_st, node, errexit_spid)
@@ -1540,8 +1581,33 @@ class CommandEvaluator(object):
     for child in children:
       # last status wins
       status = self._Execute(child)
+      if self.cflow_pending:
+        break
     return status
 
+  def _LoopFlow(self):
+    # type: () -> bool
+    """Handle a pending break or continue after a loop body or condition.
+
+    Returns whether the loop should stop.  'return', 'break 2', etc. are left
+    pending for the enclosing function or loop.
+    """
+    action = self.cflow.HandleLoop()
+    if action == flow_e.Raise:
+      return True
+    self.cflow_pending = False
+    return action == flow_e.Break
+
+  def _TakeReturn(self, what):
+    # type: (str) -> int
+    """Consume a pending 'return' at a function or block boundary."""
+    self.cflow_pending = False
+    if not self.cflow.IsReturn():
+      # break/continue used in the wrong place.
+      e_die('Unexpected %r (%s)' % (self.cflow.token.val, what),
+            self.cflow.token)
+    return self.cflow.StatusCode()
+
   def LastStatus(self):
     # type: () -> int
     """For main_loop.py to determine the exit code of the shell itself."""
@@ -1637,33 +1703,39 @@ class CommandEvaluator(object):
 
     try:
       status = self._Execute(node)
-    except vm.ControlFlow as e:
-      if cmd_flags & RaiseControlFlow:
-        raise  # 'eval break' and 'source return.sh', etc.
-      else:
-        # Return at top level is OK, unlike in bash.
-        if e.IsReturn():
-          is_return = True
-          status = e.StatusCode()
+      if self.cflow_pending:
+        self.cflow_pending = False
+        if cmd_flags & RaiseControlFlow:
+          # 'eval break' and 'source return.sh', etc.  This is the only place
+          # we raise, since the control flow crosses a builtin.
+          raise vm.ControlFlow(self.cflow.token, self.cflow.arg)
         else:
-          # TODO: This error message is invalid.  Can also happen in eval.
-          # We need a flag.
-
-          # Invalid control flow
-          self.errfmt.Print_(
-              "Loop and control flow can't be in different processes",
-              span_id=e.token.span_id)
-          is_fatal = True
-          # All shells exit 0 here.  It could be hidden behind
-          # strict_control_flow if the incompatibility causes problems.
-          status = 1
+          # Return at top level is OK, unlike in bash.
+          if self.cflow.IsReturn():
+            is_return = True
+            status = self.cflow.StatusCode()
+          else:
+            # TODO: This error message is invalid.  Can also happen in eval.
+            # We need a flag.
+
+            # Invalid control flow
+            self.errfmt.Print_(
+                "Loop and control flow can't be in different processes",
+                span_id=self.cflow.token.span_id)
+            is_fatal = True
+            # All shells exit 0 here.  It could be hidden behind
+            # strict_control_flow if the incompatibility causes problems.
+            status = 1
     except error.Parse as e:
+      self.cflow_pending = False
       self.dumper.MaybeRecord(self, e)  # Do this before unwinding stack
       raise
     except error.ErrExit as e:
+      self.cflow_pending = False
       err = e
       is_errexit = True
     except error.FatalRuntime as e:
+      self.cflow_pending = False
       err = e
 
     if err:
@@ -1783,12 +1855,8 @@ class CommandEvaluator(object):
       # Here doc causes a pipe and Process(SubProgramThunk).
       try:
         status = self._Execute(proc.body)
-      except vm.ControlFlow as e:
-        if e.IsReturn():
-          status = e.StatusCode()
-        else:
-          # break/continue used in the wrong place.
-          e_die('Unexpected %r (in function call)' % e.token.val, e.token)
+        if self.cflow_pending:
+          status = self._TakeReturn('in function call')
       except error.FatalRuntime as e:
         # Dump the stack before unwinding it
         self.dumper.MaybeRecord(self, e)
@@ -1810,14 +1878,10 @@ class CommandEvaluator(object):
     """
     status = 0
     namespace_ = None  # type: Dict[str, cell]
-    try:
-      self._Execute(block)  # can raise FatalRuntimeError, etc.
-    except vm.ControlFlow as e:  # A block is more like a function.
+    self._Execute(block)  # can raise FatalRuntimeError, etc.
+    if self.cflow_pending:  # A block is more like a function.
       # return in a block
-      if e.IsReturn():
-        status = e.StatusCode()
-      else:
-        e_die('Unexpected control flow in block', e.token)
+      status = self._TakeReturn('in block')
 
     namespace_ = self.mem.TopNamespace()
 
@@ -47,6 +47,7 @@ from core.pyerror import log, p_die
 from frontend import consts
 from frontend import match
 from frontend import reader
+from mycpp import mylib
 from osh import braces
 from osh import bool_parse
 from osh import word_
@@ -196,6 +197,8 @@ def _MakeAssignPair(parse_ctx, preparsed, arena):
     else:
       var_name = left_token.val[:-1]
       op = assign_op_e.Equal
+    # Share the string with VSub_Name tokens, like ${s}
+    var_name = mylib.Intern(var_name)
 
     tmp = sh_lhs_expr.Name(left_token, var_name)
 
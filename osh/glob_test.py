@@ -112,52 +112,6 @@ class GlobParserTest(unittest.TestCase):
     print(_ReadTokens(r'[[:alpha:]]'))
     print(_ReadTokens(r'[?]'))
 
-  def testGlobParser(self):
-    CASES = [
-        # (glob input, expected AST, expected extended regexp, has error)
-        ('*.py', r'.*\.py', False),
-        ('*.?', r'.*\..', False),
-        ('<*>', r'<.*>', False),
-        ('\**+', r'\*.*\+', False),
-        ('\**', r'\*.*', False),
-        ('*.[ch]pp', r'.*\.[ch]pp', False),
-
-        # not globs
-        ('abc', 'abc', False),
-        ('\\*', '\\*', False),
-        ('c:\\foo', 'c:foo', False),
-        ('strange]one', 'strange\\]one', False),
-
-        # character class globs
-        ('[[:space:]abc]', '[[:space:]abc]', False),
-        ('[abc]', '[abc]', False),
-        (r'[\a\b\c]', r'[\a\b\c]', False),
-        ('[abc\[]', r'[abc\[]', False),
-        ('[!not]', '[^not]', False),
-        ('[^also_not]', '[^also_not]', False),
-        ('[!*?!\\[]', '[^*?!\\[]', False),
-        ('[!\]foo]', r'[^]foo]', False),
-
-        # invalid globs
-        ('not_closed[a-z', 'not_closed\\[a-z', True),
-        ('[[:spa[ce:]]', '\\[\\[:spa\\[ce:\\]\\]', True),
-
-        # Regression test for IndexError.
-        ('[', '\\[', True),
-        ('\\', '\\\\', True),
-        (']', '\\]', False),
-    ]
-    for glob, expected_ere, expected_err in CASES:
-      print('===')
-      print(glob)
-      regex, warnings = glob_.GlobToERE(glob)
-      self.assertEqual(
-          expected_ere, regex,
-          'Expected %r to translate to %r, got %r' % (glob, expected_ere, regex))
-
-      print('regex   : %s' % regex)
-      print('warnings: %s' % warnings)
-
 
 if __name__ == '__main__':
   unittest.main()
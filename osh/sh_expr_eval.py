@@ -49,7 +49,7 @@ from osh import word_eval
 
 import libc  # for fnmatch
 
-from typing import Tuple, Optional, cast, TYPE_CHECKING
+from typing import List, Tuple, Optional, cast, TYPE_CHECKING
 if TYPE_CHECKING:
   from core.ui import ErrorFormatter
   from core import optview
@@ -57,6 +57,9 @@ if TYPE_CHECKING:
 
 _ = log
 
+# Number of recently formatted integers that ArithEvaluator remembers
+INT_CACHE_SIZE = 8
+
 
 #
 # Arith and Command/Word variants of assignment
@@ -275,10 +278,34 @@ class ArithEvaluator(object):
     self.parse_ctx = parse_ctx
     self.errfmt = errfmt
 
+    # Strings that FormatInt() recently returned, and their integers.  Shell
+    # variables are strings, so i=$(( i + 1 )) would otherwise parse '41' and
+    # format 42 on every iteration.  Any string equal to str(i) converts back
+    # to i, so entries are never stale, even after the string is copied to
+    # other variables.
+    self.int_strs = ['0'] * INT_CACHE_SIZE  # type: List[str]
+    self.int_vals = [0] * INT_CACHE_SIZE  # type: List[int]
+    self.int_next = 0
+
   def CheckCircularDeps(self):
     # type: () -> None
     assert self.word_ev is not None
 
+  def FormatInt(self, i):
+    # type: (int) -> str
+    """Like str(i), but returns a string that can be converted back quickly.
+
+    Used for $(( )) and for stores like (( i++ )).
+    """
+    if i in self.int_vals:
+      return self.int_strs[self.int_vals.index(i)]  # no allocation
+
+    s = str(i)
+    self.int_strs[self.int_next] = s
+    self.int_vals[self.int_next] = i
+    self.int_next = (self.int_next + 1) % INT_CACHE_SIZE
+    return s
+
   def _StringToInteger(self, s, span_id=runtime.NO_SPID):
     # type: (str, int) -> int
     """Use bash-like rules to coerce a string to an integer.
@@ -293,6 +320,9 @@ class ArithEvaluator(object):
     bare word: variable
     quoted word: string (not done?)
     """
+    if s in self.int_strs:
+      return self.int_vals[self.int_strs.index(s)]
+
     if s.startswith('0x'):
       try:
         integer = int(s, 16)
@@ -440,16 +470,12 @@ class ArithEvaluator(object):
 
   def _Store(self, lval, new_int):
     # type: (lvalue_t, int) -> None
-    val = value.Str(str(new_int))
+    val = value.Str(self.FormatInt(new_int))
     state.OshLanguageSetValue(self.mem, lval, val)
 
-  def EvalToInt(self, node):
-    # type: (arith_expr_t) -> int
-    """Used externally by ${a[i+1]} and ${a:start:len}.
-
-    Also used internally.
-    """
-    val = self.Eval(node)
+  def _ValToInt(self, val, node):
+    # type: (value_t, arith_expr_t) -> int
+    """Convert the value of a VarRef, Word, a[i], or x ? y : z to an integer."""
 
     # BASH_LINENO, arr (array name with shopt -s compat_array), etc.
     if val.tag_() in (value_e.MaybeStrArray, value_e.AssocArray) and node.tag_() == arith_expr_e.VarRef:
@@ -462,41 +488,16 @@ class ArithEvaluator(object):
     i = self._ValToIntOrError(val, span_id=span_id)
     return i
 
-  def Eval(self, node):
-    # type: (arith_expr_t) -> value_t
-    """
-    Args:
-      node: arith_expr_t
-
-    Returns:
-      None for Undef  (e.g. empty cell)  TODO: Don't return 0!
-      int for Str
-      List[int] for MaybeStrArray
-      Dict[str, str] for AssocArray (TODO: Should we support this?)
+  def EvalToInt(self, node):
+    # type: (arith_expr_t) -> int
+    """Used externally by ${a[i+1]} and ${a:start:len}.
 
-    NOTE: (( A['x'] = 'x' )) and (( x = A['x'] )) are syntactically valid in
-    bash, but don't do what you'd think.  'x' sometimes a variable name and
-    sometimes a key.
+    Also used internally.  Operators are evaluated on unboxed integers, so
+    evaluating an expression like i + 1 < n doesn't allocate.
     """
-    # OSH semantics: Variable NAMES cannot be formed dynamically; but INTEGERS
-    # can.  ${foo:-3}4 is OK.  $? will be a compound word too, so we don't have
-    # to handle that as a special case.
-
     UP_node = node
     with tagswitch(node) as case:
-      if case(arith_expr_e.VarRef):  # $(( x ))  (can be array)
-        tok = cast(Token, UP_node)
-        var_name = tok.val
-        val = self.mem.GetValue(var_name)
-        if val.tag_() == value_e.Undef and self.exec_opts.nounset():
-          e_die('Undefined variable %r' % var_name, tok)
-        return val
-
-      elif case(arith_expr_e.Word):  # $(( $x )) $(( ${x}${y} )), etc.
-        w = cast(compound_word, UP_node)
-        return self.word_ev.EvalWordToString(w)
-
-      elif case(arith_expr_e.UnaryAssign):  # a++
+      if case(arith_expr_e.UnaryAssign):  # a++
         node = cast(arith_expr__UnaryAssign, UP_node)
 
         op_id = node.op_id
@@ -523,7 +524,7 @@ class ArithEvaluator(object):
 
         #log('old %d new %d ret %d', old_int, new_int, ret)
         self._Store(lval, new_int)
-        return value.Int(ret)
+        return ret
 
       elif case(arith_expr_e.BinaryAssign):  # a=1, a+=5, a[1]+=5
         node = cast(arith_expr__BinaryAssign, UP_node)
@@ -536,7 +537,7 @@ class ArithEvaluator(object):
           rhs_int = self.EvalToInt(node.right)
 
           self._Store(lval, rhs_int)
-          return value.Int(rhs_int)
+          return rhs_int
 
         old_int, lval = self._EvalLhsAndLookupArith(node.left)
         rhs = self.EvalToInt(node.right)
@@ -572,7 +573,7 @@ class ArithEvaluator(object):
           raise AssertionError(op_id)  # shouldn't get here
 
         self._Store(lval, new_int)
-        return value.Int(new_int)
+        return new_int
 
       elif case(arith_expr_e.Unary):
         node = cast(arith_expr__Unary, UP_node)
@@ -592,11 +593,13 @@ class ArithEvaluator(object):
         else:
           raise AssertionError(op_id)  # shouldn't get here
 
-        return value.Int(ret)
+        return ret
 
       elif case(arith_expr_e.Binary):
         node = cast(arith_expr__Binary, UP_node)
         op_id = node.op_id
+        if op_id == Id.Arith_LBracket:
+          return self._ValToInt(self.Eval(node), node)
 
         # Short-circuit evaluation for || and &&.
         if op_id == Id.Arith_DPipe:
@@ -606,7 +609,7 @@ class ArithEvaluator(object):
             ret = int(rhs != 0)
           else:
             ret = 1  # true
-          return value.Int(ret)
+          return ret
 
         if op_id == Id.Arith_DAmp:
           lhs = self.EvalToInt(node.left)
@@ -615,40 +618,12 @@ class ArithEvaluator(object):
           else:
             rhs = self.EvalToInt(node.right)
             ret = int(rhs != 0)
-          return value.Int(ret)
-
-        if op_id == Id.Arith_LBracket:
-          # NOTE: Similar to bracket_op_e.ArrayIndex in osh/word_eval.py
-
-          left = self.Eval(node.left)
-          UP_left = left
-          with tagswitch(left) as case:
-            if case(value_e.MaybeStrArray):
-              array_val = cast(value__MaybeStrArray, UP_left)
-              index = self.EvalToInt(node.right)
-              s = word_eval.GetArrayItem(array_val.strs, index)
-
-            elif case(value_e.AssocArray):
-              left = cast(value__AssocArray, UP_left)
-              key = self.EvalWordToString(node.right)
-              s = left.d.get(key)
-
-            else:
-              # TODO: Add error context
-              e_die('Expected array or assoc in index expression, got %s' %
-                    ui.ValType(left))
-
-          if s is None:
-            val = value.Undef()
-          else:
-            val = value.Str(s)
-
-          return val
+          return ret
 
         if op_id == Id.Arith_Comma:
           self.EvalToInt(node.left)  # throw away result
           ret = self.EvalToInt(node.right)
-          return value.Int(ret)
+          return ret
 
         # Rest are integers
         lhs = self.EvalToInt(node.left)
@@ -715,7 +690,79 @@ class ArithEvaluator(object):
         else:
           raise AssertionError(op_id)
 
-        return value.Int(ret)
+        return ret
+
+    return self._ValToInt(self.Eval(node), node)
+
+  def Eval(self, node):
+    # type: (arith_expr_t) -> value_t
+    """
+    Args:
+      node: arith_expr_t
+
+    Returns:
+      None for Undef  (e.g. empty cell)  TODO: Don't return 0!
+      int for Str
+      List[int] for MaybeStrArray
+      Dict[str, str] for AssocArray (TODO: Should we support this?)
+
+    NOTE: (( A['x'] = 'x' )) and (( x = A['x'] )) are syntactically valid in
+    bash, but don't do what you'd think.  'x' sometimes a variable name and
+    sometimes a key.
+    """
+    # OSH semantics: Variable NAMES cannot be formed dynamically; but INTEGERS
+    # can.  ${foo:-3}4 is OK.  $? will be a compound word too, so we don't have
+    # to handle that as a special case.
+
+    UP_node = node
+    with tagswitch(node) as case:
+      if case(arith_expr_e.VarRef):  # $(( x ))  (can be array)
+        tok = cast(Token, UP_node)
+        var_name = tok.val
+        val = self.mem.GetValue(var_name)
+        if val.tag_() == value_e.Undef and self.exec_opts.nounset():
+          e_die('Undefined variable %r' % var_name, tok)
+        return val
+
+      elif case(arith_expr_e.Word):  # $(( $x )) $(( ${x}${y} )), etc.
+        w = cast(compound_word, UP_node)
+        return self.word_ev.EvalWordToString(w)
+
+      elif case(arith_expr_e.Binary):
+        node = cast(arith_expr__Binary, UP_node)
+        if node.op_id == Id.Arith_LBracket:
+          # NOTE: Similar to bracket_op_e.ArrayIndex in osh/word_eval.py
+
+          left = self.Eval(node.left)
+          UP_left = left
+          with tagswitch(left) as case:
+            if case(value_e.MaybeStrArray):
+              array_val = cast(value__MaybeStrArray, UP_left)
+              index = self.EvalToInt(node.right)
+              s = word_eval.GetArrayItem(array_val.strs, index)
+
+            elif case(value_e.AssocArray):
+              left = cast(value__AssocArray, UP_left)
+              key = self.EvalWordToString(node.right)
+              s = left.d.get(key)
+
+            else:
+              # TODO: Add error context
+              e_die('Expected array or assoc in index expression, got %s' %
+                    ui.ValType(left))
+
+          if s is None:
+            val = value.Undef()
+          else:
+            val = value.Str(s)
+
+          return val
+
+        return value.Int(self.EvalToInt(node))
+
+      elif case(arith_expr_e.UnaryAssign, arith_expr_e.BinaryAssign,
+                arith_expr_e.Unary):
+        return value.Int(self.EvalToInt(node))
 
       elif case(arith_expr_e.TernaryOp):
         node = cast(arith_expr__TernaryOp, UP_node)
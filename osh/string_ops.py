@@ -13,11 +13,12 @@ from _devbuild.gen.syntax_asdl import loc, Token
 from core import pyutil
 from core import ui
 from core.pyerror import e_die, e_strict, log
+from mycpp import mylib
 from osh import glob_
 
 import libc
 
-from typing import List, Tuple, TYPE_CHECKING
+from typing import List, Tuple, Optional, TYPE_CHECKING
 if TYPE_CHECKING:
   from _devbuild.gen.syntax_asdl import suffix_op__Unary, suffix_op__PatSub
 
@@ -169,6 +170,11 @@ def CountUtf8Chars(s):
   $ echo $?
   1
   """
+  num_chars = mylib.Utf8CharCount(s)  # fast, and cached for long strings
+  if num_chars != -1:
+    return num_chars
+
+  # Invalid UTF-8: decode one char at a time to raise the right error
   num_chars = 0
   num_bytes = len(s)
   i = 0
@@ -201,23 +207,67 @@ def AdvanceUtf8Chars(s, num_chars, byte_offset):
   return i
 
 
+def Utf8SliceRange(s, begin, length, has_length):
+  # type: (str, int, int, bool) -> Tuple[int, int]
+  """Returns the byte range of ${s:begin:length}, which counts UTF-8 chars.
+
+  Valid strings are sliced with the character index in mylib, so a loop over
+  ${s:i:1} is linear rather than quadratic.
+  """
+  num_chars = mylib.Utf8CharCount(s)
+  if num_chars != -1:
+    start = begin
+    if start < 0:
+      start += num_chars
+
+    if not has_length:
+      end = num_chars
+    elif length < 0:  # Confusing: this is a POSITION
+      end = num_chars + length
+    elif length < num_chars - start:  # written this way to avoid overflow
+      end = start + length
+    else:
+      end = num_chars
+
+    if start >= 0 and end >= 0:
+      return mylib.Utf8CharOffset(s, start), mylib.Utf8CharOffset(s, end)
+
+  # Invalid UTF-8, or a negative offset before the start.  Walk the string,
+  # which raises the right error.
+  n = len(s)
+  if begin < 0:
+    byte_begin = n
+    num_iters = -begin
+    for _ in xrange(num_iters):
+      byte_begin = PreviousUtf8Char(s, byte_begin)
+  else:
+    byte_begin = AdvanceUtf8Chars(s, begin, 0)
+
+  if has_length:
+    if length < 0:
+      byte_end = n
+      num_iters = -length
+      for _ in xrange(num_iters):
+        byte_end = PreviousUtf8Char(s, byte_end)
+    else:
+      byte_end = AdvanceUtf8Chars(s, length, byte_begin)
+  else:
+    byte_end = n
+
+  return byte_begin, byte_end
+
+
 # Implementation without Python regex:
 #
-# (1) PatSub: I think we fill in GlobToExtendedRegex, then use regcomp and
-# regexec.  in a loop.  fnmatch() does NOT given positions of matches.
+# (1) PatSub: ${x/pat/rep} calls libc.fnmatch_search() in a loop.  It returns
+# the position of the leftmost-longest match, which fnmatch() can't.
 #
 # (2) Strip -- % %% # ## -
 #
 # a. Fast path for constant strings.
-# b. Convert to POSIX extended regex, to see if it matches at ALL.  If it
-# doesn't match, short circuit out?  We can't do this with fnmatch.
-# c. If it does match, call fnmatch() iteratively over prefixes / suffixes.
-#
-# - # shortest prefix - [:1], [:2], [:3] until it matches
-# - ## longest prefix - [:-1] [:-2], [:3].  Works because fnmatch does not
-#                       match prefixes, it matches EXATLY.
-# - % shortest suffix - [-1:] [-2:] [-3:] ...
-# - %% longest suffix - [1:] [2:] [3:]
+# b. Otherwise libc.fnmatch_prefix() and fnmatch_suffix() run the compiled
+#    pattern over the string once, rather than calling fnmatch() on every
+#    prefix or suffix.
 #
 # See remove_pattern() in subst.c for bash, and trimsub() in eval.c for
 # mksh.  Dash doesn't implement it.
@@ -287,145 +337,95 @@ def DoUnarySuffixOp(s, op, arg, is_extglob):
     else:  # e.g. ^ ^^ , ,,
       raise AssertionError(tok.id)
 
-  # For patterns, do fnmatch() in a loop.
-  #
-  # TODO:
-  # - Another potential fast path:
-  #   v=aabbccdd
-  #   echo ${v#*b}  # strip shortest prefix
-  #
-  # If the whole thing doesn't match '*b*', then no test can succeed.  So we
-  # can fail early.  Conversely echo ${v%%c*} and '*c*'.
-  #
-  # (Although honestly this whole construct is nuts and should be deprecated.)
+  # For patterns, libc finds the prefix or suffix in one pass over s.  See
+  # cpp/glob_shared.c.
 
-  n = len(s)
+  if tok.id in (Id.VOp1_Pound, Id.VOp1_DPound):  # shortest / longest prefix
+    end = libc.fnmatch_prefix(arg, s, tok.id == Id.VOp1_DPound)
+    if end == -1:
+      return s
+    return s[end:]
 
-  if tok.id == Id.VOp1_Pound:  # shortest prefix
-    # 'abcd': match '', 'a', 'ab', 'abc', ...
-    i = 0
-    while True:
-      assert i <= n
-      #log('Matching pattern %r with %r', arg, s[:i])
-      if libc.fnmatch(arg, s[:i]):
-        return s[i:]
-      if i >= n:
-        break
-      i = _NextUtf8Char(s, i)
-    return s
-
-  elif tok.id == Id.VOp1_DPound:  # longest prefix
-    # 'abcd': match 'abc', 'ab', 'a'
-    i = n
-    while True:
-      assert i >= 0
-      #log('Matching pattern %r with %r', arg, s[:i])
-      if libc.fnmatch(arg, s[:i]):
-        return s[i:]
-      if i == 0:
-        break
-      i = PreviousUtf8Char(s, i)
-    return s
-
-  elif tok.id == Id.VOp1_Percent:  # shortest suffix
-    # 'abcd': match 'abcd', 'abc', 'ab', 'a'
-    i = n
-    while True:
-      assert i >= 0
-      #log('Matching pattern %r with %r', arg, s[:i])
-      if libc.fnmatch(arg, s[i:]):
-        return s[:i]
-      if i == 0:
-        break
-      i = PreviousUtf8Char(s, i)
-    return s
-
-  elif tok.id == Id.VOp1_DPercent:  # longest suffix
-    # 'abcd': match 'abc', 'bc', 'c', ...
-    i = 0
-    while True:
-      assert i <= n
-      #log('Matching pattern %r with %r', arg, s[:i])
-      if libc.fnmatch(arg, s[i:]):
-        return s[:i]
-      if i >= n:
-        break
-      i = _NextUtf8Char(s, i)
-    return s
+  elif tok.id in (Id.VOp1_Percent, Id.VOp1_DPercent):  # shortest / longest suffix
+    start = libc.fnmatch_suffix(arg, s, tok.id == Id.VOp1_DPercent)
+    if start == -1:
+      return s
+    return s[:start]
 
   else:
     raise NotImplementedError(ui.PrettyId(tok.id))
 
 
-def _AllMatchPositions(s, regex):
-  # type: (str, str) -> List[Tuple[int, int]]
-  """Returns a list of all (start, end) match positions of the regex against s.
-
-  (If there are no matches, it returns the empty list.)
-  """
-  matches = []  # type: List[Tuple[int, int]]
-  pos = 0
-  n = len(s)
-  while pos < n:  # needed to prevent infinite loop in (.*) case
-    m = libc.regex_first_group_match(regex, s, pos)
-    if m is None:
-      break
-    matches.append(m)
-    start, end = m
-    pos = end  # advance position
-  return matches
-
-
-def _PatSubAll(s, regex, replace_str):
-  # type: (str, str, str) -> str
-  parts = []  # type: List[str]
-  prev_end = 0
-  for start, end in _AllMatchPositions(s, regex):
-    parts.append(s[prev_end:start])
-    parts.append(replace_str)
-    prev_end = end
-  parts.append(s[prev_end:])
-  return ''.join(parts)
-
-
 class GlobReplacer(object):
 
-  def __init__(self, regex, replace_str, slash_tok):
+  def __init__(self, pat, replace_str, slash_tok):
     # type: (str, str, Token) -> None
-
-    # TODO: It would be nice to cache the compilation of the regex here,
-    # instead of just the string.  That would require more sophisticated use of
-    # the Python/C API in libc.c, which we might want to avoid.
-    self.regex = regex
+    self.pat = pat
     self.replace_str = replace_str
     self.slash_tok = slash_tok
 
   def __repr__(self):
     # type: () -> str
-    return '<_GlobReplacer regex %r r %r>' % (self.regex, self.replace_str)
+    return '<_GlobReplacer pat %r r %r>' % (self.pat, self.replace_str)
+
+  def _Search(self, s, pos):
+    # type: (str, int) -> Optional[Tuple[int, int]]
+    try:
+      return libc.fnmatch_search(self.pat, s, pos)
+    except RuntimeError as e:
+      # libc.fnmatch_search raises RuntimeError on a range like [z-a]
+      msg = e.message  # type: str
+      e_die('Error matching glob %r: %s' % (self.pat, msg), self.slash_tok)
+
+  def _ReplaceAll(self, s):
+    # type: (str) -> str
+    """Like bash's pat_subst() with MATCH_GLOBREP."""
+    if len(self.pat) == 0:  # like bash, an empty pattern doesn't match
+      return s
+
+    parts = []  # type: List[str]
+    n = len(s)
+    prev_end = 0
+    pos = 0
+    while pos < n:
+      m = self._Search(s, pos)
+      if m is None:
+        break
+      start, end = m
+      parts.append(s[prev_end:start])
+      parts.append(self.replace_str)
+      if end == start:  # empty match: keep one char, so we make progress
+        if start == n:
+          prev_end = n
+          break
+        end = _NextUtf8Char(s, start)
+        parts.append(s[start:end])
+      prev_end = end
+      pos = end
+    parts.append(s[prev_end:])
+    return ''.join(parts)
 
   def Replace(self, s, op):
     # type: (str, suffix_op__PatSub) -> str
 
-    regex = '(%s)' % self.regex  # make it a group
-
     if op.replace_mode == Id.Lit_Slash:
-      try:
-        return _PatSubAll(s, regex, self.replace_str)  # loop over matches
-      except RuntimeError as e:
-        # Not sure if this is possible since we convert from glob:
-        # libc.regex_first_group_match raises RuntimeError on regex syntax
-        # error.
-        msg = e.message  # type: str
-        e_die('Error matching regex %r: %s' % (regex, msg), self.slash_tok)
-
-    if op.replace_mode == Id.Lit_Pound:
-      regex = '^' + regex
-    elif op.replace_mode == Id.Lit_Percent:
-      regex = regex + '$'
-
-    m = libc.regex_first_group_match(regex, s, 0)
-    #log('regex = %r, s = %r, match = %r', regex, s, m)
+      return self._ReplaceAll(s)
+
+    if op.replace_mode == Id.Lit_Pound:  # longest prefix
+      end = libc.fnmatch_prefix(self.pat, s, True)
+      if end == -1:
+        return s
+      return self.replace_str + s[end:]
+
+    if op.replace_mode == Id.Lit_Percent:  # longest suffix
+      start = libc.fnmatch_suffix(self.pat, s, True)
+      if start == -1:
+        return s
+      return s[:start] + self.replace_str
+
+    if len(self.pat) == 0:
+      return s
+    m = self._Search(s, 0)
     if m is None:
       return s
     start, end = m
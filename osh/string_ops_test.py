@@ -6,6 +6,7 @@ from __future__ import print_function
 
 import unittest
 
+import libc
 from core import error
 from osh import string_ops  # module under test
 
@@ -105,28 +106,67 @@ class LibStrTest(unittest.TestCase):
       print('%d test %06r return %06r' % (i, s[i:], s[:i]))
     print()
 
+  def testUtf8SliceRange(self):
+    mu = '\xce\xbc'
+    s = 'a' + mu + 'b' + mu  # 4 chars, 6 bytes
+    CASES = [
+        # begin, length, has_length, expected byte range
+        (0, 0, False, (0, 6)),
+        (1, 0, False, (1, 6)),
+        (1, 1, True, (1, 3)),
+        (1, 2, True, (1, 4)),
+        (3, 99, True, (4, 6)),
+        (4, 1, True, (6, 6)),
+        (99, 1, True, (6, 6)),
+        (-1, 0, False, (4, 6)),
+        (-3, 1, True, (1, 3)),
+        (1, -1, True, (1, 4)),
+        (0, 2**31 - 1, True, (0, 6)),
+    ]
+    for begin, length, has_length, expected in CASES:
+      self.assertEqual(
+          expected,
+          string_ops.Utf8SliceRange(s, begin, length, has_length))
+
+    self.assertEqual(4, string_ops.CountUtf8Chars(s))
+
+    # Before the start, or invalid UTF-8
+    self.assertRaises(
+        error.Strict, string_ops.Utf8SliceRange, s, -5, 0, False)
+    self.assertRaises(
+        error.Strict, string_ops.Utf8SliceRange, s, 0, -5, True)
+    self.assertRaises(
+        error.Strict, string_ops.Utf8SliceRange, 'a\xffb', 0, 2, True)
+    self.assertRaises(error.Strict, string_ops.CountUtf8Chars, 'a\xffb')
+
   def testPatSubAllMatches(self):
     s = 'oXooXoooX'
 
     # Match positions
-    self.assertEqual(
-        [(1, 3), (4, 6)],
-        string_ops._AllMatchPositions(s, '(X.)'))
+    self.assertEqual((1, 3), libc.fnmatch_search('X?', s, 0))
+    self.assertEqual((4, 6), libc.fnmatch_search('X?', s, 3))
+    self.assertEqual(None, libc.fnmatch_search('X?', s, 6))
 
     # No match
-    self.assertEqual(
-        [],
-        string_ops._AllMatchPositions(s, '(z)'))
+    self.assertEqual(None, libc.fnmatch_search('z', s, 0))
 
     # Replacement
-    self.assertEqual(
-        'o_o_ooX',
-        string_ops._PatSubAll(s, '(X.)', '_'))
+    r = string_ops.GlobReplacer('X?', '_', None)
+    self.assertEqual('o_o_ooX', r._ReplaceAll(s))
 
     # Replacement with no match
-    self.assertEqual(
-        s,
-        string_ops._PatSubAll(s, '(z)', '_'))
+    r = string_ops.GlobReplacer('z', '_', None)
+    self.assertEqual(s, r._ReplaceAll(s))
+
+    # Empty matches don't loop forever
+    r = string_ops.GlobReplacer('*', '_', None)
+    self.assertEqual('_', r._ReplaceAll(s))
+    r = string_ops.GlobReplacer('*([z])', '_', None)
+    self.assertEqual('_o_X', r._ReplaceAll('oX'))
+
+    # Like bash, an empty pattern doesn't match
+    r = string_ops.GlobReplacer('', '_', None)
+    self.assertEqual('oX', r._ReplaceAll('oX'))
 
 
 if __name__ == '__main__':
@@ -314,27 +314,8 @@ def _PerformSlice(val,  # type: value_t
     if case(value_e.Str):  # Slice UTF-8 characters in a string.
       val = cast(value__Str, UP_val)
       s = val.s
-      n = len(s)
-
-      if begin < 0:  # Compute offset with unicode
-        byte_begin = n
-        num_iters = -begin
-        for _ in xrange(num_iters):
-          byte_begin = string_ops.PreviousUtf8Char(s, byte_begin)
-      else:
-        byte_begin = string_ops.AdvanceUtf8Chars(s, begin, 0)
-
-      if has_length:
-        if length < 0:  # Compute offset with unicode
-          # Confusing: this is a POSITION
-          byte_end = n
-          num_iters = -length
-          for _ in xrange(num_iters):
-            byte_end = string_ops.PreviousUtf8Char(s, byte_end)
-        else:
-          byte_end = string_ops.AdvanceUtf8Chars(s, length, byte_begin)
-      else:
-        byte_end = len(s)
+      byte_begin, byte_end = string_ops.Utf8SliceRange(s, begin, length,
+                                                       has_length)
 
       substr = s[byte_begin : byte_end]
       result = value.Str(substr)  # type: value_t
@@ -812,9 +793,8 @@ class AbstractWordEvaluator(StringWordEvaluator):
     # type: (value_t, suffix_op__PatSub) -> value_t
 
     pat_val, has_extglob = self.EvalWordToPattern(op.pat)
-    # Extended globs aren't supported because we only translate * ? etc. to
-    # ERE.  I don't think there's a straightforward translation from !(*.py) to
-    # ERE!  You would need an engine that supports negation?  (Derivatives?)
+    # Extended globs aren't supported.  libc.fnmatch_search() would fall back
+    # on fnmatch() in a loop for them, which is quadratic.
     if has_extglob:
       e_die('extended globs not supported in ${x//GLOB/}', loc.Word(op.pat))
 
@@ -827,14 +807,7 @@ class AbstractWordEvaluator(StringWordEvaluator):
       replace_str = ''
 
     # note: doesn't support self.exec_opts.extglob()!
-    regex, warnings = glob_.GlobToERE(pat_val.s)
-    if len(warnings):
-      # TODO:
-      # - Add 'shopt -s strict_glob' mode and expose warnings.
-      #   "Glob is not in CANONICAL FORM".
-      # - Propagate location info back to the 'op.pat' word.
-      pass
-    replacer = string_ops.GlobReplacer(regex, replace_str, op.slash_tok)
+    replacer = string_ops.GlobReplacer(pat_val.s, replace_str, op.slash_tok)
 
     with tagswitch(val) as case2:
       if case2(value_e.Str):
@@ -1573,7 +1546,7 @@ class AbstractWordEvaluator(StringWordEvaluator):
       elif case(word_part_e.ArithSub):
         part = cast(word_part__ArithSub, UP_part)
         num = self.arith_ev.EvalToInt(part.anode)
-        v = part_value.String(str(num), quoted, not quoted)
+        v = part_value.String(self.arith_ev.FormatInt(num), quoted, not quoted)
         part_vals.append(v)
 
       elif case(word_part_e.ExtGlob):
@@ -2159,16 +2132,28 @@ class AbstractWordEvaluator(StringWordEvaluator):
         for entry in part_vals:
           log('  %s', entry)
 
-      frames = _MakeWordFrames(part_vals)
-      if 0:
-        log('')
-        log('frames after _MakeWordFrames:')
-        for entry in frames:
-          log('  %s', entry)
+      if len(part_vals) == 1 and part_vals[0].tag_() == part_value_e.Array:
+        # Fast path for "$@" and "${a[@]}", which are often passed through
+        # functions.  Array parts are always quoted, so each item is one arg,
+        # with no splitting or globbing.  This is what the frames below
+        # evaluate to, without a frame per item.
+        array_part = cast(part_value__Array, part_vals[0])
+        for s in array_part.strs:
+          if s is not None:  # ignore undefined array entries
+            strs.append(s)
 
-      # Do splitting and globbing.  Each frame will append zero or more args.
-      for frame in frames:
-        self._EvalWordFrame(frame, strs)
+      else:
+        frames = _MakeWordFrames(part_vals)
+        if 0:
+          log('')
+          log('frames after _MakeWordFrames:')
+          for entry in frames:
+            log('  %s', entry)
+
+        # Do splitting and globbing.  Each frame will append zero or more
+        # args.
+        for frame in frames:
+          self._EvalWordFrame(frame, strs)
 
       # Fill in spids parallel to strs.
       n_next = len(strs)
@@ -6,6 +6,7 @@
 #include <stdio.h>  // printf
 
 #include <Python.h>
+#include <structmember.h>  // PyMemberDef, for Token slots
 
 #include "_gen/frontend/id_kind.asdl_c.h"
 #include "_gen/frontend/types.asdl_c.h"  // for lex_mode_e
@@ -51,6 +52,164 @@ fastlex_MatchOshToken(PyObject *self, PyObject *args) {
   return Py_BuildValue("(ii)", id, end_pos);
 }
 
+// State for ReadToken(), set by InitReadToken().
+//
+// We allocate Token instances of the ASDL class directly, and fill in their
+// __slots__, instead of calling Token.__init__ in bytecode.
+
+enum {
+  TOK_ID, TOK_COL, TOK_LENGTH, TOK_LINE_ID, TOK_SPAN_ID, TOK_VAL, NUM_TOK_SLOTS
+};
+
+static const char* kTokenSlots[NUM_TOK_SLOTS] = {
+  "id", "col", "length", "line_id", "span_id", "val"
+};
+
+static PyTypeObject* gTokenType = NULL;
+static Py_ssize_t gTokenOffsets[NUM_TOK_SLOTS];
+
+// One byte per Id, from _InitReadToken() in frontend/lexer.py
+enum {
+  ID_VALUE = 0,     // the token's value is a new string
+  ID_NO_VALUE = 1,  // tokens with that Id don't need a value
+  ID_INTERN = 2,    // the value is interned, e.g. for variable names
+};
+static PyObject* gIdFlags = NULL;
+
+static PyObject *
+fastlex_InitReadToken(PyObject *self, PyObject *args) {
+  PyObject* token_type;
+  PyObject* id_flags;
+  if (!PyArg_ParseTuple(args, "O!S", &PyType_Type, &token_type, &id_flags)) {
+    return NULL;
+  }
+
+  for (int i = 0; i < NUM_TOK_SLOTS; ++i) {
+    PyObject* descr = PyObject_GetAttrString(token_type, kTokenSlots[i]);
+    if (descr == NULL) {
+      return NULL;
+    }
+    if (Py_TYPE(descr) != &PyMemberDescr_Type ||
+        ((PyMemberDescrObject*)descr)->d_member->type != T_OBJECT_EX) {
+      PyErr_Format(PyExc_TypeError, "Expected %s to be in __slots__",
+                   kTokenSlots[i]);
+      Py_DECREF(descr);
+      return NULL;
+    }
+    gTokenOffsets[i] = ((PyMemberDescrObject*)descr)->d_member->offset;
+    Py_DECREF(descr);
+  }
+
+  Py_INCREF(token_type);
+  Py_XDECREF(gTokenType);
+  gTokenType = (PyTypeObject*)token_type;
+
+  Py_INCREF(id_flags);
+  Py_XDECREF(gIdFlags);
+  gIdFlags = id_flags;
+
+  Py_RETURN_NONE;
+}
+
+static inline void SetSlot(PyObject* obj, int i, PyObject* val) {
+  *(PyObject**)((char*)obj + gTokenOffsets[i]) = val;  // steals val
+}
+
+// Does the work of LineLexer.Read() in frontend/lexer.py: match, make the
+// Token and add it to the arena.  Returns None for Id.Eol_Tok.
+static PyObject *
+fastlex_ReadToken(PyObject *self, PyObject *args) {
+  int lex_mode;
+
+  PyObject* line_obj;
+  int start_pos;
+  int line_id;
+
+  PyObject* tokens;
+  int replace_last;
+  if (!PyArg_ParseTuple(args, "iSiiO!i", &lex_mode, &line_obj, &start_pos,
+                        &line_id, &PyList_Type, &tokens, &replace_last)) {
+    return NULL;
+  }
+  if (gTokenType == NULL) {
+    PyErr_SetString(PyExc_RuntimeError, "InitReadToken wasn't called");
+    return NULL;
+  }
+
+  unsigned char* line = (unsigned char*)PyString_AS_STRING(line_obj);
+  int line_len = PyString_GET_SIZE(line_obj);
+  if (start_pos < 0 || start_pos > line_len) {
+    PyErr_Format(PyExc_ValueError,
+                 "Invalid ReadToken call (start_pos = %d, line_len = %d)",
+                 start_pos, line_len);
+    return NULL;
+  }
+
+  int id;
+  int end_pos;
+  MatchOshToken(lex_mode, line, line_len, start_pos, &id, &end_pos);
+  if (id == id__Eol_Tok) {  // Do NOT add a span for this sentinel!
+    Py_RETURN_NONE;
+  }
+
+  int flags = ID_VALUE;
+  if (id < PyString_GET_SIZE(gIdFlags)) {
+    flags = PyString_AS_STRING(gIdFlags)[id];
+  }
+
+  PyObject* val;
+  if (flags == ID_NO_VALUE) {
+    val = Py_None;  // save on allocations
+    Py_INCREF(val);
+  } else if (start_pos == 0 && end_pos == line_len) {
+    val = line_obj;
+    Py_INCREF(val);
+  } else {
+    val = PyString_FromStringAndSize((char*)line + start_pos,
+                                     end_pos - start_pos);
+    if (val == NULL) {
+      return NULL;
+    }
+  }
+  if (flags == ID_INTERN) {
+    PyString_InternInPlace(&val);  // like mylib.Intern()
+  }
+
+  Py_ssize_t n = PyList_GET_SIZE(tokens);
+  if (replace_last && n > 0) {  // make another token from the last span
+    if (PyList_SetSlice(tokens, n - 1, n, NULL) < 0) {
+      Py_DECREF(val);
+      return NULL;
+    }
+    n--;
+  }
+
+  PyObject* tok = gTokenType->tp_alloc(gTokenType, 0);
+  if (tok == NULL) {
+    Py_DECREF(val);
+    return NULL;
+  }
+  // Small ints are cached, so most of these don't allocate
+  SetSlot(tok, TOK_ID, PyInt_FromLong(id));
+  SetSlot(tok, TOK_COL, PyInt_FromLong(start_pos));
+  SetSlot(tok, TOK_LENGTH, PyInt_FromLong(end_pos - start_pos));
+  SetSlot(tok, TOK_LINE_ID, PyInt_FromLong(line_id));
+  SetSlot(tok, TOK_SPAN_ID, PyInt_FromSsize_t(n));  // spids are list indices
+  SetSlot(tok, TOK_VAL, val);
+  for (int i = 0; i < NUM_TOK_SLOTS; ++i) {
+    if (*(PyObject**)((char*)tok + gTokenOffsets[i]) == NULL) {
+      Py_DECREF(tok);
+      return NULL;  // PyInt_From* failed
+    }
+  }
+
+  if (PyList_Append(tokens, tok) < 0) {
+    Py_DECREF(tok);
+    return NULL;
+  }
+  return tok;
+}
+
 static PyObject *
 fastlex_MatchEchoToken(PyObject *self, PyObject *args) {
   unsigned char* line;
@@ -221,6 +380,10 @@ fastlex_LooksLikeFloat(PyObject *self, PyObject *args) {
 static PyMethodDef methods[] = {
   {"MatchOshToken", fastlex_MatchOshToken, METH_VARARGS,
    "(lexer mode, line, start_pos) -> (id, end_pos)."},
+  {"InitReadToken", fastlex_InitReadToken, METH_VARARGS,
+   "(Token class, Id flags table) -> None."},
+  {"ReadToken", fastlex_ReadToken, METH_VARARGS,
+   "(lexer mode, line, start_pos, line_id, tokens, replace_last) -> Token."},
   {"MatchEchoToken", fastlex_MatchEchoToken, METH_VARARGS,
    "(line, start_pos) -> (id, end_pos)."},
   {"MatchGlobToken", fastlex_MatchGlobToken, METH_VARARGS,
@@ -1,4 +1,6 @@
-from typing import Tuple
+from typing import List, Optional, Tuple, Type
+
+from _devbuild.gen.syntax_asdl import Token
 
 def IsValidVarName(s: str) -> bool: ...
 def ShouldHijack(s: str) -> bool: ...
@@ -6,6 +8,9 @@ def LooksLikeInteger(s: str) -> bool: ...
 def LooksLikeFloat(s: str) -> bool: ...
 
 def MatchOshToken(lex_mode_enum_id: int, line: str, start_pos: int) -> Tuple[int, int]: ...
+def InitReadToken(token_type: Type[Token], id_flags: str) -> None: ...
+def ReadToken(lex_mode_enum_id: int, line: str, start_pos: int, line_id: int,
+              tokens: List[Token], replace_last: bool) -> Optional[Token]: ...
 def MatchPS1Token(line: str, start_pos: int) -> Tuple[int, int]: ...
 def MatchEchoToken(line: str, start_pos: int) -> Tuple[int, int]: ...
 def MatchHistoryToken(line: str, start_pos: int) -> Tuple[int, int]: ...
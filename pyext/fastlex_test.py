@@ -78,6 +78,46 @@ class LexTest(unittest.TestCase):
     self.assertEqual(False, fastlex.IsValidVarName('x-'))
     self.assertEqual(False, fastlex.IsValidVarName('var_name-foo'))
 
+  def testReadToken(self):
+    from frontend import lexer  # calls InitReadToken()
+
+    tokens = []
+    line = 'echo  hi\n'
+    t = fastlex.ReadToken(lex_mode_e.ShCommand, line, 0, 3, tokens, False)
+    self.assertEqual(Id.Lit_Chars, t.id)
+    self.assertEqual((0, 4, 3, 0, 'echo'),
+                     (t.col, t.length, t.line_id, t.span_id, t.val))
+
+    # Whitespace has no value
+    t = fastlex.ReadToken(lex_mode_e.ShCommand, line, 4, 3, tokens, False)
+    self.assertEqual(Id.WS_Space, t.id)
+    self.assertEqual(None, t.val)
+    self.assertEqual(1, t.span_id)
+
+    # Replace the last token, like MaybeUnreadOne()
+    self.assertEqual(6, t.col + t.length)
+    t = fastlex.ReadToken(lex_mode_e.ShCommand, line, 6, 3, tokens, True)
+    self.assertEqual('hi', t.val)
+    self.assertEqual(1, t.span_id)
+    self.assertEqual(2, len(tokens))
+    self.assertIs(t, tokens[-1])
+
+    t = fastlex.ReadToken(lex_mode_e.ShCommand, line, 8, 3, tokens, False)
+    self.assertEqual(Id.Op_Newline, t.id)
+
+    # No token for the sentinel
+    t = fastlex.ReadToken(lex_mode_e.ShCommand, line, 9, 3, tokens, False)
+    self.assertEqual(None, t)
+    self.assertEqual(3, len(tokens))
+
+    self.assertRaises(ValueError, fastlex.ReadToken, lex_mode_e.ShCommand,
+                      line, 10, 3, tokens, False)
+
+    # Names are interned
+    t = fastlex.ReadToken(lex_mode_e.ShCommand, 'x=1\n', 0, 4, tokens, False)
+    self.assertEqual(Id.Lit_VarLike, t.id)
+    self.assertIs(intern('x='), t.val)
+
 
 if __name__ == '__main__':
   unittest.main()
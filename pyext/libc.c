@@ -21,6 +21,8 @@
 
 #include <Python.h>
 
+#include "cpp/glob_shared.h"
+
 // Log messages to stderr.
 static void debug(const char* fmt, ...) {
 #ifdef LIBC_VERBOSE
@@ -54,40 +56,85 @@ func_realpath(PyObject *self, PyObject *args) {
 static PyObject *
 func_fnmatch(PyObject *self, PyObject *args) {
   const char *pattern;
+  int pattern_len;
   const char *str;
+  int str_len;
 
-  if (!PyArg_ParseTuple(args, "ss", &pattern, &str)) {
+  if (!PyArg_ParseTuple(args, "s#s#", &pattern, &pattern_len, &str,
+                        &str_len)) {
     return NULL;
   }
 
-  int flags = 0;
-  // NOTE: Testing for __GLIBC__ is the version detection anti-pattern.  We
-  // should really use feature detection in our configure script.  But I plan
-  // to get rid of the dependency on FNM_EXTMATCH because it doesn't work on
-  // musl libc (or OS X).  Instead we should compile extended globs to extended
-  // regex syntax.
-#ifdef __GLIBC__
-  flags |= FNM_EXTMATCH;
-#else
-  debug("Warning: FNM_EXTMATCH is not defined");
-#endif
+  // Compiled and cached in cpp/glob_shared.c.  It falls back on fnmatch() with
+  // FNM_EXTMATCH for extended globs.
+  int ret = glob_match(pattern, pattern_len, str, str_len);
+  debug("fnmatch %s %s -> %d", pattern, str, ret);
+  return PyLong_FromLong(ret);
+}
 
-  int ret = fnmatch(pattern, str, flags);
+// For ${x#pat} and ${x##pat}.  Returns the end of the prefix, or -1.
+static PyObject *
+func_fnmatch_prefix(PyObject *self, PyObject *args) {
+  const char *pattern;
+  int pattern_len;
+  const char *str;
+  int str_len;
+  int longest;
 
-  switch (ret) {
-  case 0:
-    debug("matched: %s", str);
-    return PyLong_FromLong(1);
-    break;
-  case FNM_NOMATCH:
-    debug("no match: %s", str);
-    return PyLong_FromLong(0);
-    break;
-  default:
-    debug("other error: %s", str);
-    return PyLong_FromLong(-1);
-    break;
+  if (!PyArg_ParseTuple(args, "s#s#i", &pattern, &pattern_len, &str, &str_len,
+                        &longest)) {
+    return NULL;
+  }
+  return PyInt_FromLong(
+      glob_match_prefix(pattern, pattern_len, str, str_len, longest));
+}
+
+// For ${x%pat} and ${x%%pat}.  Returns the start of the suffix, or -1.
+static PyObject *
+func_fnmatch_suffix(PyObject *self, PyObject *args) {
+  const char *pattern;
+  int pattern_len;
+  const char *str;
+  int str_len;
+  int longest;
+
+  if (!PyArg_ParseTuple(args, "s#s#i", &pattern, &pattern_len, &str, &str_len,
+                        &longest)) {
+    return NULL;
+  }
+  return PyInt_FromLong(
+      glob_match_suffix(pattern, pattern_len, str, str_len, longest));
+}
+
+// For ${x//pat/rep}.  Returns the leftmost-longest match at or after pos.
+static PyObject *
+func_fnmatch_search(PyObject *self, PyObject *args) {
+  const char *pattern;
+  int pattern_len;
+  const char *str;
+  int str_len;
+  int pos;
+
+  if (!PyArg_ParseTuple(args, "s#s#i", &pattern, &pattern_len, &str, &str_len,
+                        &pos)) {
+    return NULL;
+  }
+  if (pos < 0 || pos > str_len) {
+    PyErr_SetString(PyExc_ValueError, "Invalid position");
+    return NULL;
+  }
+
+  int start;
+  int end;
+  int ret = glob_search(pattern, pattern_len, str, str_len, pos, &start, &end);
+  if (ret == -1) {
+    PyErr_SetString(PyExc_RuntimeError, "Invalid range in glob");
+    return NULL;
   }
+  if (ret == 0) {
+    Py_RETURN_NONE;
+  }
+  return Py_BuildValue("(i,i)", start, end);
 }
 
 // error callback to glob()
@@ -373,6 +420,11 @@ static PyMethodDef methods[] = {
   // Return whether a string matches a pattern."
   {"fnmatch", func_fnmatch, METH_VARARGS, ""},
 
+  // For ${x#pat} ${x%pat} ${x//pat/rep}: where a pattern matches in a string.
+  {"fnmatch_prefix", func_fnmatch_prefix, METH_VARARGS, ""},
+  {"fnmatch_suffix", func_fnmatch_suffix, METH_VARARGS, ""},
+  {"fnmatch_search", func_fnmatch_search, METH_VARARGS, ""},
+
   // Return a list of files that match a pattern.
   // We need this since Python's glob doesn't have char classes.
   {"glob", func_glob, METH_VARARGS, ""},
@@ -3,6 +3,9 @@ from typing import List, Optional, Tuple
 def gethostname() -> str: ...
 def glob(pat: str) -> List[str]: ...
 def fnmatch(pat: str, s: str) -> bool: ...
+def fnmatch_prefix(pat: str, s: str, longest: bool) -> int: ...
+def fnmatch_suffix(pat: str, s: str, longest: bool) -> int: ...
+def fnmatch_search(pat: str, s: str, pos: int) -> Optional[Tuple[int, int]]: ...
 def regex_first_group_match(regex: str, s: str, pos: int) -> Optional[Tuple[int, int]]: ...
 def regex_match(regex: str, s: str) -> List[str]: ...
 def wcswidth(s: str) -> int: ...
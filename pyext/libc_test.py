@@ -170,6 +170,44 @@ class LibcTest(unittest.TestCase):
           "Matching %s against %s: got %s but expected %s" %
           (pat, s, actual, expected))
 
+  def testFnmatchUtf8(self):
+    mu = '\xce\xbc'
+    self.assertEqual(1, libc.fnmatch('?', mu))
+    self.assertEqual(0, libc.fnmatch('??', mu))
+    self.assertEqual(1, libc.fnmatch('[%s]' % mu, mu))
+    self.assertEqual(1, libc.fnmatch('a?c', 'a%sc' % mu))
+
+  def testFnmatchPrefixSuffix(self):
+    s = 'dir/sub/file.tar.gz'
+    self.assertEqual(4, libc.fnmatch_prefix('*/', s, False))
+    self.assertEqual(8, libc.fnmatch_prefix('*/', s, True))
+    self.assertEqual(0, libc.fnmatch_prefix('*', s, False))
+    self.assertEqual(len(s), libc.fnmatch_prefix('*', s, True))
+    self.assertEqual(-1, libc.fnmatch_prefix('x*', s, True))
+
+    self.assertEqual(16, libc.fnmatch_suffix('.*', s, False))
+    self.assertEqual(12, libc.fnmatch_suffix('.*', s, True))
+    self.assertEqual(-1, libc.fnmatch_suffix('*x', s, True))
+
+    # Positions are on character boundaries
+    mu = '\xce\xbc'
+    self.assertEqual(2, libc.fnmatch_prefix('?', mu + mu, False))
+    self.assertEqual(2, libc.fnmatch_suffix('?', mu + mu, False))
+
+    # Extended globs fall back on fnmatch()
+    self.assertEqual(3, libc.fnmatch_prefix('@(foo|fo)', 'foobar', True))
+    self.assertEqual(2, libc.fnmatch_prefix('@(foo|fo)', 'foobar', False))
+
+  def testFnmatchSearch(self):
+    s = 'dir/sub/file.tar.gz'
+    self.assertEqual((8, 17), libc.fnmatch_search('f*.', s, 0))
+    self.assertEqual(None, libc.fnmatch_search('f*.', s, 9))
+    self.assertEqual((0, 8), libc.fnmatch_search('[a-z]*/', s, 0))
+    self.assertEqual((4, 8), libc.fnmatch_search('[a-z]*/', s, 3))
+    self.assertEqual((len(s), len(s)), libc.fnmatch_search('*', s, len(s)))
+
+    self.assertRaises(ValueError, libc.fnmatch_search, '*', s, len(s) + 1)
+
   def testGlob(self):
     print(libc.glob('*.py'))
 
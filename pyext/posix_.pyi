@@ -119,6 +119,8 @@ def fdatasync(fd: int) -> None: ...
 def fdopen(fd: int, mode: str = ..., bufsize: int = ...) -> mylib.LineReader: ...
 def fork() -> int:
     raise OSError()
+def spawn_child(path: str, argv: List[str], env: Dict[str, str],
+                fd_actions: List[int], sig_dfl: List[int]) -> Tuple[int, int, int]: ...
 def forkpty() -> Tuple[int, int]:
     raise OSError()
 def fpathconf(fd: int, name: str) -> None: ...
@@ -28,6 +28,7 @@ Other notes:
 """
 from __future__ import print_function
 
+import errno
 import signal
 import subprocess
 import unittest
@@ -132,6 +133,30 @@ class PosixTest(unittest.TestCase):
       log('Hanging on waitpid in pid %d', posix_.getpid())
       posix_.waitpid(-1, 0)
 
+  def testSpawnChild(self):
+    pid, err, _ = posix_.spawn_child(
+        '/bin/sh', ['sh', '-c', 'exit 3'], {}, [], [signal.SIGPIPE])
+    self.assertEqual(0, err)
+    _, status = posix_.waitpid(pid, 0)
+    self.assertEqual(3, posix_.WEXITSTATUS(status))
+
+    # Redirect stdout to a pipe
+    r, w = posix_.pipe()
+    pid, err, _ = posix_.spawn_child(
+        '/bin/sh', ['sh', '-c', 'echo $X'], {'X': 'hi'}, [w, 1, r, -1], [])
+    self.assertEqual(0, err)
+    posix_.close(w)
+    self.assertEqual('hi\n', posix_.read(r, 100))
+    posix_.close(r)
+    posix_.waitpid(pid, 0)
+
+    # The parent gets errno, and the child exits like the shell would
+    pid, err, _ = posix_.spawn_child(
+        '/nonexistent', ['nonexistent'], {}, [], [])
+    self.assertEqual(errno.ENOENT, err)
+    _, status = posix_.waitpid(pid, 0)
+    self.assertEqual(127, posix_.WEXITSTATUS(status))
+
   def testWrite(self):
     if posix_.environ.get('EINTR_TEST'):
 
@@ -1296,6 +1296,275 @@ posix_fork(PyObject *self, PyObject *noargs)
 }
 #endif
 
+#ifdef HAVE_FORK
+/* The environment passed to spawn_child() rarely changes between commands,
+   so we keep the "k=v" strings, along with references to the key and value
+   objects they were made from.  A dict with the same objects in the same
+   order reuses them. */
+static PyObject **spawn_env_objs = NULL;  /* key, value, key, value, ... */
+static char **spawn_env_list = NULL;      /* NULL-terminated, for execve() */
+static Py_ssize_t spawn_env_len = -1;
+
+static void
+spawn_env_clear(void)
+{
+    Py_ssize_t i;
+    for (i = 0; i < spawn_env_len; i++) {
+        Py_DECREF(spawn_env_objs[2*i]);
+        Py_DECREF(spawn_env_objs[2*i+1]);
+        PyMem_DEL(spawn_env_list[i]);
+    }
+    PyMem_DEL(spawn_env_objs);
+    PyMem_DEL(spawn_env_list);
+    spawn_env_objs = NULL;
+    spawn_env_list = NULL;
+    spawn_env_len = -1;
+}
+
+static char **
+spawn_env_get(PyObject *env)
+{
+    PyObject *key, *val;
+    Py_ssize_t pos, i, n;
+
+    n = PyDict_Size(env);
+    if (n == spawn_env_len) {
+        pos = 0;
+        i = 0;
+        while (PyDict_Next(env, &pos, &key, &val)) {
+            if (key != spawn_env_objs[2*i] || val != spawn_env_objs[2*i+1])
+                break;
+            i++;
+        }
+        if (i == n)
+            return spawn_env_list;
+    }
+
+    spawn_env_clear();
+    spawn_env_objs = PyMem_NEW(PyObject *, 2*n);
+    spawn_env_list = PyMem_NEW(char *, n+1);
+    if (spawn_env_objs == NULL || spawn_env_list == NULL) {
+        PyMem_DEL(spawn_env_objs);
+        PyMem_DEL(spawn_env_list);
+        spawn_env_objs = NULL;
+        spawn_env_list = NULL;
+        PyErr_NoMemory();
+        return NULL;
+    }
+
+    spawn_env_len = 0;
+    pos = 0;
+    while (PyDict_Next(env, &pos, &key, &val)) {
+        char *p;
+        size_t len;
+
+        if (!PyString_Check(key) || !PyString_Check(val)) {
+            PyErr_SetString(PyExc_TypeError,
+                            "spawn_child() arg 3 must map strings to strings");
+            spawn_env_clear();
+            return NULL;
+        }
+        len = PyString_GET_SIZE(key) + PyString_GET_SIZE(val) + 2;
+        p = PyMem_NEW(char, len);
+        if (p == NULL) {
+            PyErr_NoMemory();
+            spawn_env_clear();
+            return NULL;
+        }
+        PyOS_snprintf(p, len, "%s=%s", PyString_AS_STRING(key),
+                      PyString_AS_STRING(val));
+
+        Py_INCREF(key);
+        Py_INCREF(val);
+        spawn_env_objs[2*spawn_env_len] = key;
+        spawn_env_objs[2*spawn_env_len+1] = val;
+        spawn_env_list[spawn_env_len++] = p;
+    }
+    spawn_env_list[spawn_env_len] = NULL;
+    return spawn_env_list;
+}
+
+PyDoc_STRVAR_remove(posix_spawn_child__doc__,
+"spawn_child(path, argv, env, fd_actions, sig_dfl) -> (pid, errno, used_sh)\n\n\
+Fork a child process, and set it up and exec it without running any Python\n\
+code.\n\
+\n\
+    fd_actions: flat list of (fd1, fd2) pairs.  dup2(fd1, fd2) if fd2 >= 0,\n\
+      otherwise close(fd1).\n\
+    sig_dfl: signals to reset to SIG_DFL in the child.\n\
+\n\
+If execve() fails with ENOEXEC, the child retries with /bin/sh.  If it\n\
+still fails, it exits with status 126 or 127, and errno is returned, and\n\
+used_sh says whether /bin/sh was the program that failed.");
+
+static PyObject *
+posix_spawn_child(PyObject *self, PyObject *args)
+{
+    char *path;
+    PyObject *argv, *env, *fd_actions, *sig_dfl;
+    char **argvlist = NULL;
+    char **sh_argvlist = NULL;
+    char **envlist;
+    int *actions = NULL;
+    int *signals = NULL;
+    Py_ssize_t argc, num_actions, num_signals, i;
+    int errpipe[2];
+    int report[2];
+    PyObject *result = NULL;
+    pid_t pid;
+
+    if (!PyArg_ParseTuple(args, "sO!O!O!O!:spawn_child", &path,
+                          &PyList_Type, &argv, &PyDict_Type, &env,
+                          &PyList_Type, &fd_actions, &PyList_Type, &sig_dfl))
+        return NULL;
+
+    argc = PyList_GET_SIZE(argv);
+    num_actions = PyList_GET_SIZE(fd_actions);
+    num_signals = PyList_GET_SIZE(sig_dfl);
+    if (argc < 1 || num_actions % 2 != 0) {
+        PyErr_SetString(PyExc_ValueError, "spawn_child(): invalid arguments");
+        return NULL;
+    }
+
+    /* Everything the child needs is allocated here, before fork(). */
+    argvlist = PyMem_NEW(char *, argc+1);
+    sh_argvlist = PyMem_NEW(char *, argc+2);
+    actions = PyMem_NEW(int, num_actions + 1);
+    signals = PyMem_NEW(int, num_signals + 1);
+    if (!argvlist || !sh_argvlist || !actions || !signals) {
+        PyErr_NoMemory();
+        goto done;
+    }
+    for (i = 0; i < argc; i++) {
+        PyObject *a = PyList_GET_ITEM(argv, i);
+        if (!PyString_Check(a)) {
+            PyErr_SetString(PyExc_TypeError,
+                            "spawn_child() arg 2 must contain only strings");
+            goto done;
+        }
+        argvlist[i] = PyString_AS_STRING(a);
+    }
+    argvlist[argc] = NULL;
+
+    /* For scripts without a shebang line: /bin/sh path args... */
+    sh_argvlist[0] = "/bin/sh";
+    sh_argvlist[1] = path;
+    for (i = 1; i <= argc; i++)
+        sh_argvlist[i+1] = argvlist[i];
+
+    for (i = 0; i < num_actions; i++) {
+        actions[i] = _PyInt_AsInt(PyList_GET_ITEM(fd_actions, i));
+        if (actions[i] == -1 && PyErr_Occurred())
+            goto done;
+    }
+    for (i = 0; i < num_signals; i++) {
+        signals[i] = _PyInt_AsInt(PyList_GET_ITEM(sig_dfl, i));
+        if (signals[i] == -1 && PyErr_Occurred())
+            goto done;
+    }
+
+    envlist = spawn_env_get(env);
+    if (envlist == NULL)
+        goto done;
+
+    /* The child reports a failed exec on a close-on-exec pipe.  It's moved
+       out of the way of the fds that fd_actions might touch. */
+    if (pipe(errpipe) < 0) {
+        posix_error();
+        goto done;
+    }
+    report[0] = fcntl(errpipe[0], F_DUPFD, 100);
+    report[1] = fcntl(errpipe[1], F_DUPFD, 100);
+    if (report[0] < 0 || report[1] < 0 ||
+        fcntl(report[0], F_SETFD, FD_CLOEXEC) < 0 ||
+        fcntl(report[1], F_SETFD, FD_CLOEXEC) < 0) {
+        posix_error();
+        if (report[0] >= 0)
+            close(report[0]);
+        if (report[1] >= 0)
+            close(report[1]);
+        report[0] = report[1] = -1;
+    }
+    close(errpipe[0]);
+    close(errpipe[1]);
+    if (report[0] < 0)
+        goto done;
+
+    /* No Python code runs in the child, so unlike posix_fork() we don't need
+       the import lock or PyOS_AfterFork(). */
+    pid = fork();
+    if (pid == 0) {
+        struct sigaction sa;
+        int status[2];
+
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = SIG_DFL;
+        sigemptyset(&sa.sa_mask);
+        for (i = 0; i < num_signals; i++)
+            sigaction(signals[i], &sa, NULL);
+
+        for (i = 0; i < num_actions; i += 2) {
+            int r;
+            if (actions[i+1] >= 0)
+                r = dup2(actions[i], actions[i+1]);
+            else
+                r = close(actions[i]);
+            if (r < 0) {
+                status[0] = errno;
+                status[1] = 0;
+                goto child_fail;
+            }
+        }
+
+        execve(path, argvlist, envlist);
+        status[0] = errno;
+        status[1] = 0;
+        if (errno == ENOEXEC) {
+            execve("/bin/sh", sh_argvlist, envlist);
+            status[0] = errno;
+            status[1] = 1;
+        }
+
+      child_fail:
+        /* Like ExternalProgram._Exec() in core/process.py */
+        if (write(report[1], status, sizeof(status)) < 0) {
+            /* nothing we can do */
+        }
+        _exit(status[0] == EACCES ? 126 : 127);
+    }
+
+    close(report[1]);
+    if (pid == -1) {
+        posix_error();
+        close(report[0]);
+        goto done;
+    }
+
+    {
+        /* Block until the child has exec'd (EOF) or failed */
+        int status[2] = {0, 0};
+        ssize_t n;
+        do {
+            n = read(report[0], status, sizeof(status));
+        } while (n < 0 && errno == EINTR);
+        close(report[0]);
+        if (n != (ssize_t)sizeof(status)) {
+            status[0] = 0;
+            status[1] = 0;
+        }
+        result = Py_BuildValue("(Nii)", PyLong_FromPid(pid), status[0],
+                               status[1]);
+    }
+
+  done:
+    PyMem_DEL(argvlist);
+    PyMem_DEL(sh_argvlist);
+    PyMem_DEL(actions);
+    PyMem_DEL(signals);
+    return result;
+}
+#endif
+
 #ifdef HAVE_GETEGID
 PyDoc_STRVAR_remove(posix_getegid__doc__,
 "getegid() -> egid\n\n\
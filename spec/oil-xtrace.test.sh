@@ -510,3 +510,38 @@ one two
 ## STDERR:
 . builtin echo 'one two\n' 'μ'
 ## END
+
+#### profile option without $OIL_PROFILE_FD is a no-op
+shopt --set profile
+echo hi
+shopt -p profile
+shopt --unset profile
+shopt -p profile
+## STDOUT:
+hi
+shopt -s profile
+shopt -u profile
+## END
+
+#### $OIL_PROFILE_FD turns on the profile option and writes chunks
+OIL_PROFILE_FD=9 $SH -c 'shopt -p profile; echo hi; ( true ); f() { true; }; f' \
+  9> $TMP/profile.bin
+head -c 4 $TMP/profile.bin
+echo
+## STDOUT:
+shopt -s profile
+hi
+OILP
+## END
+
+#### profile spans end when a builtin raises, e.g. eval break
+OIL_PROFILE_FD=9 $SH -c 'for i in 1 2; do eval break; done; echo after' \
+  9> $TMP/profile.bin
+python2 $REPO_ROOT/benchmarks/profile_trace.py tsv $TMP/profile.bin \
+  | cut -f 2,3,5,8
+## STDOUT:
+after
+span_id	parent_id	status	name
+0	-1	-1	eval
+1	-1	0	echo
+## END